@@ -1,11 +1,5 @@
 #include "AABB.h"
 
-CAABB::CAABB(const std::vector<Vec2>& inPoints, const Vec2& inPosition, const Mat2& inRotation) : CGLObject(), min(Vec2(FLT_MAX, FLT_MAX)), max(Vec2(-FLT_MAX, -FLT_MAX)), position(inPosition), rotation(inRotation)
-{
-	ComputePoints(inPoints, inRotation);
-	CreateBuffers();
-}
-
 bool CAABB::DoesOverlap(CAABB& testedAABB)
 {
 	Vec2 Amin = min + position;
@@ -28,7 +22,7 @@ bool CAABB::DoesOverlap(CAABB& testedAABB)
 	float Bmax = testedAABB.max.y + testedAABB.position.y;
 	if (Amin <= Bmax && Bmin <= Amax)
 */
-bool CAABB::DoesOtherAxisOverlap(const CAABB& testedAABB)
+bool CAABB::DoesOtherAxisOverlap(const CAABB& testedAABB) const
 {
 	if ((min.y + position.y) <= (testedAABB.max.y + testedAABB.position.y) &&
 		(testedAABB.min.y + testedAABB.position.y) <= (max.y + position.y))
@@ -36,33 +30,7 @@ bool CAABB::DoesOtherAxisOverlap(const CAABB& testedAABB)
 	return false;
 }
 
-void CAABB::Draw()
-{
-	// Set transforms (assuming model view mode is set)
-	float transfMat[16] = { 1.0f, 0.0f, 0.0f, 0.0f,
-							0.0f, 1.0f, 0.0f, 0.0f,
-							0.0f, 0.0f, 1.0f, 1.0f,
-							position.x, position.y, -1.0f, 1.0f };
-	glPushMatrix();
-	glMultMatrixf(transfMat);
-
-	// Draw vertices
-	BindBuffers();
-	if (isOverlaping)
-	{
-		glColor3f(0, 1, 0);
-		isOverlaping = false;
-	}
-	else
-		glColor3f(0, 0, 1);
-	glDrawArrays(GL_LINE_LOOP, 0, points.size());
-	glDisableClientState(GL_VERTEX_ARRAY);
-
-	glPopMatrix();
-	glColor3f(0, 0, 0);
-}
-
-void CAABB::ComputePoints(const std::vector<Vec2>& inPoints, const Mat2& inRotation)
+void CAABB::ApplyRotation(const std::vector<Vec2>& inPoints, const Mat2& inRotation)
 {
 	min = Vec2(FLT_MAX, FLT_MAX);
 	max = Vec2(-FLT_MAX, -FLT_MAX);
@@ -81,12 +49,4 @@ void CAABB::ComputePoints(const std::vector<Vec2>& inPoints, const Mat2& inRotat
 		if (point.y > max.y)
 			max.y = point.y;
 	}
-	points = { Vec2(min.x, min.y), Vec2(min.x, max.y), Vec2(max.x, max.y), Vec2(max.x, min.y) };
-	UpdateBuffers();
 }
-
-void CAABB::ApplyRotation(const std::vector<Vec2>& inPoints, const Mat2& inRotation)
-{
-	rotation = inRotation;
-	ComputePoints(inPoints, rotation);
-}
\ No newline at end of file
@@ -1,35 +1,45 @@
 #ifndef _AABB_H_
 #define _AABB_H_
 
-#include "GLObject.h"
+#include <vector>
 
-class CAABB : public CGLObject
+#include "Maths.h"
+
+// Bounds of a polygon : local extents of the rotated points, translated by position.
+// Plain data, updating it is pure math (debug outlines are generated by the renderer when drawn).
+class CAABB
 {
 private:
 	Vec2 min;
 	Vec2 max;
 
 public:
-	CAABB(const std::vector<Vec2>& points, const Vec2& inPosition, const Mat2& inRotation);
-	~CAABB() = default;
-
 	bool DoesOverlap(CAABB& testedAABB);
-	bool DoesOtherAxisOverlap(const CAABB& testedAABB);
+	bool DoesOtherAxisOverlap(const CAABB& testedAABB) const;
 	void ApplyRotation(const std::vector<Vec2>& inPoints, const Mat2& inRotation);
-	void ComputePoints(const std::vector<Vec2>& inPoints, const Mat2& inRotation);
-	void Draw();
+
 	Vec2 position;
-	Mat2 rotation;
 	bool isOverlaping = false;
 
-	inline const float GetMinX()
+	inline float GetMinX() const
 	{
 		return min.x + position.x;
 	}
 
-	inline const float GetMaxX()
+	inline float GetMaxX() const
 	{
 		return max.x + position.x;
 	}
+
+	// world space corners
+	inline Vec2 GetMin() const
+	{
+		return min + position;
+	}
+
+	inline Vec2 GetMax() const
+	{
+		return max + position;
+	}
 };
-#endif // _AABB_H_
\ No newline at end of file
+#endif // _AABB_H_
@@ -0,0 +1,66 @@
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Replaces global operator new and delete, array and nothrow forms go through these ones.
+// Only built in the headless executable, the windowed application keeps the default ones.
+static std::atomic<size_t> gHeapAllocationCount(0);
+
+size_t	GetHeapAllocationCount()
+{
+	return gHeapAllocationCount.load(std::memory_order_relaxed);
+}
+
+void*	operator new(size_t size)
+{
+	gHeapAllocationCount.fetch_add(1, std::memory_order_relaxed);
+	void* memory = malloc(size ? size : 1);
+	if (!memory)
+	{
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void	operator delete(void* memory) noexcept
+{
+	free(memory);
+}
+
+void	operator delete(void* memory, size_t) noexcept
+{
+	free(memory);
+}
+
+void*	operator new(size_t size, std::align_val_t alignment)
+{
+	gHeapAllocationCount.fetch_add(1, std::memory_order_relaxed);
+	size_t align = (size_t)alignment;
+	size = (size + align - 1) & ~(align - 1);
+#ifdef _MSC_VER
+	void* memory = _aligned_malloc(size ? size : align, align);
+#else
+	void* memory = aligned_alloc(align, size ? size : align);
+#endif
+	if (!memory)
+	{
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void	operator delete(void* memory, std::align_val_t) noexcept
+{
+#ifdef _MSC_VER
+	_aligned_free(memory);
+#else
+	free(memory);
+#endif
+}
+
+void	operator delete(void* memory, size_t, std::align_val_t alignment) noexcept
+{
+	operator delete(memory, alignment);
+}
@@ -0,0 +1,10 @@
+#ifndef _ALLOCATION_COUNTER_H_
+#define _ALLOCATION_COUNTER_H_
+
+#include <cstddef>
+
+// Number of heap allocations (global operator new, aligned forms included) since program start, all threads.
+// Used to check that stepping the simulation doesn't allocate once warmed up.
+size_t	GetHeapAllocationCount();
+
+#endif
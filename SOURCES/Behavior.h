@@ -1,8 +1,12 @@
 #ifndef _BEHAVIOR_H_
 #define _BEHAVIOR_H_
 
+#include <memory>
+
 #include "Polygon.h"
 
+class CWarmStartCache;
+
 class CBehavior
 {
 protected:
@@ -13,10 +17,15 @@ protected:
 public:
 	virtual ~CBehavior() = default;
 
-	CPolygonPtr poly;
+	CPolygonPtr poly = nullptr;
 
 	virtual void Start(){}
 	virtual void Update(float frameTime){}
+	// Called once per rendered frame after polygons, alpha is the interpolation factor between simulation steps
+	virtual void Render(float alpha){}
+
+	// Contacts kept from one step to the next, saved in world snapshots
+	virtual CWarmStartCache* GetWarmStartCache() { return nullptr; }
 
 private:
 	size_t	m_index = 0;
@@ -4,169 +4,342 @@
 #include "Behavior.h"
 #include "PhysicEngine.h"
 #include "GlobalVariables.h"
-#include "Renderer.h"
+#include "IRenderer.h"
 #include "World.h"
+#include "RenderWindow.h"
+#include "ContactSolverWide.h"
+#include "ConstraintColoring.h"
+#include "WarmStartCache.h"
+#include "Profiler.h"
+#include "Timer.h"
+
+#include <string>
+
+#define SOLVER_BENCHMARK_ITERATIONS 200
 
 class CCollisionResponse : public CBehavior
 {
 private:
 	size_t	nbVelocityIteration = 6;
 	size_t	nbPositionIteration = 1;
-	std::vector<SCollision> lastFrameCollidingPairs = std::vector<SCollision>();
+	CWarmStartCache	m_warmStartCache;
 	Vec2 gravity = Vec2(0, -9.8f);
 
+	CConstraintColoring	m_coloring;
+
+	// Velocity solver path, F6 to cycle between supported paths, F7 (or RequestSolverBenchmark) to benchmark them
+	ESolverPath		m_solverPath = IsAVX2Supported() ? ESolverPath::AVX8 : ESolverPath::SSE4;
+	std::string		m_benchmarkResult;
+	size_t			m_benchmarkContactCount = 0;
+	bool			m_benchmarkRequested = false;
+
+public:
+	// Benchmarks the solver paths on the contacts of the next update, result is empty if it had no contacts
+	void				RequestSolverBenchmark()				{ m_benchmarkRequested = true; m_benchmarkResult.clear(); m_benchmarkContactCount = 0; }
+	const std::string&	GetSolverBenchmarkResult() const		{ return m_benchmarkResult; }
+	size_t				GetSolverBenchmarkContactCount() const	{ return m_benchmarkContactCount; }
+
+private:
+
+	virtual CWarmStartCache* GetWarmStartCache() override { return &m_warmStartCache; }
+
 	virtual void Update(float frameTime) override
 	{
+		if (gVars->pRenderWindow->JustPressedStepKey(Key::F6))
+		{
+			do
+			{
+				m_solverPath = (ESolverPath)(((int)m_solverPath + 1) % (int)ESolverPath::Count);
+			} while (!IsSolverPathSupported(m_solverPath));
+		}
+
 		if (gVars->bToggleCollision)
 		{
+			PROFILE_ZONE("CollisionResponse");
 			PreSolve();
+			m_coloring.Build(gVars->pPhysicEngine->GetCollisions(), gVars->pWorld->GetBodies().masses);
 			WarmStart();
+			if (gVars->pRenderWindow->JustPressedStepKey(Key::F7) || m_benchmarkRequested)
+			{
+				RunSolverBenchmark();
+				m_benchmarkRequested = false;
+			}
 			for (size_t i = 0; i < nbVelocityIteration; i++)
 			{
 				SolveVelocity();
 			}
-			gVars->pWorld->ForEachPolygon([&](CPolygonPtr poly)
-			{
-				if (poly->density == 0.0f)
-					return;
-				if (gVars->bToggleGravity)
-					poly->speed += gravity * frameTime;
-
-				poly->rotation.Rotate(RAD2DEG(poly->angularVelocity * frameTime));
-				poly->SetRotation(poly->rotation);
-				poly->AddPosition(poly->speed * frameTime);
-			});
+			PROFILE_COUNTER(SolverIterations, nbVelocityIteration + nbPositionIteration);
+			DrawDebug();
+			Integrate(frameTime);
 			for (size_t i = 0; i < nbPositionIteration; i++)
 			{
 				SolvePosition();
 			}
+			UpdateSolvedBounds();
 			PostSolve();
+
+			if (gVars->bDebug && gVars->pRenderer->IsDisplayingTexts())
+			{
+				gVars->pRenderer->DisplayText(std::string("Velocity solver : ") + GetSolverPathName(m_solverPath) + " (F6: change, F7: benchmark) " + m_benchmarkResult);
+				gVars->pRenderer->DisplayText("Solver colors : " + std::to_string(m_coloring.GetColorCount()) + ", uncolored constraints : " + std::to_string(m_coloring.GetUncoloredBatch().size()));
+			}
 		}
 
 	}
 
+	// Bodies of the store are integrated in order, static ones (no mass) don't move
+	inline void Integrate(float frameTime)
+	{
+		CBodyStore& bodies = gVars->pWorld->GetBodies();
+		const std::vector<CPolygonPtr>& polygons = gVars->pWorld->GetPolygons();
+		for (size_t i = 0; i < bodies.GetCount(); ++i)
+		{
+			if (bodies.masses[i] == 0.0f)
+				continue;
+			if (gVars->bToggleGravity)
+				bodies.speeds[i] += gravity * frameTime;
+
+			bodies.rotations[i].Rotate(RAD2DEG(bodies.angularVelocities[i] * frameTime));
+			bodies.bounds[i].ApplyRotation(polygons[i]->GetPoints(), bodies.rotations[i]);
+
+			Vec2 move = bodies.speeds[i] * frameTime;
+			bodies.positions[i] += move;
+			bodies.bounds[i].position += move;
+		}
+	}
+
 	inline void PreSolve()
 	{
+		m_warmStartCache.NewFrame(gVars->pPhysicEngine->GetCollisions().size());
+
+		const CBodyStore& bodies = gVars->pWorld->GetBodies();
 		gVars->pPhysicEngine->ForEachCollision([&](SCollision& collision)
 		{
-			collision.lastCollisionPoint = Vec2(0.0f, 0.0f);
 			collision.lastNormalImpulse = 0.0f;
 			collision.lastTangentImpulse = 0.0f;
-			for (const SCollision& lastPair : lastFrameCollidingPairs)
-			{
-				if (collision.index == lastPair.index)
-				{
-					collision.lastCollisionPoint = lastPair.point;
-					collision.lastNormalImpulse = lastPair.lastNormalImpulse;
-					collision.lastTangentImpulse = lastPair.lastTangentImpulse;
-					break;
-				}
-			}
+			m_warmStartCache.Find(GetWarmStartKey(collision), collision.lastNormalImpulse, collision.lastTangentImpulse);
 
-			Vec2 rAi = collision.point - collision.polyA->position;
-			Vec2 rBi = collision.point - collision.polyB->position;
+			Vec2 rAi = collision.point - bodies.positions[collision.GetBodyA()];
+			Vec2 rBi = collision.point - bodies.positions[collision.GetBodyB()];
 
 			collision.baseSeparation = collision.distance + rAi.GetLength() + rBi.GetLength();
+			collision.restitution = collision.polyA->bounciness * collision.polyB->bounciness;
+			collision.friction = Min(collision.polyA->friction, collision.polyB->friction);
+		});
+	}
+
+	// Solver uses a single point per collision, the first manifold feature identifies it.
+	// Bodies are identified by handle, dense indices change when bodies are removed.
+	inline uint64_t GetWarmStartKey(const SCollision& collision) const
+	{
+		size_t featureId = (collision.manifoldSize > 0) ? collision.manifold[0].index : CWarmStartCache::NoFeature;
+		return CWarmStartCache::MakeKey(collision.polyA->GetHandle().value, collision.polyB->GetHandle().value, featureId);
+	}
+
+	template<typename TFunctor>
+	inline void ForEachColoredCollision(TFunctor functor)
+	{
+		std::vector<SCollision>& collisions = gVars->pPhysicEngine->GetCollisions();
+		m_coloring.ForEach(gVars->pPhysicEngine->GetJobSystem(), [&](size_t index)
+		{
+			functor(collisions[index]);
 		});
-		lastFrameCollidingPairs.clear();
 	}
 
 	inline void WarmStart()
 	{
+		CBodyStore& bodies = gVars->pWorld->GetBodies();
 		gVars->pPhysicEngine->ForEachCollision([&](const SCollision& collision)
 		{
-			if (collision.lastCollisionPoint.IsZero() || collision.lastNormalImpulse <= 0.0f || collision.lastTangentImpulse <= 0.0f)
+			if (collision.lastNormalImpulse <= 0.0f || collision.lastTangentImpulse <= 0.0f)
 				return;
 
 			Vec2 normalImpulse = collision.normal * collision.lastNormalImpulse;
 			Vec2 tangentImpulse = collision.tangent * collision.lastTangentImpulse * 0.2f;
 			Vec2 impulse = normalImpulse + tangentImpulse;
 
-			ApplyImpulse(collision.polyA, collision.point, impulse.Normalized(), impulse.GetLength());
+			ApplyImpulse(bodies, collision.GetBodyA(), collision.point, impulse.Normalized(), impulse.GetLength());
 		});
 	}
 
 	inline void SolveVelocity()
 	{
-		gVars->pPhysicEngine->ForEachCollision([&](SCollision& collision)
+		switch (m_solverPath)
 		{
-			if (collision.polyA->GetMass() == 0 && collision.polyB->GetMass() == 0)
-				return;
+#ifdef SIMD_AVX2
+		case ESolverPath::AVX8:
+			SolveVelocityLanes<SFloat8>();
+			break;
+#endif
+		case ESolverPath::SSE4:
+			SolveVelocityLanes<SFloat4>();
+			break;
+		default:
+			ForEachColoredCollision([&](SCollision& collision)
+			{
+				SolveVelocityConstraint(collision);
+			});
+			break;
+		}
+	}
+
+	// Each color batch is split in groups of TFloat::Width contacts solved at once
+	template<typename TFloat>
+	inline void SolveVelocityLanes()
+	{
+		std::vector<SCollision>& collisions = gVars->pPhysicEngine->GetCollisions();
+		CBodyStore& bodies = gVars->pWorld->GetBodies();
+		CJobSystem& jobSystem = gVars->pPhysicEngine->GetJobSystem();
+		const size_t width = TFloat::Width;
+
+		for (size_t color = 0; color < m_coloring.GetColorCount(); ++color)
+		{
+			const std::vector<size_t>& batch = m_coloring.GetBatch(color);
+			size_t groupCount = (batch.size() + width - 1) / width;
+			jobSystem.ParallelFor(groupCount, CONSTRAINT_GRAIN_SIZE / width, [&](size_t begin, size_t end)
+			{
+				for (size_t group = begin; group < end; ++group)
+				{
+					size_t first = group * width;
+					SolveVelocityGroup<TFloat>(bodies, collisions, batch.data() + first, Min(width, batch.size() - first));
+				}
+			});
+		}
 
-			float restitution = collision.polyA->bounciness * collision.polyB->bounciness;
-			float friction = Min(collision.polyA->friction, collision.polyB->friction);
+		for (size_t index : m_coloring.GetUncoloredBatch())
+		{
+			SolveVelocityConstraint(collisions[index]);
+		}
+	}
 
-			Vec2 relativeVelocity = collision.polyB->speed - collision.polyA->speed;
+	// Runs the velocity iterations of every supported path on the current contacts, state is restored after each run
+	inline void RunSolverBenchmark()
+	{
+		std::vector<SCollision>& collisions = gVars->pPhysicEngine->GetCollisions();
+		if (collisions.empty())
+			return;
 
-			collision.tangent = relativeVelocity - collision.normal;
+		CBodyStore& bodies = gVars->pWorld->GetBodies();
+		std::vector<SCollision> savedCollisions = collisions;
+		std::vector<Vec2> savedSpeeds = bodies.speeds;
+		std::vector<float> savedAngularVelocities = bodies.angularVelocities;
 
-			//Tangent Impulse:
-			float tangentRelVel = ((relativeVelocity * -1.0f)| collision.tangent);
+		ESolverPath currentPath = m_solverPath;
+		m_benchmarkResult.clear();
+		m_benchmarkContactCount = collisions.size();
 
-			collision.tangentMass = (collision.polyA->GetMass() + collision.polyB->GetMass());
-			float tangentImpulseDelta = tangentRelVel / collision.tangentMass;
-			float absMaxFriction = abs(collision.lastNormalImpulse) * friction;
-			float newImpulse = Clamp(collision.lastTangentImpulse + tangentImpulseDelta, -absMaxFriction, absMaxFriction);
-			tangentImpulseDelta = newImpulse - collision.lastTangentImpulse;
-			collision.lastTangentImpulse = newImpulse;
-			if (collision.polyA->GetMass() != 0)
-				ApplyImpulse(collision.polyA, collision.point, collision.tangent, -tangentImpulseDelta);
-			if (collision.polyB->GetMass() != 0)
-				ApplyImpulse(collision.polyB, collision.point, collision.tangent, tangentImpulseDelta);
+		for (int path = 0; path < (int)ESolverPath::Count; ++path)
+		{
+			m_solverPath = (ESolverPath)path;
+			if (!IsSolverPathSupported(m_solverPath))
+				continue;
 
-			float invMassA = collision.polyA->GetMass();
-			float invMassB = collision.polyB->GetMass();
+			CTimer timer;
+			timer.Start();
+			for (size_t i = 0; i < SOLVER_BENCHMARK_ITERATIONS; ++i)
+			{
+				SolveVelocity();
+			}
+			timer.Stop();
 
-			Vec2 rAi = collision.point - collision.polyA->position;
-			Vec2 rBi = collision.point - collision.polyB->position;
+			float contactsPerSecond = (float)(collisions.size() * SOLVER_BENCHMARK_ITERATIONS) / Max(timer.GetDuration(), FLT_MIN);
+			m_benchmarkResult += std::string(GetSolverPathName(m_solverPath)) + " : " + std::to_string((int)(contactsPerSecond / 1000.0f)) + "k contacts/s ";
 
-			float momentumA = (rAi ^ collision.normal);
-			float momentumB = (rBi ^ collision.normal);
+			collisions = savedCollisions;
+			bodies.speeds = savedSpeeds;
+			bodies.angularVelocities = savedAngularVelocities;
+		}
 
-			float normalWeightedRotA = Vec2::Cross(momentumA, rAi) | collision.normal;
-			float normalWeightedRotB = Vec2::Cross(momentumB, rBi) | collision.normal;
+		m_solverPath = currentPath;
+	}
 
-			collision.normalMass = (invMassA + invMassB + normalWeightedRotA + normalWeightedRotB);
+	inline void SolveVelocityConstraint(SCollision& collision)
+	{
+		CBodyStore& bodies = gVars->pWorld->GetBodies();
+		size_t bodyA = collision.GetBodyA();
+		size_t bodyB = collision.GetBodyB();
+		float invMassA = bodies.masses[bodyA];
+		float invMassB = bodies.masses[bodyB];
 
-			relativeVelocity = getRelativeVelocity(collision);
-			float normalRelVel = (relativeVelocity | collision.normal);
-			float normalImpulseDelta = (-1.0f * (restitution + 1.0f) * normalRelVel) / collision.normalMass;
-			float newNormalImpulse = Max(collision.lastNormalImpulse + normalImpulseDelta, 0.0f);
-			normalImpulseDelta = newNormalImpulse - collision.lastNormalImpulse;
-			collision.lastNormalImpulse = newNormalImpulse;
+		if (invMassA == 0 && invMassB == 0)
+			return;
 
-			if (collision.polyA->GetMass() != 0)
-				ApplyImpulse(collision.polyA, collision.point, collision.normal, normalImpulseDelta * -1.0f);
-			if (collision.polyB->GetMass() != 0)
-				ApplyImpulse(collision.polyB, collision.point, collision.normal, normalImpulseDelta);
+		Vec2 relativeVelocity = bodies.speeds[bodyB] - bodies.speeds[bodyA];
 
-			if (gVars->bDebugElem && gVars->bToggleEPADebug)
-			{
-				gVars->pRenderer->DisplayTextWorld("ptA", collision.polyA->position + collision.normal * collision.distance);
-				gVars->pRenderer->DrawLine(collision.polyA->position, collision.polyA->position + collision.normal * collision.distance, 1.0f, 0.0f, 1.0f);
+		collision.tangent = relativeVelocity - collision.normal;
 
-				gVars->pRenderer->DisplayTextWorld("ptB", collision.polyB->position - collision.normal * collision.distance);
-				gVars->pRenderer->DrawLine(collision.polyB->position, collision.polyB->position - collision.normal * collision.distance, 1.0f, 0.0f, 1.0f);
+		//Tangent Impulse:
+		float tangentRelVel = ((relativeVelocity * -1.0f)| collision.tangent);
 
-				gVars->pRenderer->DisplayText("Collision distance : " + std::to_string(collision.distance), 50, 50);
+		collision.tangentMass = (invMassA + invMassB);
+		float tangentImpulseDelta = tangentRelVel / collision.tangentMass;
+		float absMaxFriction = abs(collision.lastNormalImpulse) * collision.friction;
+		float newImpulse = Clamp(collision.lastTangentImpulse + tangentImpulseDelta, -absMaxFriction, absMaxFriction);
+		tangentImpulseDelta = newImpulse - collision.lastTangentImpulse;
+		collision.lastTangentImpulse = newImpulse;
+		if (invMassA != 0)
+			ApplyImpulse(bodies, bodyA, collision.point, collision.tangent, -tangentImpulseDelta);
+		if (invMassB != 0)
+			ApplyImpulse(bodies, bodyB, collision.point, collision.tangent, tangentImpulseDelta);
 
-				gVars->pRenderer->DisplayTextWorld("pt", collision.point);
-				gVars->pRenderer->DrawLine(collision.point, collision.point - collision.normal * (collision.distance - EPSILON), 1.0f, 0.0f, 1.0f);
-			}
+		Vec2 rAi = collision.point - bodies.positions[bodyA];
+		Vec2 rBi = collision.point - bodies.positions[bodyB];
+
+		float momentumA = (rAi ^ collision.normal);
+		float momentumB = (rBi ^ collision.normal);
+
+		float normalWeightedRotA = Vec2::Cross(momentumA, rAi) | collision.normal;
+		float normalWeightedRotB = Vec2::Cross(momentumB, rBi) | collision.normal;
+
+		collision.normalMass = (invMassA + invMassB + normalWeightedRotA + normalWeightedRotB);
+
+		relativeVelocity = getRelativeVelocity(bodies, collision);
+		float normalRelVel = (relativeVelocity | collision.normal);
+		float normalImpulseDelta = (-1.0f * (collision.restitution + 1.0f) * normalRelVel) / collision.normalMass;
+		float newNormalImpulse = Max(collision.lastNormalImpulse + normalImpulseDelta, 0.0f);
+		normalImpulseDelta = newNormalImpulse - collision.lastNormalImpulse;
+		collision.lastNormalImpulse = newNormalImpulse;
+
+		if (invMassA != 0)
+			ApplyImpulse(bodies, bodyA, collision.point, collision.normal, normalImpulseDelta * -1.0f);
+		if (invMassB != 0)
+			ApplyImpulse(bodies, bodyB, collision.point, collision.normal, normalImpulseDelta);
+	}
+
+	inline void DrawDebug()
+	{
+		if (!gVars->bDebugElem || !gVars->bToggleEPADebug)
+			return;
+
+		gVars->pPhysicEngine->ForEachCollision([&](const SCollision& collision)
+		{
+			gVars->pRenderer->DisplayTextWorld("ptA", collision.polyA->GetPosition() + collision.normal * collision.distance);
+			gVars->pRenderer->DrawLine(collision.polyA->GetPosition(), collision.polyA->GetPosition() + collision.normal * collision.distance, 1.0f, 0.0f, 1.0f);
+
+			gVars->pRenderer->DisplayTextWorld("ptB", collision.polyB->GetPosition() - collision.normal * collision.distance);
+			gVars->pRenderer->DrawLine(collision.polyB->GetPosition(), collision.polyB->GetPosition() - collision.normal * collision.distance, 1.0f, 0.0f, 1.0f);
+
+			gVars->pRenderer->DisplayText("Collision distance : " + std::to_string(collision.distance), 50, 50);
+
+			gVars->pRenderer->DisplayTextWorld("pt", collision.point);
+			gVars->pRenderer->DrawLine(collision.point, collision.point - collision.normal * (collision.distance - EPSILON), 1.0f, 0.0f, 1.0f);
 		});
 	}
 
 	inline void SolvePosition()
 	{
-		gVars->pPhysicEngine->ForEachCollision([&](SCollision& collision)
+		CBodyStore& bodies = gVars->pWorld->GetBodies();
+		ForEachColoredCollision([&](SCollision& collision)
 		{
-			if (collision.polyA->GetMass() == 0 && collision.polyB->GetMass() == 0)
+			size_t bodyA = collision.GetBodyA();
+			size_t bodyB = collision.GetBodyB();
+			float invMassA = bodies.masses[bodyA];
+			float invMassB = bodies.masses[bodyB];
+			if (invMassA == 0 && invMassB == 0)
 				return;
-			float invMassA = collision.polyA->GetMass();
-			float invMassB = collision.polyB->GetMass();
 
-			Vec2 rAi = collision.point - collision.polyA->position;
-			Vec2 rBi = collision.point - collision.polyB->position;
+			Vec2 rAi = collision.point - bodies.positions[bodyA];
+			Vec2 rBi = collision.point - bodies.positions[bodyB];
 
 			float distance = collision.baseSeparation - (rAi.GetLength() + rBi.GetLength());
 
@@ -177,58 +350,66 @@ private:
 			float separation = -1.0f * distance;
 			float steeringForce = Clamp(damping * (separation + tolerance), maxCorrection, 0.0f);
 			Vec2 correction = collision.normal * ((-steeringForce) / (invMassA + invMassB));
-			if (collision.polyA->GetMass() != 0)
+			if (invMassA != 0)
 			{
-				collision.polyA->AddPosition(correction * invMassA * -1.0f);
-				collision.polyA->rotation.Rotate((rAi ^ correction) * -1.0f);
-				collision.polyA->SetRotation(collision.polyA->rotation);
-
+				Vec2 move = correction * invMassA * -1.0f;
+				bodies.positions[bodyA] += move;
+				bodies.bounds[bodyA].position += move;
+				bodies.rotations[bodyA].Rotate((rAi ^ correction) * -1.0f);
 			}
 
-			if (collision.polyB->GetMass() != 0)
+			if (invMassB != 0)
 			{
-				collision.polyB->AddPosition(correction * invMassB);
-				collision.polyB->rotation.Rotate(rBi ^ correction);
-				collision.polyB->SetRotation(collision.polyB->rotation);
+				Vec2 move = correction * invMassB;
+				bodies.positions[bodyB] += move;
+				bodies.bounds[bodyB].position += move;
+				bodies.rotations[bodyB].Rotate(rBi ^ correction);
 			}
 		});
 	}
 
-	inline void PostSolve()
+	// Position solving only rotates bodies, bounds of solved bodies are updated once afterward
+	inline void UpdateSolvedBounds()
 	{
-		gVars->pPhysicEngine->ForEachCollision([&](SCollision& collision)
+		CBodyStore& bodies = gVars->pWorld->GetBodies();
+		const std::vector<CPolygonPtr>& polygons = gVars->pWorld->GetPolygons();
+		for (size_t i = 0; i < bodies.GetCount(); ++i)
 		{
-			lastFrameCollidingPairs.push_back(collision);
-		});
+			if (m_coloring.IsBodyColored(i))
+			{
+				bodies.bounds[i].ApplyRotation(polygons[i]->GetPoints(), bodies.rotations[i]);
+			}
+		}
 	}
 
-	inline void ApplyImpulse(CPolygonPtr object, Vec2 collisionPoint, Vec2 impulse)
+	inline void PostSolve()
 	{
-		if (object->GetMass() <= 0)
-			return;
-
-		Vec2 rAi = collisionPoint - object->position;
-		object->speed += impulse * object->GetMass();
-		object->angularVelocity += rAi ^ impulse;
+		gVars->pPhysicEngine->ForEachCollision([&](const SCollision& collision)
+		{
+			m_warmStartCache.Store(GetWarmStartKey(collision), collision.lastNormalImpulse, collision.lastTangentImpulse);
+		});
 	}
 
-	inline void ApplyImpulse(CPolygonPtr object, Vec2 collisionPoint, Vec2 axis, float impulse)
+	inline void ApplyImpulse(CBodyStore& bodies, size_t body, Vec2 collisionPoint, Vec2 axis, float impulse)
 	{
-		if (object->GetMass() <= 0)
+		float invMass = bodies.masses[body];
+		if (invMass <= 0)
 			return;
 
-		Vec2 rAi = collisionPoint - object->position;
-		object->speed += axis * impulse * object->GetMass();
-		object->angularVelocity += impulse * (rAi ^ axis);
+		Vec2 rAi = collisionPoint - bodies.positions[body];
+		bodies.speeds[body] += axis * impulse * invMass;
+		bodies.angularVelocities[body] += impulse * (rAi ^ axis);
 	}
 
-	inline Vec2 getRelativeVelocity(SCollision& collision)
+	inline Vec2 getRelativeVelocity(const CBodyStore& bodies, const SCollision& collision)
 	{
-		Vec2 rAi = collision.point - collision.polyA->position;
-		Vec2 rBi = collision.point - collision.polyB->position;
+		size_t bodyA = collision.GetBodyA();
+		size_t bodyB = collision.GetBodyB();
+		Vec2 rAi = collision.point - bodies.positions[bodyA];
+		Vec2 rBi = collision.point - bodies.positions[bodyB];
 
-		Vec2 velA = collision.polyA->speed + Vec2::Cross(collision.polyA->angularVelocity, rAi);
-		Vec2 velB = collision.polyB->speed + Vec2::Cross(collision.polyB->angularVelocity, rBi);
+		Vec2 velA = bodies.speeds[bodyA] + Vec2::Cross(bodies.angularVelocities[bodyA], rAi);
+		Vec2 velB = bodies.speeds[bodyB] + Vec2::Cross(bodies.angularVelocities[bodyB], rBi);
 		return (velB - velA);
 	}
 };
@@ -4,7 +4,7 @@
 #include "../Behavior.h"
 #include "../PhysicEngine.h"
 #include "../GlobalVariables.h"
-#include "../Renderer.h"
+#include "../IRenderer.h"
 #include "../RenderWindow.h"
 #include "../World.h"
 
@@ -14,8 +14,8 @@
 class CDisplayCollision : public CBehavior
 {
 public:
-	CPolygonPtr polyA;
-	CPolygonPtr polyB;
+	CPolygonPtr polyA = nullptr;
+	CPolygonPtr polyB = nullptr;
 
 private:
 	virtual void Update(float frameTime) override
@@ -31,11 +31,12 @@ private:
 
 		if (gVars->bDebugElem)
 		{
-			std::vector<Vec2> outResult;
+			TFrameVector<Vec2> outResult(gVars->pPhysicEngine->GetFrameArena());
 			Vec2 otherResult = Vec2();
 			if (polyA->CheckCollisionDebug(*polyB, collisionInfo, otherResult, outResult))
 			{
-				gVars->pRenderer->DisplayText("Collision distance : " + std::to_string(collisionInfo.distance), 50, 50);
+				if (gVars->pRenderer->IsDisplayingTexts())
+					gVars->pRenderer->DisplayText("Collision distance : " + std::to_string(collisionInfo.distance), 50, 50);
 				
 				if (gVars->bToggleEPADebug)
 				{
@@ -88,11 +89,12 @@ private:
 		}
 		else if (polyA->CheckCollision(*polyB, collisionInfo))
 		{
-			gVars->pRenderer->DisplayText("Collision distance : " + std::to_string(collisionInfo.distance), 50, 50);
+			if (gVars->pRenderer->IsDisplayingTexts())
+				gVars->pRenderer->DisplayText("Collision distance : " + std::to_string(collisionInfo.distance), 50, 50);
 
 			gVars->pRenderer->DisplayTextWorld("pt", collisionInfo.point);
-			gVars->pRenderer->DisplayTextWorld("A", collisionInfo.polyA->position);
-			gVars->pRenderer->DisplayTextWorld("B", collisionInfo.polyB->position);
+			gVars->pRenderer->DisplayTextWorld("A", collisionInfo.polyA->GetPosition());
+			gVars->pRenderer->DisplayTextWorld("B", collisionInfo.polyB->GetPosition());
 			gVars->pRenderer->DrawLine(collisionInfo.point, collisionInfo.point + collisionInfo.normal * (collisionInfo.distance - EPSILON), 1.0f, 0.0f, 1.0f);
 		}
 	}
@@ -4,7 +4,7 @@
 #include "Behavior.h"
 #include "PhysicEngine.h"
 #include "GlobalVariables.h"
-#include "Renderer.h"
+#include "IRenderer.h"
 #include "RenderWindow.h"
 #include "World.h"
 
@@ -14,8 +14,8 @@
 class CDisplayManifold : public CBehavior
 {
 public:
-	CPolygonPtr polyA;
-	CPolygonPtr polyB;
+	CPolygonPtr polyA = nullptr;
+	CPolygonPtr polyB = nullptr;
 
 private:
 	virtual void Update(float frameTime) override
@@ -25,8 +25,8 @@ private:
 		//DrawCollisionPolygon(polyA);
 		//DrawCollisionPolygon(polyB);
 
-		gVars->pRenderer->DisplayTextWorld("A", polyA->position);
-		gVars->pRenderer->DisplayTextWorld("B", polyB->position);
+		gVars->pRenderer->DisplayTextWorld("A", polyA->GetPosition());
+		gVars->pRenderer->DisplayTextWorld("B", polyB->GetPosition());
 
 		Vec2 dir = Vec2(-1.0f, -0.5f).Normalized();
 		float dist = 100.0f;
@@ -58,10 +58,11 @@ private:
 
 	void DrawCollisionPolygon(CPolygonPtr poly)
 	{
-		for (size_t i = 0; i < poly->points.size(); ++i)
+		const std::vector<Vec2>& points = poly->GetPoints();
+		for (size_t i = 0; i < points.size(); ++i)
 		{
-			Vec2 pointA = poly->TransformPoint(poly->points[i] * 0.6f);
-			Vec2 pointB = poly->TransformPoint(poly->points[(i + 1) % poly->points.size()] * 0.6f);
+			Vec2 pointA = poly->TransformPoint(points[i] * 0.6f);
+			Vec2 pointB = poly->TransformPoint(points[(i + 1) % points.size()] * 0.6f);
 
 			gVars->pRenderer->DrawLine(pointA, pointB, 0, 1, 0);
 		}
@@ -69,10 +70,11 @@ private:
 
 	void DrawGhostPolygon(CPolygonPtr poly, Vec2 offset)
 	{
-		for (size_t i = 0; i < poly->points.size(); ++i)
+		const std::vector<Vec2>& points = poly->GetPoints();
+		for (size_t i = 0; i < points.size(); ++i)
 		{
-			Vec2 pointA = poly->TransformPoint(poly->points[i]) + offset;
-			Vec2 pointB = poly->TransformPoint(poly->points[(i + 1) % poly->points.size()]) + offset;
+			Vec2 pointA = poly->TransformPoint(points[i]) + offset;
+			Vec2 pointB = poly->TransformPoint(points[(i + 1) % points.size()]) + offset;
 
 			gVars->pRenderer->DrawLine(pointA, pointB, 0, 1, 0);
 		}
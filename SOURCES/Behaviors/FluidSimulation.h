@@ -4,7 +4,7 @@
 #include "Behavior.h"
 #include "PhysicEngine.h"
 #include "GlobalVariables.h"
-#include "Renderer.h"
+#include "IRenderer.h"
 #include "World.h"
 
 #define RADIUS 0.9f //2.0f
@@ -109,9 +109,9 @@ private:
 
 
 		CPolygonPtr poly = gVars->pWorld->AddSymetricPolygon(radius, 3); // 5);
-		poly->density = 0.0f;
-		poly->position = pos;
-		poly->speed = circle.speed;
+		poly->SetDensity(0.0f);
+		poly->SetPosition(pos);
+		poly->SetSpeed(circle.speed);
 
 		m_poly.push_back(poly);
 		m_circles.push_back(circle);
@@ -125,8 +125,8 @@ private:
 			CPolygonPtr poly = m_poly[i];
 			SCircle& circle = m_circles[i];
 
-			poly->position = circle.pos;
-			poly->speed = circle.speed;
+			poly->SetPosition(circle.pos);
+			poly->SetSpeed(circle.speed);
 		}
 	}
 
@@ -0,0 +1,50 @@
+#ifndef _FLUID_SYSTEM_UPDATE_H_
+#define _FLUID_SYSTEM_UPDATE_H_
+
+#include "Behavior.h"
+#include "FluidSystem.h"
+#include "GlobalVariables.h"
+#include "IRenderer.h"
+#include "RenderWindow.h"
+
+#include <string>
+
+// Steps and draws CFluidSystem within the world, fluid particles are coupled with world polygons.
+// Simulation doesn't know about rendering : particles are handed to the renderer here.
+class CFluidSystemUpdate : public CBehavior
+{
+private:
+	virtual void Update(float frameTime) override
+	{
+		CFluidSystem& fluid = CFluidSystem::Get();
+		if (gVars->pRenderWindow->JustPressedStepKey(Key::F9))
+		{
+			fluid.SetSolver((EFluidSolver)(((int)fluid.GetSolver() + 1) % (int)EFluidSolver::Count));
+		}
+
+		fluid.Update(frameTime);
+
+		if (!gVars->pRenderer->IsDisplayingTexts())
+			return;
+
+		const SFluidStepStats& stats = fluid.GetStepStats();
+		gVars->pRenderer->DisplayText("Particules : " + std::to_string(fluid.GetParticleCount()) + " / " + std::to_string(fluid.GetCapacity()) + ", solver : " + GetFluidSolverName(fluid.GetSolver()) + " (F9: change)");
+		gVars->pRenderer->DisplayText("Fluid substeps : " + std::to_string(stats.subStepCount)
+			+ ", dt : " + std::to_string(stats.minTimeStep * 1000.0f) + " - " + std::to_string(stats.maxTimeStep * 1000.0f) + " ms");
+
+		std::string stageText = "Fluid stages :";
+		for (int stage = 0; stage < (int)EFluidStage::Count; ++stage)
+		{
+			stageText += std::string(" ") + GetFluidStageName((EFluidStage)stage) + " " + std::to_string(stats.stageTimes[stage] * 1000.0f) + " ms";
+		}
+		gVars->pRenderer->DisplayText(stageText);
+	}
+
+	virtual void Render(float alpha) override
+	{
+		const std::vector<Vec2>& positions = CFluidSystem::Get().GetPositions();
+		gVars->pRenderer->DrawPoints(positions.data(), positions.size(), 0.0f, 0.0f, 1.0f);
+	}
+};
+
+#endif
@@ -4,7 +4,7 @@
 #include "Behavior.h"
 #include "PhysicEngine.h"
 #include "GlobalVariables.h"
-#include "Renderer.h"
+#include "IRenderer.h"
 #include "RenderWindow.h"
 #include "World.h"
 
@@ -14,7 +14,7 @@ class CPolygonMoverTool : public CBehavior
 	{
 		Vec2 pt, n;
 		Vec2 mousePoint = gVars->pRenderer->ScreenToWorldPos(gVars->pRenderWindow->GetMousePos());
-		CPolygonPtr clickedPoly;
+		CPolygonPtr clickedPoly = nullptr;
 
 		gVars->pWorld->ForEachPolygon([&](CPolygonPtr poly)
 		{
@@ -31,15 +31,20 @@ class CPolygonMoverTool : public CBehavior
 	{
 		if (gVars->pRenderWindow->GetMouseButton(0) || gVars->pRenderWindow->GetMouseButton(2))
 		{
-			if (!m_selectedPoly)
+			// selection is kept as a handle : the polygon may be removed while dragged
+			CPolygonPtr selectedPoly = gVars->pWorld->GetPolygon(m_selectedBody);
+			if (!selectedPoly)
 			{
-				m_selectedPoly = GetClickedPolygon();
+				selectedPoly = GetClickedPolygon();
 				m_prevMousePos = gVars->pRenderer->ScreenToWorldPos(gVars->pRenderWindow->GetMousePos());
 				m_translate = gVars->pRenderWindow->GetMouseButton(0);
 				m_clickMousePos = m_prevMousePos;
 
-				if (m_selectedPoly)
-					m_clickAngle = m_selectedPoly->rotation.GetAngle();
+				if (selectedPoly)
+				{
+					m_selectedBody = selectedPoly->GetHandle();
+					m_clickAngle = selectedPoly->GetRotation().GetAngle();
+				}
 			}
 			else
 			{
@@ -47,21 +52,22 @@ class CPolygonMoverTool : public CBehavior
 
 				if (m_translate)
 				{
-					m_selectedPoly->AddPosition(mousePoint - m_prevMousePos);
+					selectedPoly->AddPosition(mousePoint - m_prevMousePos);
 
-					m_selectedPoly->angularVelocity = 0.0f;
-					m_selectedPoly->speed = Vec2();
+					selectedPoly->SetAngularVelocity(0.0f);
+					selectedPoly->SetSpeed(Vec2());
 				}
 				else
 				{
-					Vec2 from = m_clickMousePos - m_selectedPoly->position;
-					Vec2 to = mousePoint - m_selectedPoly->position;
+					Vec2 from = m_clickMousePos - selectedPoly->GetPosition();
+					Vec2 to = mousePoint - selectedPoly->GetPosition();
 
-					m_selectedPoly->rotation.SetAngle(m_clickAngle + from.Angle(to));
-					m_selectedPoly->SetRotation(m_selectedPoly->rotation);
+					Mat2 rotation;
+					rotation.SetAngle(m_clickAngle + from.Angle(to));
+					selectedPoly->SetRotation(rotation);
 
-					m_selectedPoly->angularVelocity = 0.0f;
-					m_selectedPoly->speed = Vec2();
+					selectedPoly->SetAngularVelocity(0.0f);
+					selectedPoly->SetSpeed(Vec2());
 				}
 
 				m_prevMousePos = mousePoint;
@@ -69,12 +75,12 @@ class CPolygonMoverTool : public CBehavior
 		}
 		else
 		{
-			m_selectedPoly.reset();
+			m_selectedBody = SBodyHandle();
 		}
 	}
 
 private:
-	CPolygonPtr	m_selectedPoly;
+	SBodyHandle	m_selectedBody;
 	bool		m_translate;
 	Vec2		m_prevMousePos;
 	Vec2		m_clickMousePos;
@@ -4,7 +4,7 @@
 #include "Behavior.h"
 #include "PhysicEngine.h"
 #include "GlobalVariables.h"
-#include "Renderer.h"
+#include "IRenderer.h"
 #include "World.h"
 
 class CSimplePolygonBounce : public CBehavior
@@ -19,16 +19,20 @@ private:
 				collision.polyA->AddPosition(collision.normal * collision.distance * 0.5f);
 				collision.polyB->AddPosition(collision.normal * collision.distance * -0.5f);
 
-				collision.polyA->speed.Reflect(collision.normal);
-				collision.polyB->speed.Reflect(collision.normal * -1.0f);
+				Vec2 speedA = collision.polyA->GetSpeed();
+				Vec2 speedB = collision.polyB->GetSpeed();
+				speedA.Reflect(collision.normal);
+				speedB.Reflect(collision.normal * -1.0f);
+				collision.polyA->SetSpeed(speedA);
+				collision.polyB->SetSpeed(speedB);
 			}
 			if (gVars->bDebugElem && gVars->bToggleEPADebug)
 			{
-				gVars->pRenderer->DisplayTextWorld("ptA", collision.polyA->position + collision.normal * collision.distance);
-				gVars->pRenderer->DrawLine(collision.polyA->position, collision.polyA->position + collision.normal * collision.distance, 1.0f, 0.0f, 1.0f);
+				gVars->pRenderer->DisplayTextWorld("ptA", collision.polyA->GetPosition() + collision.normal * collision.distance);
+				gVars->pRenderer->DrawLine(collision.polyA->GetPosition(), collision.polyA->GetPosition() + collision.normal * collision.distance, 1.0f, 0.0f, 1.0f);
 
-				gVars->pRenderer->DisplayTextWorld("ptB", collision.polyB->position - collision.normal * collision.distance);
-				gVars->pRenderer->DrawLine(collision.polyB->position, collision.polyB->position - collision.normal * collision.distance, 1.0f, 0.0f, 1.0f);
+				gVars->pRenderer->DisplayTextWorld("ptB", collision.polyB->GetPosition() - collision.normal * collision.distance);
+				gVars->pRenderer->DrawLine(collision.polyB->GetPosition(), collision.polyB->GetPosition() - collision.normal * collision.distance, 1.0f, 0.0f, 1.0f);
 
 				gVars->pRenderer->DisplayText("Collision distance : " + std::to_string(collision.distance), 50, 50);
 
@@ -42,29 +46,31 @@ private:
 
 		gVars->pWorld->ForEachPolygon([&](CPolygonPtr poly)
 			{
-				poly->AddPosition(poly->speed * frameTime);
-		Vec2 result = poly->position;
+				Vec2 speed = poly->GetSpeed();
+				poly->AddPosition(speed * frameTime);
+		Vec2 result = poly->GetPosition();
 		if (result.x < -hWidth)
 		{
 			result.x = -hWidth;
-			poly->speed.x *= -1.0f;
+			speed.x *= -1.0f;
 		}
 		else if (result.x > hWidth)
 		{
 			result.x = hWidth;
-			poly->speed.x *= -1.0f;
+			speed.x *= -1.0f;
 		}
 		if (result.y < -hHeight)
 		{
 			result.y = -hHeight;
-			poly->speed.y *= -1.0f;
+			speed.y *= -1.0f;
 		}
 		else if (result.y > hHeight)
 		{
 			result.y = hHeight;
-			poly->speed.y *= -1.0f;
+			speed.y *= -1.0f;
 		}
 		poly->SetPosition(result);
+		poly->SetSpeed(speed);
 			});
 	}
 };
@@ -0,0 +1,393 @@
+#ifndef _SOFT_STEP_COLLISION_RESPONSE_H_
+#define _SOFT_STEP_COLLISION_RESPONSE_H_
+
+#include "Behavior.h"
+#include "PhysicEngine.h"
+#include "GlobalVariables.h"
+#include "IRenderer.h"
+#include "World.h"
+#include "ConstraintColoring.h"
+#include "WarmStartCache.h"
+#include "Profiler.h"
+#include "Timer.h"
+
+#include <string>
+
+// Contact solver doing several small substeps per frame (integrate, solve with soft constraints, integrate positions, relax)
+// instead of many velocity iterations. Contact constraints are built once per frame from collision manifolds and reused by every substep.
+class CSoftStepCollisionResponse : public CBehavior
+{
+public:
+	size_t	substepCount = 4;
+	float	contactHertz = 30.0f;			// stiffness of contact softness, clamped to a quarter of substep rate
+	float	contactDampingRatio = 10.0f;
+	float	maxPushoutSpeed = 3.0f;			// max speed used to push overlapping bodies apart
+	float	restitutionThreshold = 1.0f;	// no bounce under this approach speed
+	Vec2	gravity = Vec2(0, -9.8f);
+
+	// Time spent in Update since the behavior was created, and number of updates
+	float	GetSolveDuration() const	{ return m_solveDuration; }
+	size_t	GetSolveCount() const		{ return m_solveCount; }
+
+private:
+	// Solver copy of a body store entry, bodies are only written back at the end of the frame
+	struct SSoftBody
+	{
+		Vec2	position;
+		Mat2	rotation;
+		Vec2	speed;
+		float	angularVelocity;
+		float	invMass;
+		float	invInertia;
+	};
+
+	struct SSoftContactPoint
+	{
+		Vec2	rA, rB;						// anchors relative to bodies center at frame start (jacobians)
+		Vec2	localAnchorA, localAnchorB;	// same anchors in body space, to track separation during substeps
+		float	penetration;
+		float	normalMass, tangentMass;
+		float	normalImpulse, tangentImpulse, maxNormalImpulse;
+		float	relativeVelocity;
+		size_t	featureId;
+	};
+
+	struct SSoftConstraint
+	{
+		size_t				bodyA, bodyB;
+		SBodyHandle			handleA, handleB;	// warm start keys, dense indices change when bodies are removed
+		Vec2				normal, tangent;
+		float				friction, restitution;
+		size_t				pointCount;
+		SSoftContactPoint	points[2];
+	};
+
+	struct SSoftness
+	{
+		float	biasRate = 0.0f;
+		float	massScale = 1.0f;
+		float	impulseScale = 0.0f;
+	};
+
+	std::vector<SSoftBody>			m_bodies;
+	std::vector<SSoftConstraint>	m_constraints;
+	CWarmStartCache					m_warmStartCache;
+	CConstraintColoring				m_coloring;
+	SSoftness						m_softness;
+	float							m_solveDuration = 0.0f;
+	size_t							m_solveCount = 0;
+
+	virtual CWarmStartCache* GetWarmStartCache() override { return &m_warmStartCache; }
+
+	virtual void Update(float frameTime) override
+	{
+		if (!gVars->bToggleCollision)
+			return;
+
+		PROFILE_ZONE("SoftStepCollisionResponse");
+		CTimer timer;
+		timer.Start();
+
+		float h = frameTime / (float)substepCount;
+
+		// Box2D style soft contact : stiffness can't exceed what the substep rate resolves
+		float hertz = Min(contactHertz, 0.25f / h);
+		float omega = 2.0f * (float)M_PI * hertz;
+		float a1 = 2.0f * contactDampingRatio + h * omega;
+		float a2 = h * omega * a1;
+		float a3 = 1.0f / (1.0f + a2);
+		m_softness.biasRate = omega / a1;
+		m_softness.massScale = a2 * a3;
+		m_softness.impulseScale = a3;
+
+		CJobSystem& jobSystem = gVars->pPhysicEngine->GetJobSystem();
+
+		GatherBodies();
+		m_warmStartCache.NewFrame(gVars->pPhysicEngine->GetCollisions().size() * 2);
+		PrepareConstraints();
+		m_coloring.Build(gVars->pPhysicEngine->GetCollisions(), gVars->pWorld->GetBodies().masses);
+
+		Vec2 stepGravity = gVars->bToggleGravity ? gravity * h : Vec2();
+
+		PROFILE_COUNTER(SolverIterations, substepCount);
+		for (size_t substep = 0; substep < substepCount; ++substep)
+		{
+			jobSystem.ParallelFor(m_bodies.size(), CONSTRAINT_GRAIN_SIZE * 4, [&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					if (m_bodies[i].invMass != 0.0f)
+						m_bodies[i].speed += stepGravity;
+				}
+			});
+
+			m_coloring.ForEach(jobSystem, [&](size_t index)
+			{
+				WarmStartConstraint(m_constraints[index]);
+			});
+
+			m_coloring.ForEach(jobSystem, [&](size_t index)
+			{
+				SolveConstraint(m_constraints[index], h, true);
+			});
+
+			jobSystem.ParallelFor(m_bodies.size(), CONSTRAINT_GRAIN_SIZE * 4, [&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					IntegratePosition(m_bodies[i], h);
+				}
+			});
+
+			m_coloring.ForEach(jobSystem, [&](size_t index)
+			{
+				SolveConstraint(m_constraints[index], h, false);
+			});
+		}
+
+		m_coloring.ForEach(jobSystem, [&](size_t index)
+		{
+			ApplyRestitution(m_constraints[index]);
+		});
+
+		ScatterBodies();
+		StoreImpulses();
+
+		timer.Stop();
+		m_solveDuration += timer.GetDuration();
+		++m_solveCount;
+		if (gVars->bDebug && gVars->pRenderer->IsDisplayingTexts())
+		{
+			gVars->pRenderer->DisplayText("Soft step solver : " + std::to_string(substepCount) + " substeps, " + std::to_string(m_constraints.size()) + " constraints, "
+				+ std::to_string(m_coloring.GetColorCount()) + " colors, " + std::to_string(timer.GetDuration() * 1000.0f) + " ms");
+		}
+	}
+
+	inline void GatherBodies()
+	{
+		const CBodyStore& bodies = gVars->pWorld->GetBodies();
+		m_bodies.resize(bodies.GetCount());
+
+		for (size_t i = 0; i < bodies.GetCount(); ++i)
+		{
+			SSoftBody& body = m_bodies[i];
+			body.position = bodies.positions[i];
+			body.rotation = bodies.rotations[i];
+			body.speed = bodies.speeds[i];
+			body.angularVelocity = bodies.angularVelocities[i];
+
+			float mass = bodies.masses[i];
+			float inertia = bodies.inertias[i];
+			body.invMass = (mass != 0.0f) ? 1.0f / mass : 0.0f;
+			body.invInertia = (mass != 0.0f && inertia != 0.0f) ? 1.0f / inertia : 0.0f;
+		}
+	}
+
+	inline void PrepareConstraints()
+	{
+		std::vector<SCollision>& collisions = gVars->pPhysicEngine->GetCollisions();
+		m_constraints.resize(collisions.size());
+
+		gVars->pPhysicEngine->GetJobSystem().ParallelFor(collisions.size(), CONSTRAINT_GRAIN_SIZE, [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				PrepareConstraint(collisions[i], m_constraints[i]);
+			}
+		});
+	}
+
+	inline void PrepareConstraint(const SCollision& collision, SSoftConstraint& constraint) const
+	{
+		constraint.bodyA = collision.GetBodyA();
+		constraint.bodyB = collision.GetBodyB();
+		constraint.handleA = collision.polyA->GetHandle();
+		constraint.handleB = collision.polyB->GetHandle();
+		const SSoftBody& bodyA = m_bodies[constraint.bodyA];
+		const SSoftBody& bodyB = m_bodies[constraint.bodyB];
+
+		constraint.normal = (collision.manifoldSize > 0) ? collision.manifold[0].normal : collision.normal;
+		constraint.tangent = Vec2(constraint.normal.y, -constraint.normal.x);
+		constraint.friction = Min(collision.polyA->friction, collision.polyB->friction);
+		constraint.restitution = collision.polyA->bounciness * collision.polyB->bounciness;
+
+		// empty manifold : polygons are not actually touching, constraint does nothing
+		constraint.pointCount = collision.manifoldSize;
+		for (size_t i = 0; i < constraint.pointCount; ++i)
+		{
+			SSoftContactPoint& point = constraint.points[i];
+			Vec2 contactPoint = collision.manifold[i].point;
+			point.penetration = collision.manifold[i].penetration;
+			point.featureId = collision.manifold[i].index;
+
+			point.rA = contactPoint - bodyA.position;
+			point.rB = contactPoint - bodyB.position;
+			point.localAnchorA = bodyA.rotation.GetInverseOrtho() * point.rA;
+			point.localAnchorB = bodyB.rotation.GetInverseOrtho() * point.rB;
+
+			float rnA = point.rA ^ constraint.normal;
+			float rnB = point.rB ^ constraint.normal;
+			float kNormal = bodyA.invMass + bodyB.invMass + bodyA.invInertia * rnA * rnA + bodyB.invInertia * rnB * rnB;
+			point.normalMass = (kNormal > 0.0f) ? 1.0f / kNormal : 0.0f;
+
+			float rtA = point.rA ^ constraint.tangent;
+			float rtB = point.rB ^ constraint.tangent;
+			float kTangent = bodyA.invMass + bodyB.invMass + bodyA.invInertia * rtA * rtA + bodyB.invInertia * rtB * rtB;
+			point.tangentMass = (kTangent > 0.0f) ? 1.0f / kTangent : 0.0f;
+
+			point.relativeVelocity = GetRelativeVelocity(bodyA, bodyB, point) | constraint.normal;
+			point.maxNormalImpulse = 0.0f;
+
+			point.normalImpulse = 0.0f;
+			point.tangentImpulse = 0.0f;
+			m_warmStartCache.Find(CWarmStartCache::MakeKey(constraint.handleA.value, constraint.handleB.value, point.featureId), point.normalImpulse, point.tangentImpulse);
+		}
+	}
+
+	inline void WarmStartConstraint(const SSoftConstraint& constraint)
+	{
+		SSoftBody& bodyA = m_bodies[constraint.bodyA];
+		SSoftBody& bodyB = m_bodies[constraint.bodyB];
+
+		for (size_t i = 0; i < constraint.pointCount; ++i)
+		{
+			const SSoftContactPoint& point = constraint.points[i];
+			ApplyImpulse(bodyA, bodyB, point, constraint.normal * point.normalImpulse + constraint.tangent * point.tangentImpulse);
+		}
+	}
+
+	// useBias : soft solve pushing bodies apart, otherwise rigid relax pass removing the velocity added by the bias
+	inline void SolveConstraint(SSoftConstraint& constraint, float h, bool useBias)
+	{
+		SSoftBody& bodyA = m_bodies[constraint.bodyA];
+		SSoftBody& bodyB = m_bodies[constraint.bodyB];
+
+		for (size_t i = 0; i < constraint.pointCount; ++i)
+		{
+			SSoftContactPoint& point = constraint.points[i];
+
+			// current separation, from anchors moved with bodies since frame start
+			Vec2 anchorA = bodyA.position + bodyA.rotation * point.localAnchorA;
+			Vec2 anchorB = bodyB.position + bodyB.rotation * point.localAnchorB;
+			float separation = ((anchorB - anchorA) | constraint.normal) - point.penetration;
+
+			float bias = 0.0f;
+			float massScale = 1.0f;
+			float impulseScale = 0.0f;
+			if (separation > 0.0f)
+			{
+				// speculative : allow approach up to contact
+				bias = separation / h;
+			}
+			else if (useBias)
+			{
+				bias = Max(m_softness.biasRate * separation, -maxPushoutSpeed);
+				massScale = m_softness.massScale;
+				impulseScale = m_softness.impulseScale;
+			}
+
+			float normalVelocity = GetRelativeVelocity(bodyA, bodyB, point) | constraint.normal;
+			float normalImpulse = -point.normalMass * massScale * (normalVelocity + bias) - impulseScale * point.normalImpulse;
+			float newNormalImpulse = Max(point.normalImpulse + normalImpulse, 0.0f);
+			normalImpulse = newNormalImpulse - point.normalImpulse;
+			point.normalImpulse = newNormalImpulse;
+			point.maxNormalImpulse = Max(point.maxNormalImpulse, normalImpulse);
+			ApplyImpulse(bodyA, bodyB, point, constraint.normal * normalImpulse);
+		}
+
+		for (size_t i = 0; i < constraint.pointCount; ++i)
+		{
+			SSoftContactPoint& point = constraint.points[i];
+
+			float tangentVelocity = GetRelativeVelocity(bodyA, bodyB, point) | constraint.tangent;
+			float maxFriction = constraint.friction * point.normalImpulse;
+			float newTangentImpulse = Clamp(point.tangentImpulse - point.tangentMass * tangentVelocity, -maxFriction, maxFriction);
+			float tangentImpulse = newTangentImpulse - point.tangentImpulse;
+			point.tangentImpulse = newTangentImpulse;
+			ApplyImpulse(bodyA, bodyB, point, constraint.tangent * tangentImpulse);
+		}
+	}
+
+	inline void ApplyRestitution(SSoftConstraint& constraint)
+	{
+		if (constraint.restitution == 0.0f)
+			return;
+
+		SSoftBody& bodyA = m_bodies[constraint.bodyA];
+		SSoftBody& bodyB = m_bodies[constraint.bodyB];
+
+		for (size_t i = 0; i < constraint.pointCount; ++i)
+		{
+			SSoftContactPoint& point = constraint.points[i];
+			if (point.relativeVelocity > -restitutionThreshold || point.maxNormalImpulse == 0.0f)
+				continue;
+
+			float normalVelocity = GetRelativeVelocity(bodyA, bodyB, point) | constraint.normal;
+			float normalImpulse = -point.normalMass * (normalVelocity + constraint.restitution * point.relativeVelocity);
+			float newNormalImpulse = Max(point.normalImpulse + normalImpulse, 0.0f);
+			normalImpulse = newNormalImpulse - point.normalImpulse;
+			point.normalImpulse = newNormalImpulse;
+			ApplyImpulse(bodyA, bodyB, point, constraint.normal * normalImpulse);
+		}
+	}
+
+	inline void IntegratePosition(SSoftBody& body, float h)
+	{
+		if (body.invMass == 0.0f)
+			return;
+
+		body.position += body.speed * h;
+
+		// rotation integrated on its first axis then normalized
+		Vec2 axis = body.rotation.X;
+		float angle = body.angularVelocity * h;
+		body.rotation.X = Vec2(axis.x - angle * axis.y, axis.y + angle * axis.x).Normalized();
+		body.rotation.Y = body.rotation.X.GetNormal();
+	}
+
+	inline void ScatterBodies()
+	{
+		CBodyStore& bodies = gVars->pWorld->GetBodies();
+		const std::vector<CPolygonPtr>& polygons = gVars->pWorld->GetPolygons();
+		for (size_t i = 0; i < bodies.GetCount(); ++i)
+		{
+			const SSoftBody& body = m_bodies[i];
+			if (body.invMass == 0.0f)
+				continue;
+
+			bodies.speeds[i] = body.speed;
+			bodies.angularVelocities[i] = body.angularVelocity;
+			polygons[i]->SetPosition(body.position);
+			polygons[i]->SetRotation(body.rotation);
+		}
+	}
+
+	inline void StoreImpulses()
+	{
+		for (const SSoftConstraint& constraint : m_constraints)
+		{
+			for (size_t i = 0; i < constraint.pointCount; ++i)
+			{
+				const SSoftContactPoint& point = constraint.points[i];
+				m_warmStartCache.Store(CWarmStartCache::MakeKey(constraint.handleA.value, constraint.handleB.value, point.featureId), point.normalImpulse, point.tangentImpulse);
+			}
+		}
+	}
+
+	inline void ApplyImpulse(SSoftBody& bodyA, SSoftBody& bodyB, const SSoftContactPoint& point, const Vec2& impulse)
+	{
+		bodyA.speed -= impulse * bodyA.invMass;
+		bodyA.angularVelocity -= bodyA.invInertia * (point.rA ^ impulse);
+		bodyB.speed += impulse * bodyB.invMass;
+		bodyB.angularVelocity += bodyB.invInertia * (point.rB ^ impulse);
+	}
+
+	inline Vec2 GetRelativeVelocity(const SSoftBody& bodyA, const SSoftBody& bodyB, const SSoftContactPoint& point) const
+	{
+		Vec2 velA = bodyA.speed + point.rA.GetNormal() * bodyA.angularVelocity;
+		Vec2 velB = bodyB.speed + point.rB.GetNormal() * bodyB.angularVelocity;
+		return velB - velA;
+	}
+};
+
+#endif
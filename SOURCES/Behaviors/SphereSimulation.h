@@ -4,7 +4,7 @@
 #include "Behavior.h"
 #include "PhysicEngine.h"
 #include "GlobalVariables.h"
-#include "Renderer.h"
+#include "IRenderer.h"
 #include "World.h"
 
 #define RADIUS 2.0f
@@ -23,6 +23,12 @@ class CSphereSimulation : public CBehavior
 {
 private:
 
+	// speed stored in the world bodies, circles are moved by this behavior
+	Vec2& Speed(CPolygonPtr circle)
+	{
+		return gVars->pWorld->GetBodies().speeds[circle->GetIndex()];
+	}
+
 	void InitChain(size_t count, const Vec2& start)
 	{
 		for (size_t i = 0; i < count; ++i)
@@ -33,7 +39,7 @@ private:
 
 	void SolveChainConstraints()
 	{
-		m_chain[0]->speed = Vec2();
+		Speed(m_chain[0]) = Vec2();
 
 		for (size_t i = 0; i + 1 < m_chain.size(); ++i)
 		{
@@ -42,20 +48,20 @@ private:
 
 			float coeff = (i == 0) ? 0.0f : 0.5f;
 
-			Vec2 diffPos = c2->position - c1->position;
+			Vec2 diffPos = c2->GetPosition() - c1->GetPosition();
 			float length = diffPos.GetLength();
 
-			Vec2 diffSpeed = c2->speed - c1->speed;
+			Vec2 diffSpeed = Speed(c2) - Speed(c1);
 
 			Vec2 normal = diffPos / length;
 			float impulse = (diffSpeed | normal);
 
-			c1->speed += normal * ((diffSpeed | normal) * 0.5f * coeff);
-			c2->speed -= normal * ((diffSpeed | normal) * 0.5f * (1.0f - coeff));
+			Speed(c1) += normal * ((diffSpeed | normal) * 0.5f * coeff);
+			Speed(c2) -= normal * ((diffSpeed | normal) * 0.5f * (1.0f - coeff));
 
 			float moveSpeed = Sign(length - DISTANCE) * 7.0f;
-			c1->speed += normal * moveSpeed * coeff;
-			c2->speed -= normal * moveSpeed * (1.0f - coeff);
+			Speed(c1) += normal * moveSpeed * coeff;
+			Speed(c2) -= normal * moveSpeed * (1.0f - coeff);
 		}
 	}
 
@@ -65,7 +71,7 @@ private:
 		{
 			for (float y = -22.0f; y < 22.0f; y += 10.0f)
 			{
-				AddCircle(Vec2(x + Random(-0.1f, 0.1f), y + Random(-0.1f, 0.1f)))->speed.x = 50.0f;
+				AddCircle(Vec2(x + Random(-0.1f, 0.1f), y + Random(-0.1f, 0.1f)))->SetSpeed(Vec2(50.0f, 0.0f));
 			}
 		}
 
@@ -78,8 +84,8 @@ private:
 	{
 		for (CPolygonPtr& circle : m_circles)
 		{
-			circle->speed.y -= 20.0f * frameTime;
-			circle->speed -= circle->speed * 0.3f * frameTime;
+			Speed(circle).y -= 20.0f * frameTime;
+			Speed(circle) -= Speed(circle) * 0.3f * frameTime;
 		}
 
 		for (size_t i = 0; i < m_circles.size(); ++i)
@@ -89,16 +95,16 @@ private:
 				CPolygonPtr c1 = m_circles[i];
 				CPolygonPtr c2 = m_circles[j];
 			
-				Vec2 diffPos = c2->position - c1->position;
-				Vec2 diffSpeed = c2->speed - c1->speed;
+				Vec2 diffPos = c2->GetPosition() - c1->GetPosition();
+				Vec2 diffSpeed = Speed(c2) - Speed(c1);
 				if (diffPos.GetSqrLength() < 4.0f * RADIUS * RADIUS && ((diffSpeed | diffPos) < 0.0f))
 				{
 					Vec2 normal = diffPos.Normalized();
 					Vec2 diff = normal * (diffSpeed | normal) * 0.5f;
 
 
-					c1->speed += diff * 1.8f;
-					c2->speed -= diff * 1.8f;
+					Speed(c1) += diff * 1.8f;
+					Speed(c2) -= diff * 1.8f;
 				}
 			}
 		}
@@ -108,21 +114,21 @@ private:
 
 		for (CPolygonPtr& circle : m_circles)
 		{
-			if (circle->position.x < -hWidth + RADIUS && circle->speed.x < 0)
+			if (circle->GetPosition().x < -hWidth + RADIUS && Speed(circle).x < 0)
 			{
-				circle->speed.x *= -1.0f;
+				Speed(circle).x *= -1.0f;
 			}
-			else if (circle->position.x > hWidth - RADIUS && circle->speed.x > 0)
+			else if (circle->GetPosition().x > hWidth - RADIUS && Speed(circle).x > 0)
 			{
-				circle->speed.x *= -1.0f;
+				Speed(circle).x *= -1.0f;
 			}
-			if (circle->position.y < -hHeight + RADIUS && circle->speed.y < 0)
+			if (circle->GetPosition().y < -hHeight + RADIUS && Speed(circle).y < 0)
 			{
-				circle->speed.y *= -1.0f;
+				Speed(circle).y *= -1.0f;
 			}
-			else if (circle->position.y > hHeight - RADIUS && circle->speed.y > 0)
+			else if (circle->GetPosition().y > hHeight - RADIUS && Speed(circle).y > 0)
 			{
-				circle->speed.y *= -1.0f;
+				Speed(circle).y *= -1.0f;
 			}
 		}
 			
@@ -130,14 +136,14 @@ private:
 
 		for (CPolygonPtr& circle : m_circles)
 		{
-			circle->AddPosition(circle->speed * frameTime);
+			circle->AddPosition(Speed(circle) * frameTime);
 		}
 	}
 
 	CPolygonPtr AddCircle(const Vec2& pos, float radius = RADIUS)
 	{
 		CPolygonPtr circle = gVars->pWorld->AddSymetricPolygon(radius, 50);
-		circle->density = 0.0f;
+		circle->SetDensity(0.0f);
 		circle->SetPosition(pos);
 		m_circles.push_back(circle);
 
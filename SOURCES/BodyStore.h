@@ -0,0 +1,202 @@
+#ifndef _BODY_STORE_H_
+#define _BODY_STORE_H_
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "Maths.h"
+#include "AABB.h"
+
+#define BODY_HANDLE_SLOT_BITS 20
+#define BODY_HANDLE_SLOT_MASK ((1u << BODY_HANDLE_SLOT_BITS) - 1)
+#define BODY_HANDLE_GENERATION_MASK ((1u << (32 - BODY_HANDLE_SLOT_BITS)) - 1)
+#define BODY_MAX_COUNT (1u << BODY_HANDLE_SLOT_BITS)
+
+// 32 bit body reference : slot in the low bits, slot generation in the high bits.
+// Stays valid while bodies are removed and moved, a handle of a removed body is detected by its generation.
+struct SBodyHandle
+{
+	static const uint32_t Invalid = 0xFFFFFFFF;
+
+	SBodyHandle() = default;
+	SBodyHandle(uint32_t slot, uint32_t generation)
+		: value((slot & BODY_HANDLE_SLOT_MASK) | ((generation & BODY_HANDLE_GENERATION_MASK) << BODY_HANDLE_SLOT_BITS)){}
+
+	uint32_t	GetSlot() const			{ return value & BODY_HANDLE_SLOT_MASK; }
+	uint32_t	GetGeneration() const	{ return value >> BODY_HANDLE_SLOT_BITS; }
+	bool		IsNull() const			{ return value == Invalid; }
+
+	bool operator==(const SBodyHandle& rhs) const { return value == rhs.value; }
+	bool operator!=(const SBodyHandle& rhs) const { return value != rhs.value; }
+
+	uint32_t	value = Invalid;
+};
+
+// Dense storage of body simulation state, one entry per body in each array (SoA).
+// Bodies are indexed by their dense index in [0, GetCount()[, removing a body moves the last one in its place (O(1)),
+// so dense indices change on removal while handles don't.
+class CBodyStore
+{
+public:
+	// Transforms
+	std::vector<Vec2>	positions;
+	std::vector<Mat2>	rotations;
+	std::vector<Vec2>	previousPositions;
+	std::vector<Mat2>	previousRotations;
+	std::vector<CAABB>	bounds;
+
+	// Velocities
+	std::vector<Vec2>	speeds;
+	std::vector<float>	angularVelocities;
+
+	// Mass data, 0 for static bodies
+	std::vector<float>	masses;
+	std::vector<float>	inertias;
+
+	inline size_t	GetCount() const
+	{
+		return m_denseToSlot.size();
+	}
+
+	// At most BODY_MAX_COUNT bodies, more slots would alias existing handles
+	inline SBodyHandle	Add()
+	{
+		uint32_t slot;
+		if (m_freeSlots.empty())
+		{
+			assert(m_slots.size() < BODY_MAX_COUNT);
+			slot = (uint32_t)m_slots.size();
+			m_slots.push_back(SSlot());
+		}
+		else
+		{
+			slot = m_freeSlots.back();
+			m_freeSlots.pop_back();
+		}
+
+		m_slots[slot].index = (uint32_t)GetCount();
+		m_denseToSlot.push_back(slot);
+
+		positions.push_back(Vec2());
+		rotations.push_back(Mat2());
+		previousPositions.push_back(Vec2());
+		previousRotations.push_back(Mat2());
+		bounds.push_back(CAABB());
+		speeds.push_back(Vec2());
+		angularVelocities.push_back(0.0f);
+		masses.push_back(0.0f);
+		inertias.push_back(0.0f);
+		m_unsaved.push_back(1);
+
+		return SBodyHandle(slot, m_slots[slot].generation);
+	}
+
+	// Returns the previous dense index of the body moved in the removed one place, or GetCount() if none moved
+	inline size_t	Remove(SBodyHandle handle)
+	{
+		size_t index = GetIndex(handle);
+		size_t last = GetCount() - 1;
+
+		SSlot& slot = m_slots[handle.GetSlot()];
+		slot.generation = (slot.generation + 1) & BODY_HANDLE_GENERATION_MASK;
+		if (SBodyHandle(handle.GetSlot(), slot.generation).IsNull())
+		{
+			slot.generation = 0; // last slot at last generation is the Invalid value
+		}
+		m_freeSlots.push_back(handle.GetSlot());
+
+		if (index != last)
+		{
+			m_denseToSlot[index] = m_denseToSlot[last];
+			m_slots[m_denseToSlot[index]].index = (uint32_t)index;
+		}
+		m_denseToSlot.pop_back();
+
+		SwapRemove(positions, index);
+		SwapRemove(rotations, index);
+		SwapRemove(previousPositions, index);
+		SwapRemove(previousRotations, index);
+		SwapRemove(bounds, index);
+		SwapRemove(speeds, index);
+		SwapRemove(angularVelocities, index);
+		SwapRemove(masses, index);
+		SwapRemove(inertias, index);
+		SwapRemove(m_unsaved, index);
+
+		return (index != last) ? last : GetCount();
+	}
+
+	inline bool	IsValid(SBodyHandle handle) const
+	{
+		return !handle.IsNull() && handle.GetSlot() < m_slots.size() && m_slots[handle.GetSlot()].generation == handle.GetGeneration();
+	}
+
+	// Handle must be valid
+	inline size_t	GetIndex(SBodyHandle handle) const
+	{
+		return m_slots[handle.GetSlot()].index;
+	}
+
+	inline SBodyHandle	GetHandle(size_t index) const
+	{
+		uint32_t slot = m_denseToSlot[index];
+		return SBodyHandle(slot, m_slots[slot].generation);
+	}
+
+	// Previous transforms become the current ones, before each step
+	inline void	SaveTransforms()
+	{
+		previousPositions = positions;
+		previousRotations = rotations;
+		m_unsaved.assign(GetCount(), 0);
+	}
+
+	// Added since the last SaveTransforms : moving it also moves its previous transform, so it isn't interpolated from the origin
+	inline bool	IsUnsaved(size_t index) const
+	{
+		return m_unsaved[index] != 0;
+	}
+
+	// false once a transform or velocity is NaN or infinite (diverged simulation)
+	inline bool	IsFinite() const
+	{
+		for (size_t i = 0; i < GetCount(); ++i)
+		{
+			const Vec2& position = positions[i];
+			const Mat2& rotation = rotations[i];
+			const Vec2& speed = speeds[i];
+			if (!std::isfinite(position.x) || !std::isfinite(position.y) || !std::isfinite(rotation.X.x) || !std::isfinite(rotation.X.y)
+				|| !std::isfinite(rotation.Y.x) || !std::isfinite(rotation.Y.y) || !std::isfinite(speed.x) || !std::isfinite(speed.y)
+				|| !std::isfinite(angularVelocities[i]))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+private:
+	friend class CWorldSnapshot;
+
+	template<typename T>
+	static inline void	SwapRemove(std::vector<T>& values, size_t index)
+	{
+		values[index] = values.back();
+		values.pop_back();
+	}
+
+	struct SSlot
+	{
+		uint32_t	index = 0;
+		uint32_t	generation = 0;
+	};
+
+	std::vector<SSlot>		m_slots;
+	std::vector<uint32_t>	m_freeSlots;
+	std::vector<uint32_t>	m_denseToSlot;
+	std::vector<uint8_t>	m_unsaved;
+};
+
+#endif
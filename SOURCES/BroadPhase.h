@@ -6,7 +6,8 @@
 class IBroadPhase
 {
 public:
-	std::vector<CPolygonPtr> sortedList;
+	virtual ~IBroadPhase() = default;
+
 	virtual void GetCollidingPairsToCheck(std::vector<SPolygonPair>& pairsToCheck) = 0;
 };
 
@@ -12,14 +12,12 @@ class CBroadPhaseBrut : public IBroadPhase
 public:
 	virtual void GetCollidingPairsToCheck(std::vector<SPolygonPair>& pairsToCheck) override
 	{
+		const std::vector<float>& masses = gVars->pWorld->GetBodies().masses;
 		for (size_t i = 0; i < gVars->pWorld->GetPolygonCount(); ++i)
 		{
 			for (size_t j = i + 1; j < gVars->pWorld->GetPolygonCount(); ++j)
 			{
-				CPolygonPtr pA = gVars->pWorld->GetPolygon(i);
-				CPolygonPtr pB = gVars->pWorld->GetPolygon(j);
-				
-				if (pA->density == 0.0f && pB->density == 0.0f)
+				if (masses[i] == 0.0f && masses[j] == 0.0f)
 					continue;
 
 				pairsToCheck.push_back(SPolygonPair(gVars->pWorld->GetPolygon(i), gVars->pWorld->GetPolygon(j)));
@@ -12,17 +12,16 @@ class CBroadPhaseImprovedBrut : public IBroadPhase
 public:
 	virtual void GetCollidingPairsToCheck(std::vector<SPolygonPair>& pairsToCheck) override
 	{
+		std::vector<CAABB>& bounds = gVars->pWorld->GetBodies().bounds;
 		size_t poly_count = gVars->pWorld->GetPolygonCount();
 		for (size_t i = 0; i < poly_count; ++i) // old brute test version
 		{
-			CPolygonPtr APoly = gVars->pWorld->GetPolygon(i);
-			CAABB A = APoly.get()->aabb;
+			CAABB& A = bounds[i];
 			for (size_t j = i + 1; j < poly_count; ++j)
 			{
-				CPolygonPtr BPoly = gVars->pWorld->GetPolygon(j);
-				CAABB B = BPoly.get()->aabb;
+				CAABB& B = bounds[j];
 				if (A.DoesOverlap(B))
-					pairsToCheck.push_back(SPolygonPair(APoly, BPoly));
+					pairsToCheck.push_back(SPolygonPair(gVars->pWorld->GetPolygon(i), gVars->pWorld->GetPolygon(j)));
 			}
 		}
 	}
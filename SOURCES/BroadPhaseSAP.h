@@ -5,57 +5,109 @@
 
 #include "Polygon.h"
 #include "GlobalVariables.h"
+#include "PhysicEngine.h"
+#include "Profiler.h"
 #include "World.h"
+
 #include <algorithm>
+#include <cstdlib>
+#include <new>
+#include <numeric>
+
+#define SAP_SWEEP_CHUNK_SIZE 64
 
+// Sweep and prune on x, over the body store bounds
 class CBroadPhaseSAP : public IBroadPhase
 {
 public:
-	inline static int compare(const void* a, const void* b)
+	struct SSortKey
 	{
-		const float A = static_cast<const CPolygonPtr*>(a)->get()->aabb->GetMinX();
-		const float B = static_cast<const CPolygonPtr*>(b)->get()->aabb->GetMinX();
-		if (A < B)
-			return -1;
-		return 1;
-	}
+		float		minX;
+		uint32_t	body;	// dense index
+	};
 
-	inline static int compare2(const CPolygonPtr a, const CPolygonPtr b)
+	// Strict total order, so the sorted order only depends on bounds and not on last frame order (snapshots don't store it) :
+	// ties are ordered by body and NaN keys of diverged bodies go last
+	inline static int compare(const void* a, const void* b)
 	{
-		const float A = a.get()->aabb->GetMinX();
-		const float B = b.get()->aabb->GetMinX();
-		if (A < B)
+		const SSortKey& A = *static_cast<const SSortKey*>(a);
+		const SSortKey& B = *static_cast<const SSortKey*>(b);
+		if (A.minX < B.minX)
 			return -1;
-		return 1;
+		if (B.minX < A.minX)
+			return 1;
+
+		bool isANaN = (A.minX != A.minX);
+		bool isBNaN = (B.minX != B.minX);
+		if (isANaN != isBNaN)
+			return isANaN ? 1 : -1;
+		return (A.body < B.body) ? -1 : 1;
 	}
 
 	virtual void GetCollidingPairsToCheck(std::vector<SPolygonPair>& pairsToCheck) override
 	{
-		if (sortedList.empty())
-			sortedList = gVars->pWorld->GetPolygons();
-		std::qsort(sortedList.data(), sortedList.size(), sizeof(CPolygonPtr), compare);
-		//std::sort(sortedList.begin(), sortedList.end(), compare2); other sort for benchmark
+		std::vector<CAABB>& bounds = gVars->pWorld->GetBodies().bounds;
+		const std::vector<CPolygonPtr>& polygons = gVars->pWorld->GetPolygons();
+		size_t count = bounds.size();
+
+		// Order of last frame is sorted again, it barely changes between frames.
+		// Dense indices are always a permutation of [0, count[, order is only reset when the count changes.
+		if (m_sortedBodies.size() != count)
+		{
+			m_sortedBodies.resize(count);
+			std::iota(m_sortedBodies.begin(), m_sortedBodies.end(), 0);
+		}
 
-		size_t sortedListSize = sortedList.size();
-		for (size_t i = 0; i < sortedListSize; i++)
+		SSortKey* sortKeys = gVars->pPhysicEngine->GetFrameArena().Allocate<SSortKey>(count);
+		for (size_t i = 0; i < count; i++)
 		{
-			CAABB* a = sortedList[i].get()->aabb;
-			for (size_t j = i + 1; j < sortedListSize; j++)
+			uint32_t body = m_sortedBodies[i];
+			sortKeys[i].minX = bounds[body].GetMinX();
+			sortKeys[i].body = body;
+		}
+		std::qsort(sortKeys, count, sizeof(SSortKey), compare);
+		for (size_t i = 0; i < count; i++)
+		{
+			m_sortedBodies[i] = sortKeys[i].body;
+		}
+
+		// Sweep by chunks of sorted bodies in parallel, pairs are merged in chunk order so they are the same as a sequential sweep
+		CJobSystem& jobSystem = gVars->pPhysicEngine->GetJobSystem();
+		size_t chunkCount = (count + SAP_SWEEP_CHUNK_SIZE - 1) / SAP_SWEEP_CHUNK_SIZE;
+		TFrameVector<SPolygonPair>* chunkPairs = gVars->pPhysicEngine->GetFrameArena().Allocate<TFrameVector<SPolygonPair>>(chunkCount);
+		jobSystem.ParallelForChunks(count, SAP_SWEEP_CHUNK_SIZE, [&](size_t chunk, size_t begin, size_t end)
+		{
+			PROFILE_ZONE("SAPSweepChunk");
+			TFrameVector<SPolygonPair>& pairs = *new (&chunkPairs[chunk]) TFrameVector<SPolygonPair>(gVars->pPhysicEngine->GetFrameArena());
+			for (size_t i = begin; i < end; i++)
 			{
-				CAABB* b = sortedList[j].get()->aabb;
-				const float AMaxX = a->GetMaxX();
-				const float BMinX = b->GetMinX();
-				if (AMaxX < BMinX)
-					break;
-				if (a->DoesOtherAxisOverlap(*b))
+				const CAABB& a = bounds[sortKeys[i].body];
+				const float AMaxX = a.GetMaxX();
+				for (size_t j = i + 1; j < count; j++)
 				{
-					a->isOverlaping = true;
-					b->isOverlaping = true;
-					pairsToCheck.push_back(SPolygonPair(sortedList[i], sortedList[j]));
+					if (AMaxX < sortKeys[j].minX)
+						break;
+					if (a.DoesOtherAxisOverlap(bounds[sortKeys[j].body]))
+					{
+						pairs.push_back(SPolygonPair(polygons[sortKeys[i].body], polygons[sortKeys[j].body]));
+					}
 				}
 			}
+		});
+
+		for (size_t chunk = 0; chunk < chunkCount; chunk++)
+		{
+			for (const SPolygonPair& pair : chunkPairs[chunk])
+			{
+				bounds[pair.polyA->GetIndex()].isOverlaping = true;
+				bounds[pair.polyB->GetIndex()].isOverlaping = true;
+				pairsToCheck.push_back(pair);
+			}
 		}
 	}
+
+private:
+	std::vector<uint32_t>	m_sortedBodies;
 };
 
 #endif
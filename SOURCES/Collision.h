@@ -1,14 +1,16 @@
 #ifndef _COLLISION_H_
 #define _COLLISION_H_
 
+#include <tuple>
+
 #include "Polygon.h"
 
 struct SPolygonPair
 {
 	SPolygonPair(CPolygonPtr _polyA, CPolygonPtr _polyB) : polyA(_polyA), polyB(_polyB){}
 
-	CPolygonPtr	polyA;
-	CPolygonPtr	polyB;
+	CPolygonPtr	polyA = nullptr;
+	CPolygonPtr	polyB = nullptr;
 };
 
 struct SContactInfo
@@ -70,7 +72,7 @@ struct SCollision
 	SCollision(CPolygonPtr _polyA, CPolygonPtr _polyB, Vec2	_point/*, Vec2 _point2*/, Vec2 _normal, Vec2 _tangent, float _distance)
 		: polyA(_polyA), polyB(_polyB), point(_point), /*point2(_point2),*/ normal(_normal), tangent(_tangent), distance(_distance) {}
 
-	CPolygonPtr	polyA, polyB;
+	CPolygonPtr	polyA = nullptr, polyB = nullptr;
 
 	Vec2	point;
 	//Vec2	point2;
@@ -83,12 +85,19 @@ struct SCollision
 
 	float	lastTangentImpulse;
 	float	lastNormalImpulse;
-	Vec2	lastCollisionPoint;
 	float	normalMass;
 	float	tangentMass;
 
+	// materials of the pair, set by the solver before iterating
+	float	restitution;
+	float	friction;
+
+	// dense body indices of polyA and polyB
 	std::tuple<size_t, size_t> index = std::make_tuple(0,0);
 
+	inline size_t GetBodyA() const { return std::get<0>(index); }
+	inline size_t GetBodyB() const { return std::get<1>(index); }
+
 	size_t			manifoldSize = 0;
 	SContactInfo	manifold[2];
 };
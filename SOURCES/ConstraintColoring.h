@@ -0,0 +1,94 @@
+#ifndef _CONSTRAINT_COLORING_H_
+#define _CONSTRAINT_COLORING_H_
+
+#include <vector>
+#include <cstdint>
+
+#include "Collision.h"
+#include "JobSystem.h"
+
+#define MAX_CONSTRAINT_COLORS 64
+#define CONSTRAINT_GRAIN_SIZE 16
+
+// Constraint graph coloring : constraints of a same color never share a dynamic body and are solved in parallel.
+// Last batch holds the constraints that could not be colored, they are solved sequentially.
+class CConstraintColoring
+{
+public:
+	// masses are the body store ones, static bodies have no mass
+	inline void	Build(const std::vector<SCollision>& collisions, const std::vector<float>& masses)
+	{
+		m_bodyColors.assign(masses.size(), 0);
+		for (std::vector<size_t>& batch : m_batches)
+		{
+			batch.clear();
+		}
+		m_colorCount = 0;
+
+		for (size_t i = 0; i < collisions.size(); ++i)
+		{
+			const SCollision& collision = collisions[i];
+
+			// static bodies are never written by the solver, they can be shared by any number of constraints of a color
+			size_t bodyA = collision.GetBodyA();
+			size_t bodyB = collision.GetBodyB();
+			uint64_t* colorsA = (masses[bodyA] != 0) ? &m_bodyColors[bodyA] : nullptr;
+			uint64_t* colorsB = (masses[bodyB] != 0) ? &m_bodyColors[bodyB] : nullptr;
+			uint64_t usedColors = (colorsA ? *colorsA : 0) | (colorsB ? *colorsB : 0);
+
+			size_t color = 0;
+			while (color < MAX_CONSTRAINT_COLORS && (usedColors & ((uint64_t)1 << color)) != 0)
+			{
+				++color;
+			}
+
+			if (color < MAX_CONSTRAINT_COLORS)
+			{
+				uint64_t colorBit = (uint64_t)1 << color;
+				if (colorsA)
+					*colorsA |= colorBit;
+				if (colorsB)
+					*colorsB |= colorBit;
+				m_colorCount = Max(m_colorCount, color + 1);
+			}
+
+			m_batches[color].push_back(i);
+		}
+	}
+
+	size_t						GetColorCount() const				{ return m_colorCount; }
+	const std::vector<size_t>&	GetBatch(size_t color) const		{ return m_batches[color]; }
+	const std::vector<size_t>&	GetUncoloredBatch() const			{ return m_batches[MAX_CONSTRAINT_COLORS]; }
+
+	// true if a dynamic body is touched by at least one colored constraint
+	bool						IsBodyColored(size_t bodyIndex) const	{ return m_bodyColors[bodyIndex] != 0; }
+
+	// functor(constraintIndex), colors one after the other
+	template<typename TFunctor>
+	inline void	ForEach(CJobSystem& jobSystem, TFunctor functor) const
+	{
+		for (size_t color = 0; color < m_colorCount; ++color)
+		{
+			const std::vector<size_t>& batch = m_batches[color];
+			jobSystem.ParallelFor(batch.size(), CONSTRAINT_GRAIN_SIZE, [&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					functor(batch[i]);
+				}
+			});
+		}
+
+		for (size_t index : GetUncoloredBatch())
+		{
+			functor(index);
+		}
+	}
+
+private:
+	std::vector<std::vector<size_t>>	m_batches = std::vector<std::vector<size_t>>(MAX_CONSTRAINT_COLORS + 1);
+	std::vector<uint64_t>				m_bodyColors;
+	size_t								m_colorCount = 0;
+};
+
+#endif
@@ -0,0 +1,194 @@
+#ifndef _CONTACT_SOLVER_WIDE_H_
+#define _CONTACT_SOLVER_WIDE_H_
+
+#include <vector>
+
+#include "BodyStore.h"
+#include "Collision.h"
+#include "Simd.h"
+
+enum class ESolverPath : int
+{
+	Scalar = 0,
+	SSE4,
+	AVX8,
+
+	Count,
+};
+
+inline const char* GetSolverPathName(ESolverPath path)
+{
+	switch (path)
+	{
+	case ESolverPath::SSE4:	return "SSE x4";
+	case ESolverPath::AVX8:	return "AVX2 x8";
+	default:				return "Scalar";
+	}
+}
+
+inline bool IsSolverPathSupported(ESolverPath path)
+{
+	switch (path)
+	{
+	case ESolverPath::AVX8:	return IsAVX2Supported();
+	default:				return true;
+	}
+}
+
+// Velocity solve of up to TFloat::Width contacts at once, same maths as the scalar CCollisionResponse::SolveVelocity.
+// Contacts of a lane group must not share any dynamic body (one color batch), as results are scattered back without merging.
+template<typename TFloat>
+SIMD_KERNEL_INLINE void SolveVelocityWide(CBodyStore& bodies, std::vector<SCollision>& collisions, const size_t* indices, size_t count)
+{
+	const size_t W = TFloat::Width;
+
+	// pairs of static bodies are skipped as in the scalar path, lanes only hold contacts with a dynamic body
+	size_t dynamicIndices[W];
+	size_t dynamicCount = 0;
+	for (size_t i = 0; i < count; ++i)
+	{
+		const SCollision& collision = collisions[indices[i]];
+		if (bodies.masses[collision.GetBodyA()] != 0.0f || bodies.masses[collision.GetBodyB()] != 0.0f)
+		{
+			dynamicIndices[dynamicCount++] = indices[i];
+		}
+	}
+	if (dynamicCount == 0)
+		return;
+	indices = dynamicIndices;
+	count = dynamicCount;
+
+	// SoA gather, unused lanes are padded with a harmless contact
+	float vAx[W], vAy[W], wA[W], mA[W], rAx[W], rAy[W];
+	float vBx[W], vBy[W], wB[W], mB[W], rBx[W], rBy[W];
+	float nx[W], ny[W], lastN[W], lastT[W], restitution[W], friction[W];
+	float tx[W], ty[W], tangentMass[W], normalMass[W];
+
+	for (size_t lane = 0; lane < W; ++lane)
+	{
+		if (lane >= count)
+		{
+			vAx[lane] = vAy[lane] = wA[lane] = rAx[lane] = rAy[lane] = 0.0f;
+			vBx[lane] = vBy[lane] = wB[lane] = rBx[lane] = rBy[lane] = 0.0f;
+			mA[lane] = mB[lane] = 1.0f;
+			nx[lane] = 1.0f; ny[lane] = 0.0f;
+			lastN[lane] = lastT[lane] = restitution[lane] = friction[lane] = 0.0f;
+			continue;
+		}
+
+		const SCollision& collision = collisions[indices[lane]];
+		size_t bodyA = collision.GetBodyA();
+		size_t bodyB = collision.GetBodyB();
+
+		vAx[lane] = bodies.speeds[bodyA].x;	vAy[lane] = bodies.speeds[bodyA].y;	wA[lane] = bodies.angularVelocities[bodyA];	mA[lane] = bodies.masses[bodyA];
+		vBx[lane] = bodies.speeds[bodyB].x;	vBy[lane] = bodies.speeds[bodyB].y;	wB[lane] = bodies.angularVelocities[bodyB];	mB[lane] = bodies.masses[bodyB];
+		rAx[lane] = collision.point.x - bodies.positions[bodyA].x;	rAy[lane] = collision.point.y - bodies.positions[bodyA].y;
+		rBx[lane] = collision.point.x - bodies.positions[bodyB].x;	rBy[lane] = collision.point.y - bodies.positions[bodyB].y;
+		nx[lane] = collision.normal.x;	ny[lane] = collision.normal.y;
+		lastN[lane] = collision.lastNormalImpulse;
+		lastT[lane] = collision.lastTangentImpulse;
+		restitution[lane] = collision.restitution;
+		friction[lane] = collision.friction;
+	}
+
+	TFloat zero = TFloat::Zero();
+	TFloat one = TFloat(1.0f);
+
+	TFloat VAx = TFloat::Load(vAx), VAy = TFloat::Load(vAy), WA = TFloat::Load(wA), MA = TFloat::Load(mA);
+	TFloat VBx = TFloat::Load(vBx), VBy = TFloat::Load(vBy), WB = TFloat::Load(wB), MB = TFloat::Load(mB);
+	TFloat RAx = TFloat::Load(rAx), RAy = TFloat::Load(rAy), RBx = TFloat::Load(rBx), RBy = TFloat::Load(rBy);
+	TFloat Nx = TFloat::Load(nx), Ny = TFloat::Load(ny);
+	TFloat LastN = TFloat::Load(lastN), LastT = TFloat::Load(lastT);
+
+	// static bodies don't receive impulses
+	TFloat dynamicA = MA != zero;
+	TFloat dynamicB = MB != zero;
+
+	// Tangent impulse
+	TFloat Tx = (VBx - VAx) - Nx;
+	TFloat Ty = (VBy - VAy) - Ny;
+	TFloat tangentRelVel = -((VBx - VAx) * Tx + (VBy - VAy) * Ty);
+
+	TFloat TangentMass = MA + MB;
+	TFloat tangentImpulse = tangentRelVel / TangentMass;
+	TFloat maxFriction = TFloat::Abs(LastN) * TFloat::Load(friction);
+	TFloat newTangentImpulse = TFloat::Min(TFloat::Max(LastT + tangentImpulse, -maxFriction), maxFriction);
+	tangentImpulse = newTangentImpulse - LastT;
+	LastT = newTangentImpulse;
+
+	VAx += Tx * -tangentImpulse * MA;
+	VAy += Ty * -tangentImpulse * MA;
+	WA += TFloat::And(dynamicA, -tangentImpulse * (RAx * Ty - RAy * Tx));
+	VBx += Tx * tangentImpulse * MB;
+	VBy += Ty * tangentImpulse * MB;
+	WB += TFloat::And(dynamicB, tangentImpulse * (RBx * Ty - RBy * Tx));
+
+	// Normal impulse
+	TFloat momentumA = RAx * Ny - RAy * Nx;
+	TFloat momentumB = RBx * Ny - RBy * Nx;
+	TFloat NormalMass = MA + MB + momentumA * momentumA + momentumB * momentumB;
+
+	TFloat relVelX = (VBx - WB * RBy) - (VAx - WA * RAy);
+	TFloat relVelY = (VBy + WB * RBx) - (VAy + WA * RAx);
+	TFloat normalRelVel = relVelX * Nx + relVelY * Ny;
+
+	TFloat normalImpulse = -(TFloat::Load(restitution) + one) * normalRelVel / NormalMass;
+	TFloat newNormalImpulse = TFloat::Max(LastN + normalImpulse, zero);
+	normalImpulse = newNormalImpulse - LastN;
+	LastN = newNormalImpulse;
+
+	VAx += Nx * -normalImpulse * MA;
+	VAy += Ny * -normalImpulse * MA;
+	WA += TFloat::And(dynamicA, -normalImpulse * momentumA);
+	VBx += Nx * normalImpulse * MB;
+	VBy += Ny * normalImpulse * MB;
+	WB += TFloat::And(dynamicB, normalImpulse * momentumB);
+
+	// Scatter
+	VAx.Store(vAx); VAy.Store(vAy); WA.Store(wA);
+	VBx.Store(vBx); VBy.Store(vBy); WB.Store(wB);
+	LastN.Store(lastN); LastT.Store(lastT);
+	Tx.Store(tx); Ty.Store(ty);
+	TangentMass.Store(tangentMass); NormalMass.Store(normalMass);
+
+	for (size_t lane = 0; lane < count; ++lane)
+	{
+		SCollision& collision = collisions[indices[lane]];
+		size_t bodyA = collision.GetBodyA();
+		size_t bodyB = collision.GetBodyB();
+
+		if (mA[lane] != 0.0f)
+		{
+			bodies.speeds[bodyA] = Vec2(vAx[lane], vAy[lane]);
+			bodies.angularVelocities[bodyA] = wA[lane];
+		}
+		if (mB[lane] != 0.0f)
+		{
+			bodies.speeds[bodyB] = Vec2(vBx[lane], vBy[lane]);
+			bodies.angularVelocities[bodyB] = wB[lane];
+		}
+
+		collision.tangent = Vec2(tx[lane], ty[lane]);
+		collision.tangentMass = tangentMass[lane];
+		collision.normalMass = normalMass[lane];
+		collision.lastNormalImpulse = lastN[lane];
+		collision.lastTangentImpulse = lastT[lane];
+	}
+}
+
+// Lane group entry point, the SFloat8 one is compiled for AVX2
+template<typename TFloat>
+inline void SolveVelocityGroup(CBodyStore& bodies, std::vector<SCollision>& collisions, const size_t* indices, size_t count)
+{
+	SolveVelocityWide<TFloat>(bodies, collisions, indices, count);
+}
+
+#ifdef SIMD_AVX2
+template<>
+SIMD_AVX2_ENTRY inline void SolveVelocityGroup<SFloat8>(CBodyStore& bodies, std::vector<SCollision>& collisions, const size_t* indices, size_t count)
+{
+	SolveVelocityWide<SFloat8>(bodies, collisions, indices, count);
+}
+#endif
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef _FIXED_TIME_STEP_H_
+#define _FIXED_TIME_STEP_H_
+
+#include "Maths.h"
+
+// Accumulates frame time and converts it in a number of fixed duration simulation steps
+class CFixedTimeStep
+{
+public:
+	CFixedTimeStep(float frequency = 120.0f, size_t maxSubSteps = 8)
+		: m_deltaTime(1.0f / frequency), m_maxSubSteps(maxSubSteps){}
+
+	void	SetFrequency(float frequency)	{ m_deltaTime = 1.0f / frequency; }
+	float	GetFrequency() const			{ return 1.0f / m_deltaTime; }
+	float	GetDeltaTime() const			{ return m_deltaTime; }
+
+	void	SetMaxSubSteps(size_t maxSubSteps)	{ m_maxSubSteps = maxSubSteps; }
+	size_t	GetMaxSubSteps() const				{ return m_maxSubSteps; }
+
+	void	Reset()	{ m_accumulator = 0.0f; }
+
+	// Returns the number of steps to simulate for this frame.
+	// When more than maxSubSteps are due, the remaining time is dropped : simulation slows down instead of spiraling.
+	size_t	Advance(float frameTime)
+	{
+		m_accumulator += frameTime;
+
+		size_t stepCount = (size_t)(m_accumulator / m_deltaTime);
+		if (stepCount > m_maxSubSteps)
+		{
+			stepCount = m_maxSubSteps;
+			m_accumulator = m_deltaTime * (float)stepCount;
+		}
+
+		m_accumulator -= m_deltaTime * (float)stepCount;
+		m_accumulator = Clamp(m_accumulator, 0.0f, m_deltaTime);
+		return stepCount;
+	}
+
+	// Blend factor between previous and current simulated state, for rendering
+	float	GetAlpha() const
+	{
+		return Clamp(m_accumulator / m_deltaTime, 0.0f, 1.0f);
+	}
+
+private:
+	float	m_deltaTime;
+	size_t	m_maxSubSteps;
+	float	m_accumulator = 0.0f;
+};
+
+#endif
@@ -0,0 +1,187 @@
+#ifndef _FLUID_BENCHMARK_H_
+#define _FLUID_BENCHMARK_H_
+
+#include "FluidSystem.h"
+#include "GlobalVariables.h"
+#include "PhysicEngine.h"
+#include "Timer.h"
+#include "World.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#define FLUID_BENCHMARK_SPACING (1.0f / 15.0f)
+#define FLUID_BENCHMARK_BODY_COUNT 8
+
+enum class EFluidBenchmarkScenario : int
+{
+	DamBreak = 0,	// fluid column at the left of a box
+	Droplet,		// fluid disk falling in a shallow pool
+
+	Count,
+};
+
+inline const char* GetFluidBenchmarkScenarioName(EFluidBenchmarkScenario scenario)
+{
+	switch (scenario)
+	{
+	case EFluidBenchmarkScenario::Droplet:	return "droplet";
+	default:								return "dam break";
+	}
+}
+
+// Fills the fluid with about particleCount particles, the box is scaled with the particle count so density is the same for every size.
+// A row of squares in the low part of the box is added to world for the rigid body coupling.
+inline void	SetupFluidBenchmarkScenario(CFluidSystem& fluid, CWorld& world, EFluidBenchmarkScenario scenario, size_t particleCount)
+{
+	float spacing = FLUID_BENCHMARK_SPACING;
+	float area = (float)particleCount * spacing * spacing;
+
+	fluid.Reset();
+	fluid.SetCapacity(particleCount);
+	Vec2 min, max;
+
+	if (scenario == EFluidBenchmarkScenario::DamBreak)
+	{
+		// column is twice higher than wide, box is 4 columns wide and 3 high
+		float width = sqrtf(area * 0.5f);
+		min = Vec2(-2.0f * width, -1.5f * width);
+		max = Vec2(2.0f * width, 1.5f * width);
+		fluid.SetBounds(min, max);
+		fluid.Spawn(min, min + Vec2(width, 2.0f * width) - Vec2(spacing, spacing), 1.0f / spacing, Vec2());
+	}
+	else
+	{
+		// pool holds 3/4 of the particles, disk the remaining quarter
+		float width = sqrtf(area * 0.75f * 8.0f);
+		min = Vec2(-0.5f * width, -0.25f * width);
+		max = Vec2(0.5f * width, 0.5f * width);
+		fluid.SetBounds(min, max);
+		fluid.Spawn(min, min + Vec2(width, width * 0.125f) - Vec2(spacing, spacing), 1.0f / spacing, Vec2());
+
+		float radius = sqrtf(area * 0.25f / (float)M_PI);
+		size_t side = (size_t)(2.0f * radius / spacing) + 1;
+		std::vector<Vec2> disk;
+		for (size_t i = 0; i < side * side; ++i)
+		{
+			Vec2 offset(-radius + (float)(i % side) * spacing, -radius + (float)(i / side) * spacing);
+			if (offset.GetSqrLength() <= radius * radius)
+			{
+				disk.push_back(Vec2(0.0f, 0.5f * width - radius - spacing) + offset);
+			}
+		}
+
+		fluid.Emit(disk.size(), [&](size_t i, Vec2& pos, Vec2& vel)
+		{
+			pos = disk[i];
+			vel = Vec2();
+		});
+	}
+
+	float bodySpacing = (max.x - min.x) / (float)FLUID_BENCHMARK_BODY_COUNT;
+	for (size_t i = 0; i < FLUID_BENCHMARK_BODY_COUNT; ++i)
+	{
+		CPolygonPtr body = world.AddSquare(bodySpacing * 0.25f);
+		body->SetPosition(Vec2(min.x + ((float)i + 0.5f) * bodySpacing, min.y + (max.y - min.y) * 0.1f));
+	}
+}
+
+// Benchmark option : "sph" or "pbf" sets the solver, "exact" or "tabulated" the kernel evaluation. false if option is none of them
+inline bool	ParseFluidBenchmarkOption(const std::string& option, EFluidSolver& solver, EKernelEvaluation& evaluation)
+{
+	if (option == "sph" || option == "pbf")
+		solver = (option == "pbf") ? EFluidSolver::PositionBased : EFluidSolver::SPH;
+	else if (option == "exact" || option == "tabulated")
+		evaluation = (option == "tabulated") ? EKernelEvaluation::Tabulated : EKernelEvaluation::Exact;
+	else
+		return false;
+	return true;
+}
+
+// Runs every scenario at 10k, 100k and 1M particles without window with the given solver and kernel evaluation, and prints per stage timings.
+// Particles per second counts each particle once per substep. World bodies are not stepped, they only give the coupling its work :
+// its time is compared to the SPH step one (every other stage).
+inline int	RunFluidBenchmark(size_t frameCount, EFluidSolver solver = EFluidSolver::SPH, EKernelEvaluation evaluation = EKernelEvaluation::Exact)
+{
+	SGlobalVariables globals = SGlobalVariables();
+	CPhysicEngine physicEngine;
+	globals.pPhysicEngine = &physicEngine;
+	gVars = &globals;
+
+	CFluidSystem& fluid = CFluidSystem::Get();
+	EFluidSolver previousSolver = fluid.GetSolver();
+	EKernelEvaluation previousEvaluation = fluid.GetKernelEvaluation();
+	fluid.SetSolver(solver);
+	if (evaluation != previousEvaluation)
+	{
+		fluid.SetKernelEvaluation(evaluation);
+	}
+	const size_t particleCounts[] = { 10000, 100000, 1000000 };
+
+	for (int scenario = 0; scenario < (int)EFluidBenchmarkScenario::Count; ++scenario)
+	{
+		for (size_t particleCount : particleCounts)
+		{
+			CWorld world;
+			gVars->pWorld = &world;
+			SetupFluidBenchmarkScenario(fluid, world, (EFluidBenchmarkScenario)scenario, particleCount);
+
+			float stageTimes[(int)EFluidStage::Count] = {};
+			size_t subStepCount = 0;
+			double particleSteps = 0.0;
+
+			CTimer timer;
+			timer.Start();
+			for (size_t frame = 0; frame < frameCount; ++frame)
+			{
+				fluid.Update(1.0f / 60.0f);
+
+				const SFluidStepStats& stats = fluid.GetStepStats();
+				for (int stage = 0; stage < (int)EFluidStage::Count; ++stage)
+				{
+					stageTimes[stage] += stats.stageTimes[stage];
+				}
+				subStepCount += stats.subStepCount;
+				particleSteps += (double)fluid.GetParticleCount() * (double)stats.subStepCount;
+			}
+			timer.Stop();
+
+			float duration = Max(timer.GetDuration(), FLT_MIN);
+			std::cout << GetFluidBenchmarkScenarioName((EFluidBenchmarkScenario)scenario) << " " << fluid.GetParticleCount() << " particles, "
+				<< GetFluidSolverName(fluid.GetSolver()) << ", " << GetKernelEvaluationName(fluid.GetKernelEvaluation()) << ", " << frameCount << " frames : "
+				<< (duration * 1000.0f / (float)frameCount) << " ms/frame, "
+				<< ((float)subStepCount / (float)frameCount) << " substeps/frame, "
+				<< (particleSteps / (double)duration / 1000000.0) << " M particles/s" << std::endl;
+
+			std::cout << "   ";
+			for (int stage = 0; stage < (int)EFluidStage::Count; ++stage)
+			{
+				std::cout << " " << GetFluidStageName((EFluidStage)stage) << " " << (stageTimes[stage] * 1000.0f / (float)frameCount) << " ms";
+			}
+			std::cout << std::endl;
+
+			float couplingTime = stageTimes[(int)EFluidStage::Coupling];
+			float sphStepTime = 0.0f;
+			for (int stage = 0; stage < (int)EFluidStage::Coupling; ++stage)
+			{
+				sphStepTime += stageTimes[stage];
+			}
+			std::cout << "    SPH step " << (sphStepTime * 1000.0f / (float)frameCount) << " ms, coupling with " << world.GetPolygonCount()
+				<< " bodies " << (couplingTime * 1000.0f / (float)frameCount) << " ms ("
+				<< (couplingTime * 100.0f / Max(sphStepTime, FLT_MIN)) << " % of SPH step)" << std::endl;
+			gVars->pWorld = nullptr;
+		}
+	}
+
+	fluid.Reset();
+	fluid.SetSolver(previousSolver);
+	if (evaluation != previousEvaluation)
+	{
+		fluid.SetKernelEvaluation(previousEvaluation);
+	}
+	gVars = nullptr;
+	return 0;
+}
+
+#endif
@@ -0,0 +1,149 @@
+#ifndef _FLUID_KERNELS_H_
+#define _FLUID_KERNELS_H_
+
+#include "Maths.h"
+#include "Simd.h"
+
+#include <vector>
+
+// SPH smoothing kernel constants, computed once per smoothing radius instead of at each evaluation
+struct SKernelConstants
+{
+	SKernelConstants() = default;
+	SKernelConstants(float radius)
+	{
+		float pi = (float)M_PI;
+		float h2 = radius * radius;
+		float h4 = h2 * h2;
+		float h5 = h4 * radius;
+
+		h = radius;
+		sqrH = h2;
+		defaultScale = 4.0f / (pi * h4 * h4);
+		defaultGradientScale = 6.0f / (pi * h4 * h4);
+		spikyGradientScale = -15.0f / (pi * h5);
+		spiky2DGradientScale = -30.0f / (pi * h5);
+		viscosityLaplacianScale = 30.0f / (pi * h5);
+		poly6hGradientScale = 24.0f / (pi * h4 * h2 * radius);
+	}
+
+	float	h = 0.0f;
+	float	sqrH = 0.0f;
+	float	defaultScale = 0.0f;
+	float	defaultGradientScale = 0.0f;
+	float	spikyGradientScale = 0.0f;
+	float	spiky2DGradientScale = 0.0f;
+	float	viscosityLaplacianScale = 0.0f;
+	float	poly6hGradientScale = 0.0f;
+};
+
+// Kernels are templates evaluated on float or on SIMD batches (SFloat4, SFloat8), r is the particle distance
+
+// Default kernel only depends on the squared distance, no sqrt is needed
+template<typename T>
+SIMD_KERNEL_INLINE T	KernelDefaultSqr(const T& sqrR, const SKernelConstants& c)
+{
+	T kernel = T(c.sqrH) - sqrR;
+	return kernel * kernel * kernel * T(c.defaultScale);
+}
+
+template<typename T>
+SIMD_KERNEL_INLINE T	KernelDefault(const T& r, const SKernelConstants& c)
+{
+	return KernelDefaultSqr(r * r, c);
+}
+
+template<typename T>
+SIMD_KERNEL_INLINE T	KernelDefaultGradientFactor(const T& r, const SKernelConstants& c)
+{
+	T kernel = T(c.sqrH) - r * r;
+	return -(kernel * kernel * T(c.defaultGradientScale));
+}
+
+template<typename T>
+SIMD_KERNEL_INLINE T	KernelDefaultLaplacian(const T& r, const SKernelConstants& c)
+{
+	T kernel = T(c.sqrH) - r * r;
+	return -(kernel * kernel * T(c.defaultGradientScale)) * (T(3.0f * c.sqrH) - T(7.0f) * r * r);
+}
+
+template<typename T>
+SIMD_KERNEL_INLINE T	KernelSpikyGradientFactorNorm(const T& r, const SKernelConstants& c)
+{
+	T kernel = T(c.h) - r;
+	return kernel * kernel * T(c.spikyGradientScale);
+}
+
+template<typename T>
+SIMD_KERNEL_INLINE T	KernelSpikyGradientFactor(const T& r, const SKernelConstants& c)
+{
+	T kernel = T(c.h) - r;
+	return kernel * kernel * T(c.spikyGradientScale) / r;
+}
+
+// Spiky gradient normalized for 2D, for solvers that need gradients consistent with KernelDefault densities
+template<typename T>
+SIMD_KERNEL_INLINE T	KernelSpiky2DGradientFactor(const T& r, const SKernelConstants& c)
+{
+	T kernel = T(c.h) - r;
+	return kernel * kernel * T(c.spiky2DGradientScale) / r;
+}
+
+template<typename T>
+SIMD_KERNEL_INLINE T	KernelViscosityLaplacian(const T& r, const SKernelConstants& c)
+{
+	return (T(c.h) - r) * T(c.viscosityLaplacianScale);
+}
+
+template<typename T>
+SIMD_KERNEL_INLINE T	KernelPoly6hGradientFactor(const T& r, const SKernelConstants& c)
+{
+	T kernel = T(c.sqrH) - r * r;
+	return kernel * kernel * T(c.poly6hGradientScale) / r;
+}
+
+// Kernels of r sampled on the squared distance over [0, h^2] and read with a linear interpolation :
+// evaluation needs neither sqrt nor division. Error grows where kernels are steep in r^2 (close to 0).
+// ChannelCount kernels are interleaved, so a lookup computes one index and reads one cache line.
+template<size_t ChannelCount>
+struct SKernelTable
+{
+	// kernels(r, outValues) is sampled for r in [minR, h]
+	template<typename TKernels>
+	void	Build(size_t sampleCount, const SKernelConstants& c, float minR, TKernels kernels)
+	{
+		m_scale = (float)sampleCount / c.sqrH;
+
+		// one extra sample so the last interval can be interpolated, one more for sqrR == h^2
+		m_samples.resize((sampleCount + 2) * ChannelCount);
+		for (size_t i = 0; i <= sampleCount; ++i)
+		{
+			float r = Clamp(sqrtf((float)i / m_scale), minR, c.h);
+			kernels(r, &m_samples[i * ChannelCount]);
+		}
+		for (size_t channel = 0; channel < ChannelCount; ++channel)
+		{
+			m_samples[(sampleCount + 1) * ChannelCount + channel] = m_samples[sampleCount * ChannelCount + channel];
+		}
+	}
+
+	// sqrR must be in [0, h^2]
+	inline void	Lookup(float sqrR, float* outValues) const
+	{
+		float position = sqrR * m_scale;
+		size_t index = (size_t)position;
+		float t = position - (float)index;
+
+		const float* samples = &m_samples[index * ChannelCount];
+		for (size_t channel = 0; channel < ChannelCount; ++channel)
+		{
+			outValues[channel] = samples[channel] + (samples[ChannelCount + channel] - samples[channel]) * t;
+		}
+	}
+
+private:
+	std::vector<float>	m_samples;
+	float				m_scale = 0.0f;
+};
+
+#endif
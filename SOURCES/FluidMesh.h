@@ -3,117 +3,185 @@
 
 #include <GL/glew.h>
 
+#include <cstring>
+
+#include "Maths.h"
+
+#define FLUID_MESH_RING_SIZE 3
+#define FLUID_MESH_MIN_CAPACITY 1024
+
+// Streams particle positions to the GPU each frame, drawn as points of a single color.
+// Vertices are 2 floats, the buffer is a ring of FLUID_MESH_RING_SIZE segments : a frame writes a segment
+// the GPU has finished drawing (fence), so uploads never wait for the previous draw.
+// With ARB_buffer_storage the ring is mapped once (persistent and coherent), otherwise segments are written with glBufferSubData.
 class CFluidMesh
 {
 public:
+	~CFluidMesh()
+	{
+		Destroy();
+	}
 
+	void SetColor(float r, float g, float b)
+	{
+		m_color[0] = r;
+		m_color[1] = g;
+		m_color[2] = b;
+	}
 
-	template<class TFunctor>
-	void Fill(size_t count, TFunctor functor)
+	void Upload(const Vec2* positions, size_t count)
 	{
-		if (count > m_size)
+		m_count = count;
+		if (count == 0)
 		{
-			SetSize(count);
+			return;
 		}
 
-		float* vertices = Lock();
-		size_t stride = 6;
-
-		for (size_t i = 0; i < m_size; ++i)
+		if (count > m_capacity)
 		{
-			vertices[stride * i + 2] = 0.0f;
-			functor(i, vertices[stride * i], vertices[stride * i + 1], vertices[stride * i + 3], vertices[stride * i + 4], vertices[stride * i + 5]);
+			// geometric growth, buffer is rarely recreated while particles are emitted
+			size_t capacity = Max(m_capacity, (size_t)FLUID_MESH_MIN_CAPACITY);
+			while (capacity < count)
+			{
+				capacity *= 2;
+			}
+			Create(capacity);
 		}
 
-		Unlock();
+		m_segment = (m_segment + 1) % FLUID_MESH_RING_SIZE;
+		WaitSegment(m_segment);
+
+		size_t size = sizeof(Vec2) * count;
+		if (m_mappedVertices)
+		{
+			memcpy(m_mappedVertices + GetSegmentOffset(m_segment), positions, size);
+		}
+		else
+		{
+			glBindBuffer(GL_ARRAY_BUFFER, m_vertexBufferId);
+			glBufferSubData(GL_ARRAY_BUFFER, GetSegmentOffset(m_segment), size, positions);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+		}
 	}
 
 	void Draw()
 	{
-		if (m_size == 0)
+		if (m_count == 0)
 		{
 			return;
 		}
 
-		size_t stride = 6;
-
 		glPushMatrix();
 		glTranslatef(0.0f, 0.0f, -1.0f);
 
 		glPointSize(4.0f);
+		glColor3f(m_color[0], m_color[1], m_color[2]);
 
 		glBindBuffer(GL_ARRAY_BUFFER, m_vertexBufferId);
 
 		glEnableClientState(GL_VERTEX_ARRAY);
-		glVertexPointer(3, GL_FLOAT, stride * sizeof(float), (void*)0);
+		glVertexPointer(2, GL_FLOAT, sizeof(Vec2), (void*)GetSegmentOffset(m_segment));
 
-		glEnableClientState(GL_COLOR_ARRAY);
-		glColorPointer(3, GL_FLOAT, stride * sizeof(float), ((float*)0) + 3);
+		glDrawArrays(GL_POINTS, 0, (GLsizei)m_count);
 
-		glDrawArrays(GL_POINTS, 0, m_size);
-
-		glDisableClientState(GL_COLOR_ARRAY);
 		glDisableClientState(GL_VERTEX_ARRAY);
 
-
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
 
 		glPopMatrix();
+
+		// segment can be written again once this draw is done
+		if (m_fences[m_segment])
+		{
+			glDeleteSync(m_fences[m_segment]);
+		}
+		m_fences[m_segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
 	}
 
 private:
-	void SetSize(size_t size)
+	size_t GetSegmentOffset(size_t segment) const
 	{
-		if (m_size != size)
-		{
-			m_size = size;
-			Destroy();
-			Create();
-		}
+		return segment * m_capacity * sizeof(Vec2);
 	}
 
-	void Create()
+	void WaitSegment(size_t segment)
 	{
-		if (m_size == 0)
+		GLsync fence = m_fences[segment];
+		if (!fence)
 		{
 			return;
 		}
 
-		size_t stride = 6;
+		// flush once, then wait (1 ms per try) : only happens when the GPU is more than FLUID_MESH_RING_SIZE - 1 frames late
+		GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+		while (glClientWaitSync(fence, flags, 1000000) == GL_TIMEOUT_EXPIRED)
+		{
+			flags = 0;
+		}
 
-		glGenBuffers(1, &m_vertexBufferId);
+		glDeleteSync(fence);
+		m_fences[segment] = nullptr;
+	}
+
+	void Create(size_t capacity)
+	{
+		Destroy();
+		m_capacity = capacity;
+
+		GLsizeiptr size = (GLsizeiptr)(GetSegmentOffset(FLUID_MESH_RING_SIZE));
 
+		glGenBuffers(1, &m_vertexBufferId);
 		glBindBuffer(GL_ARRAY_BUFFER, m_vertexBufferId);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(float) * stride * m_size, nullptr, GL_STATIC_DRAW);
+
+		if (GLEW_ARB_buffer_storage)
+		{
+			GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, flags);
+			m_mappedVertices = (char*)glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags);
+		}
+		else
+		{
+			glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STREAM_DRAW);
+		}
 
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
 	}
 
 	void Destroy()
 	{
+		for (GLsync& fence : m_fences)
+		{
+			if (fence)
+			{
+				glDeleteSync(fence);
+				fence = nullptr;
+			}
+		}
+
 		if (m_vertexBufferId != 0)
 		{
+			if (m_mappedVertices)
+			{
+				glBindBuffer(GL_ARRAY_BUFFER, m_vertexBufferId);
+				glUnmapBuffer(GL_ARRAY_BUFFER);
+				glBindBuffer(GL_ARRAY_BUFFER, 0);
+				m_mappedVertices = nullptr;
+			}
+
 			glDeleteBuffers(1, &m_vertexBufferId);
 			m_vertexBufferId = 0;
 		}
-	}
-
-	float*	Lock()
-	{
-		glBindBuffer(GL_ARRAY_BUFFER, m_vertexBufferId);
-		return (float*)glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
-	}
-
-	void Unlock()
-	{
-		glUnmapBuffer(GL_ARRAY_BUFFER);
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		m_capacity = 0;
 	}
 
 private:
-	size_t				m_size = 0;
-	GLuint				m_vertexBufferId = 0;
-	
+	size_t	m_capacity = 0; // vertices per ring segment
+	size_t	m_count = 0;
+	size_t	m_segment = 0;
+	GLuint	m_vertexBufferId = 0;
+	char*	m_mappedVertices = nullptr;
+	GLsync	m_fences[FLUID_MESH_RING_SIZE] = {};
+	float	m_color[3] = { 0.0f, 0.0f, 1.0f };
 };
 
-#endif
\ No newline at end of file
+#endif
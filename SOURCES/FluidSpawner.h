@@ -4,7 +4,7 @@
 #include "Behavior.h"
 #include "FluidSystem.h"
 #include "GlobalVariables.h"
-#include "Renderer.h"
+#include "IRenderer.h"
 #include "RenderWindow.h"
 #include "World.h"
 
@@ -21,6 +21,13 @@ private:
 			CFluidSystem::Get().Spawn(mousePoint - Vec2(0.5f, 0.5f), mousePoint + Vec2(0.5f, 0.5f), 10.0f, Vec2(15.0f, 15.0f));
 		}
 		m_clicking = clicking;
+
+		// right click drains the fluid, so the particle pool can be refilled
+		if (gVars->pRenderWindow->GetMouseButton(2))
+		{
+			Vec2 mousePoint = gVars->pRenderer->ScreenToWorldPos(gVars->pRenderWindow->GetMousePos());
+			CFluidSystem::Get().KillParticles(mousePoint, 0.5f);
+		}
 	}
 
 	bool m_clicking = false;
@@ -1,17 +1,76 @@
 #include "FluidSystem.h"
 
-#include "Renderer.h"
 #include "GlobalVariables.h"
+#include "PhysicEngine.h"
+#include "Profiler.h"
+#include "World.h"
+#include "Timer.h"
 
+#include <cassert>
+#include <cmath>
 #include <string>
 
 
 CFluidSystem::CFluidSystem()
+{
+	ComputeConstants();
+	ResizeParticles(0);
+}
+
+void	CFluidSystem::ComputeConstants()
 {
 	float particuleRadius = m_radius / m_particleRadiusRatio;
 	float volume = particuleRadius * particuleRadius * (float)M_PI;
 	m_mass = volume * m_restDensity;
 	m_minRadius = m_radius * 0.1f;
+
+	m_kernel = SKernelConstants(m_radius);
+	m_surfaceKernel = SKernelConstants(m_radius * 1.5f);
+
+	// PBF enforces rest density strictly, it is taken from a regular particle lattice so spawned blocks are at rest
+	int latticeExtent = (int)m_particleRadiusRatio;
+	m_pbfRestDensity = 0.0f;
+	for (int x = -latticeExtent; x <= latticeExtent; ++x)
+	{
+		for (int y = -latticeExtent; y <= latticeExtent; ++y)
+		{
+			float length = Vec2((float)x, (float)y).GetLength() * particuleRadius;
+			if (length < m_radius)
+			{
+				m_pbfRestDensity += m_mass * KernelDefault(length, m_kernel);
+			}
+		}
+	}
+
+	if (m_kernelEvaluation == EKernelEvaluation::Tabulated)
+	{
+		const SKernelConstants& kernel = m_kernel;
+		m_pressureKernelTable.Build(m_kernelTableSize, kernel, m_minRadius, [&](float r, float* outValues)
+		{
+			outValues[0] = KernelSpikyGradientFactor(r, kernel);
+			outValues[1] = KernelSpikyGradientFactor(r * 0.8f, kernel);
+			outValues[2] = KernelViscosityLaplacian(r, kernel);
+		});
+	}
+}
+
+void	CFluidSystem::SetRadius(float radius)
+{
+	m_radius = radius;
+	ComputeConstants();
+}
+
+void	CFluidSystem::SetParticleRadiusRatio(float ratio)
+{
+	m_particleRadiusRatio = ratio;
+	ComputeConstants();
+}
+
+void	CFluidSystem::SetKernelEvaluation(EKernelEvaluation evaluation, size_t sampleCount)
+{
+	m_kernelEvaluation = evaluation;
+	m_kernelTableSize = sampleCount;
+	ComputeConstants();
 }
 
 void	CFluidSystem::SetBounds(const Vec2& min, const Vec2& max)
@@ -20,17 +79,20 @@ void	CFluidSystem::SetBounds(const Vec2& min, const Vec2& max)
 	m_max = max;
 }
 
+void	CFluidSystem::SetCapacity(size_t capacity)
+{
+	CompactParticles();
+	m_capacity = capacity;
+	ResizeParticles(Min(m_positions.size(), capacity));
+}
+
 void	CFluidSystem::SpawnParticule(const Vec2& pos, const Vec2& vel)
 {
-	m_positions.push_back(pos);
-	m_velocities.push_back(vel);
-	m_accelerations.push_back(Vec2());
-	m_densities.push_back(0.0f);
-	m_pressures.push_back(0.0f);
-	m_surfaceNormals.push_back(Vec2());
-	m_surfaceCurvatures.push_back(0.0f);
-	m_keys.push_back(0);
-	m_proxies.push_back(SParticleProxy(m_proxies.size()));
+	Emit(1, [&](size_t i, Vec2& outPos, Vec2& outVel)
+	{
+		outPos = pos;
+		outVel = vel;
+	});
 }
 
 void	CFluidSystem::Spawn(const Vec2& min, const Vec2& max, float particulesPerMeter, const Vec2& speed)
@@ -41,126 +103,420 @@ void	CFluidSystem::Spawn(const Vec2& min, const Vec2& max, float particulesPerMe
 	float height = max.y - min.y;
 	size_t vertiCount = (size_t)(height * particulesPerMeter) + 1;
 
-	size_t count = horiCount * vertiCount;
+	Emit(horiCount * vertiCount, [&](size_t i, Vec2& outPos, Vec2& outVel)
+	{
+		outPos.x = min.x + ((float)(i / vertiCount)) / particulesPerMeter;
+		outPos.y = min.y + ((float)(i % vertiCount)) / particulesPerMeter;
+		outVel = speed;
+	});
+}
 
-	m_positions.reserve(m_positions.size() + count);
-	m_velocities.reserve(m_velocities.size() + count);
-	m_accelerations.reserve(m_accelerations.size() + count);
-	m_densities.reserve(m_densities.size() + count);
-	m_pressures.reserve(m_pressures.size() + count);
+void	CFluidSystem::KillParticle(size_t index)
+{
+	m_killedCount += (size_t)(m_killed[index] == 0);
+	m_killed[index] = 1;
+}
 
-	for (size_t i = 0; i < horiCount; ++i)
+void	CFluidSystem::KillParticles(const Vec2& center, float radius)
+{
+	for (size_t i = 0; i < m_positions.size(); ++i)
 	{
-		for (size_t j = 0; j < vertiCount; ++j)
+		if ((m_positions[i] - center).GetSqrLength() <= radius * radius)
 		{
-			float x = min.x + ((float)i) / particulesPerMeter;
-			float y = min.y + ((float)j) / particulesPerMeter;
-
-			SpawnParticule(Vec2(x, y), speed);
+			KillParticle(i);
 		}
 	}
 }
 
+void	CFluidSystem::ResizeParticles(size_t count)
+{
+	// whole capacity is reserved, so emission never reallocates and memory stays bounded
+	size_t capacity = Max(m_capacity, count);
+	m_positions.reserve(capacity);
+	m_velocities.reserve(capacity);
+	m_accelerations.reserve(capacity);
+	m_densities.reserve(capacity);
+	m_pressures.reserve(capacity);
+	m_surfaceNormals.reserve(capacity);
+	m_surfaceCurvatures.reserve(capacity);
+	m_previousPositions.reserve(capacity);
+	m_cellKeys.reserve(capacity);
+	m_sortedParticles.reserve(capacity);
+	m_killed.reserve(capacity);
+	m_reorderBuffer.reserve(capacity);
+
+	m_positions.resize(count);
+	m_velocities.resize(count);
+	m_accelerations.resize(count);
+	m_densities.resize(count);
+	m_pressures.resize(count);
+	m_surfaceNormals.resize(count);
+	m_surfaceCurvatures.resize(count);
+	m_previousPositions.resize(count);
+	m_cellKeys.resize(count);
+	m_sortedParticles.resize(count);
+	m_killed.resize(count);
+}
 
-void CFluidSystem::Update(float dt)
+template<typename T>
+void	CFluidSystem::CompactArray(std::vector<T>& array) const
 {
-	gVars->pRenderer->DisplayText("Particules : " + std::to_string(m_positions.size()));
+	// every per particle array is resized with the particle count
+	assert(array.size() == m_killed.size());
 
-	dt *= m_timeScale;
-	dt = Min(dt, 1.0f / (200.0f * m_timeScale)); // clamp d for stability, better have slow simulation than exploding simulation
+	size_t count = 0;
+	for (size_t i = 0; i < array.size(); ++i)
+	{
+		array[count] = array[i];
+		count += (size_t)(m_killed[i] == 0);
+	}
+	array.resize(count);
+}
 
-	ResetAccelerations();
+void	CFluidSystem::CompactParticles()
+{
+	if (m_killedCount == 0)
+		return;
+
+	// per particle arrays only, grid and neighbor data are rebuilt at each step
+	CompactArray(m_positions);
+	CompactArray(m_velocities);
+	CompactArray(m_accelerations);
+	CompactArray(m_densities);
+	CompactArray(m_pressures);
+	CompactArray(m_surfaceNormals);
+	CompactArray(m_surfaceCurvatures);
+	CompactArray(m_previousPositions);
+
+	m_killed.assign(m_positions.size(), 0);
+	m_killedCount = 0;
+	m_cellKeys.resize(m_positions.size());
+	m_sortedParticles.resize(m_positions.size());
+}
 
-	FindContacts();
-	ComputeDensity();
-	ComputePressure();
-	ComputeSurfaceTension();
 
-	AddPressureForces();
-	AddViscosityForces();
+void CFluidSystem::Update(float dt)
+{
+	PROFILE_ZONE("FluidSystem::Update");
+	dt *= m_timeScale;
 
-	ApplyForces(dt);
-	Integrate(dt);
+	CompactParticles();
 
-	BorderCollisions();
+	m_stepStats = SFluidStepStats();
+	float maxTimeStep = (m_solver == EFluidSolver::PositionBased) ? m_pbfMaxTimeStep : m_maxTimeStep;
+	float remainingTime = dt;
+	while (remainingTime > 0.0f && m_stepStats.subStepCount < m_maxSubSteps)
+	{
+		// remaining time is split in equal steps, so there is no tiny last step
+		float stepCount = ceilf(remainingTime / ComputeTimeStep(maxTimeStep));
+		float timeStep = remainingTime / stepCount;
+		remainingTime = (stepCount > 1.0f) ? remainingTime - timeStep : 0.0f;
 
-	FillMesh();
-	m_mesh.Draw();
+		if (m_solver == EFluidSolver::PositionBased)
+		{
+			StepPositionBased(timeStep);
+		}
+		else
+		{
+			StepSPH(timeStep);
+		}
+
+		TimeStage(EFluidStage::Coupling, [&]() { RigidBodyCollisions(); });
+
+		m_stepStats.minTimeStep = (m_stepStats.subStepCount == 0) ? timeStep : Min(m_stepStats.minTimeStep, timeStep);
+		m_stepStats.maxTimeStep = Max(m_stepStats.maxTimeStep, timeStep);
+		++m_stepStats.subStepCount;
+	}
 }
 
-void	CFluidSystem::ResetAccelerations()
+bool	CFluidSystem::IsFinite() const
 {
-	for (Vec2& acc : m_accelerations)
+	for (size_t i = 0; i < m_positions.size(); ++i)
 	{
-		acc = Vec2();
+		if (!std::isfinite(m_positions[i].x) || !std::isfinite(m_positions[i].y)
+			|| !std::isfinite(m_velocities[i].x) || !std::isfinite(m_velocities[i].y))
+		{
+			return false;
+		}
 	}
+	return true;
 }
 
-void	CFluidSystem::ComputeKeys()
+float	CFluidSystem::ComputeTimeStep(float maxTimeStep) const
 {
-	float h = m_radius * 2;
+	float maxSqrSpeed = 0.0f;
+	float maxSqrAcceleration = 0.0f;
+	for (size_t i = 0; i < m_velocities.size(); ++i)
+	{
+		maxSqrSpeed = Max(maxSqrSpeed, m_velocities[i].GetSqrLength());
+		maxSqrAcceleration = Max(maxSqrAcceleration, m_accelerations[i].GetSqrLength());
+	}
 
-	size_t shift = (sizeof(int) * 8) / 2;
+	// accelerations of last step, gravity is not stored in them
+	float maxSpeed = sqrtf(maxSqrSpeed);
+	float maxAcceleration = sqrtf(maxSqrAcceleration) + m_gravity.GetLength();
 
-	for (size_t i = 0; i < m_positions.size(); ++i)
+	float timeStep = maxTimeStep;
+	if (maxSpeed > 0.0f)
+	{
+		timeStep = Min(timeStep, m_cflFactor * m_radius / maxSpeed);
+	}
+	if (maxAcceleration > 0.0f)
 	{
-		Vec2 pos = m_positions[i];
-		int key = (int)floor(pos.y / h) + (((int)floor(pos.x / h)) << shift);
-		m_keys[i] = key;
+		timeStep = Min(timeStep, m_forceFactor * sqrtf(m_radius / maxAcceleration));
 	}
+	return Max(timeStep, m_minTimeStep);
 }
 
-int		CFluidSystem::GetRightKey(int key)
+template<typename TFunctor>
+void	CFluidSystem::TimeStage(EFluidStage stage, TFunctor functor)
 {
-	size_t shift = (sizeof(int) * 8) / 2;
-	return key + (1 << shift);
+	PROFILE_ZONE(GetFluidStageName(stage));
+	CTimer timer;
+	timer.Start();
+	functor();
+	timer.Stop();
+	m_stepStats.stageTimes[(int)stage] += timer.GetDuration();
 }
 
-int		CFluidSystem::GetTopKey(int key)
+void	CFluidSystem::StepSPH(float dt)
 {
-	return key + 1;
+	TimeStage(EFluidStage::Neighbors, [&]()
+	{
+		ResetAccelerations();
+		FindContacts();
+	});
+
+	TimeStage(EFluidStage::Density, [&]()
+	{
+		ComputeDensityPressure();
+		if (m_surfaceTension)
+		{
+			ComputeSurfaceTension();
+		}
+	});
+
+	TimeStage(EFluidStage::Forces, [&]() { AddPressureViscosityForces(); });
+
+	TimeStage(EFluidStage::Integration, [&]()
+	{
+		ApplyForces(dt);
+		Integrate(dt);
+		BorderCollisions();
+	});
 }
 
+void	CFluidSystem::StepPositionBased(float dt)
+{
+	size_t count = m_positions.size();
+	m_lambdas.resize(count);
+	m_positionDeltas.resize(count);
+
+	// predict positions from external forces
+	TimeStage(EFluidStage::Integration, [&]()
+	{
+		ResetAccelerations();
+		ApplyForces(dt);
+		m_previousPositions.assign(m_positions.begin(), m_positions.end());
+		Integrate(dt);
+	});
+
+	// neighbors of predicted positions, kept during iterations (gather lists are always needed here)
+	TimeStage(EFluidStage::Neighbors, [&]()
+	{
+		ComputeGrid();
+		ComputeKeys();
+		SortParticles();
+		if (m_framesSinceReorder++ >= m_reorderInterval)
+		{
+			ReorderParticles();
+			m_framesSinceReorder = 0;
+		}
+		BuildNeighborLists();
+		m_neighborGradients.resize(m_neighborIndices.size());
+	});
 
-void	CFluidSystem::UpdateProxies()
+	TimeStage(EFluidStage::Density, [&]()
+	{
+		for (size_t iteration = 0; iteration < m_pbfIterations; ++iteration)
+		{
+			ComputeLambdas();
+			ApplyDensityCorrections();
+		}
+	});
+
+	TimeStage(EFluidStage::Integration, [&]()
+	{
+		float invDt = 1.0f / dt;
+		gVars->pPhysicEngine->GetJobSystem().ParallelFor(count, FLUID_GRAIN_SIZE, [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				m_velocities[i] = (m_positions[i] - m_previousPositions[i]) * invDt;
+			}
+		});
+	});
+
+	TimeStage(EFluidStage::Forces, [&]() { ApplyXSPHViscosity(); });
+
+	TimeStage(EFluidStage::Integration, [&]()
+	{
+		ClampArray(m_velocities, m_maxSpeed);
+		BorderCollisions();
+	});
+}
+
+void	CFluidSystem::Reset()
 {
-	for (int a = m_proxies.size() - 2; a >= 0; --a)
+	m_positions.clear();
+	m_velocities.clear();
+	m_accelerations.clear();
+	m_densities.clear();
+	m_pressures.clear();
+	m_surfaceNormals.clear();
+	m_surfaceCurvatures.clear();
+	m_previousPositions.clear();
+	m_cellKeys.clear();
+	m_sortedParticles.clear();
+	m_killed.clear();
+	m_killedCount = 0;
+	m_neighborStarts.clear();
+	m_neighborIndices.clear();
+	m_neighborLengths.clear();
+	m_contacts.clear();
+	m_gridWidth = m_gridHeight = 0;
+	m_framesSinceReorder = 0;
+	m_stepStats = SFluidStepStats();
+}
+
+void	CFluidSystem::ResetAccelerations()
+{
+	gVars->pPhysicEngine->GetJobSystem().ParallelFor(m_accelerations.size(), FLUID_GRAIN_SIZE, [&](size_t begin, size_t end)
 	{
-		// insert a in sorted [a + 1, last]
-		SParticleProxy aProxy = m_proxies[a];
-		size_t b = (size_t)a + 1;
-		int aKey = m_keys[aProxy.i];
-		while (b < m_proxies.size() && aKey > m_keys[m_proxies[b].i])
+		for (size_t i = begin; i < end; ++i)
 		{
-			// swap a (which is in b-1 currently) and b proxies
-			m_proxies[b - 1] = m_proxies[b];
-			m_proxies[b] = aProxy;
-			++b;
+			m_accelerations[i] = Vec2();
 		}
+	});
+}
+
+void	CFluidSystem::ComputeGrid()
+{
+	Vec2 min = m_min;
+	Vec2 max = m_max;
+	if (min == max && !m_positions.empty())
+	{
+		min = max = m_positions[0];
+		for (const Vec2& pos : m_positions)
+		{
+			min = minv(min, pos);
+			max = maxv(max, pos);
+		}
+	}
+
+	// cells grow past FLUID_MAX_GRID_CELLS, so an escaped particle cannot make the grid allocate gigabytes
+	Vec2 extent = max - min;
+	if (!std::isfinite(extent.x) || !std::isfinite(extent.y))
+	{
+		extent = Vec2();
 	}
+
+	float cellSize = m_radius;
+	while ((extent.x / cellSize + 1.0f) * (extent.y / cellSize + 1.0f) > (float)FLUID_MAX_GRID_CELLS)
+	{
+		cellSize *= 2.0f;
+	}
+
+	m_invCellSize = 1.0f / cellSize;
+	m_gridMin = min;
+	m_gridWidth = (uint32_t)(extent.x * m_invCellSize) + 1;
+	m_gridHeight = (uint32_t)(extent.y * m_invCellSize) + 1;
 }
 
-void	CFluidSystem::AddProxyContacts(size_t a)
+void	CFluidSystem::ComputeKeys()
 {
-	float h = m_radius;
+	float maxX = (float)(m_gridWidth - 1);
+	float maxY = (float)(m_gridHeight - 1);
+
+	gVars->pPhysicEngine->GetJobSystem().ParallelFor(m_positions.size(), FLUID_GRAIN_SIZE, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			// particles out of grid go in border cells, clamped before the integer conversion
+			Vec2 pos = (m_positions[i] - m_gridMin) * m_invCellSize;
+			size_t x = (size_t)Clamp(floorf(pos.x), 0.0f, maxX);
+			size_t y = (size_t)Clamp(floorf(pos.y), 0.0f, maxY);
+			m_cellKeys[i] = (uint32_t)(y * m_gridWidth + x);
+		}
+	});
+}
+
+void	CFluidSystem::SortParticles()
+{
+	size_t cellCount = (size_t)m_gridWidth * m_gridHeight;
+
+	// counting sort : count per cell, prefix sum, then scatter
+	m_cellStarts.assign(cellCount + 1, 0);
+	for (uint32_t key : m_cellKeys)
+	{
+		++m_cellStarts[key + 1];
+	}
+
+	for (size_t cell = 0; cell < cellCount; ++cell)
+	{
+		m_cellStarts[cell + 1] += m_cellStarts[cell];
+	}
+
+	m_cellCursors.assign(m_cellStarts.begin(), m_cellStarts.end() - 1);
+	for (size_t i = 0; i < m_cellKeys.size(); ++i)
+	{
+		m_sortedParticles[m_cellCursors[m_cellKeys[i]]++] = (uint32_t)i;
+	}
+}
+
+void	CFluidSystem::ReorderParticles()
+{
+	size_t count = m_positions.size();
+	m_reorderBuffer.resize(count);
 
-	int aKey = m_keys[m_proxies[a].i];
-	int topKey = GetTopKey(aKey);
+	for (size_t i = 0; i < count; ++i)
+	{
+		m_reorderBuffer[i] = m_positions[m_sortedParticles[i]];
+	}
+	m_positions.swap(m_reorderBuffer);
 
-	// iterate over all particles in same cell and cell just to the top
-	size_t b = a + 1;
-	for (; b < m_proxies.size() && m_keys[m_proxies[b].i] <= topKey; ++b)
+	for (size_t i = 0; i < count; ++i)
 	{
-		AddContact(m_proxies[a].i, m_proxies[b].i, h);
+		m_reorderBuffer[i] = m_velocities[m_sortedParticles[i]];
 	}
+	m_velocities.swap(m_reorderBuffer);
 
-	int rightKey = GetRightKey(aKey);
-	for (; b < m_proxies.size() && m_keys[m_proxies[b].i] < rightKey; ++b);
+	for (size_t i = 0; i < count; ++i)
+	{
+		m_reorderBuffer[i] = m_previousPositions[m_sortedParticles[i]];
+	}
+	m_previousPositions.swap(m_reorderBuffer);
 
-	int topRightKey = GetTopKey(rightKey);
-	for (; b < m_proxies.size() && m_keys[m_proxies[b].i] <= topRightKey; ++b)
+	// cells are unchanged, particles are now stored in sorted order
+	for (uint32_t cell = 0; cell + 1 < m_cellStarts.size(); ++cell)
 	{
-		AddContact(m_proxies[a].i, m_proxies[b].i, h);
+		for (uint32_t i = m_cellStarts[cell]; i < m_cellStarts[cell + 1]; ++i)
+		{
+			m_cellKeys[i] = cell;
+		}
+	}
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		m_sortedParticles[i] = (uint32_t)i;
+	}
+}
+
+void	CFluidSystem::AddCellContacts(size_t a, uint32_t cell, float h)
+{
+	for (uint32_t i = m_cellStarts[cell]; i < m_cellStarts[cell + 1]; ++i)
+	{
+		AddContact(a, m_sortedParticles[i], h);
 	}
 }
 
@@ -173,89 +529,318 @@ void	CFluidSystem::AddContact(size_t i, size_t j, float h)
 
 	if (sqrLength <= h * h)
 	{
-		float d = (iPos - jPos).GetLength();
 		SParticleContact contact;
 		contact.a = i;
 		contact.b = j;
-		contact.length = Clamp(d, m_minRadius, h);
+		contact.length = Clamp(sqrtf(sqrLength), m_minRadius, h);
 
 		m_contacts.push_back(contact);
 	}
 }
 
-void	CFluidSystem::FindContacts()
+void	CFluidSystem::BuildContacts()
 {
-	ComputeKeys();
-	UpdateProxies();
+	float h = m_radius;
 
 	m_contacts.clear();
-	for (size_t a = 0; a < m_proxies.size(); ++a)
+	for (uint32_t sorted = 0; sorted < m_sortedParticles.size(); ++sorted)
 	{
-		AddProxyContacts(a);
+		size_t a = m_sortedParticles[sorted];
+		uint32_t cell = m_cellKeys[a];
+		uint32_t x = cell % m_gridWidth;
+		uint32_t y = cell / m_gridWidth;
+
+		// following particles of same cell
+		for (uint32_t i = sorted + 1; i < m_cellStarts[cell + 1]; ++i)
+		{
+			AddContact(a, m_sortedParticles[i], h);
+		}
+
+		// forward half of neighbor cells (top, right column), so each pair is found once
+		if (y + 1 < m_gridHeight)
+			AddCellContacts(a, cell + m_gridWidth, h);
+
+		if (x + 1 < m_gridWidth)
+		{
+			AddCellContacts(a, cell + 1, h);
+			if (y > 0)
+				AddCellContacts(a, cell + 1 - m_gridWidth, h);
+			if (y + 1 < m_gridHeight)
+				AddCellContacts(a, cell + 1 + m_gridWidth, h);
+		}
 	}
 }
 
-void	CFluidSystem::ComputeDensity()
+void	CFluidSystem::AddNeighbors(size_t i, float h, SNeighborChunk& neighbors) const
 {
-	float radius = m_radius;
-	float mass = m_mass;
+	const Vec2& pos = m_positions[i];
+	uint32_t cell = m_cellKeys[i];
+	uint32_t x = cell % m_gridWidth;
+	uint32_t y = cell / m_gridWidth;
+
+	// full 3x3 stencil, visited in a fixed order so neighbor lists are deterministic
+	uint32_t minX = (x > 0) ? x - 1 : x;
+	uint32_t maxX = Min(x + 1, m_gridWidth - 1);
+	uint32_t minY = (y > 0) ? y - 1 : y;
+	uint32_t maxY = Min(y + 1, m_gridHeight - 1);
+
+	// cells of a row are contiguous in sorted order
+	for (uint32_t cellY = minY; cellY <= maxY; ++cellY)
+	{
+		uint32_t rowStart = m_cellStarts[cellY * m_gridWidth + minX];
+		uint32_t rowEnd = m_cellStarts[cellY * m_gridWidth + maxX + 1];
+
+		size_t capacity = neighbors.count + (rowEnd - rowStart);
+		if (neighbors.indices.size() < capacity)
+		{
+			neighbors.indices.resize(capacity * 2);
+			neighbors.lengths.resize(capacity * 2);
+		}
 
-	float baseWeight = KernelDefault(0.0f, radius);
+		// every candidate is written, the count only moves forward for accepted ones (no unpredictable branch)
+		uint32_t* indices = neighbors.indices.data();
+		float* sqrLengths = neighbors.lengths.data();
+		for (uint32_t sorted = rowStart; sorted < rowEnd; ++sorted)
+		{
+			uint32_t j = m_sortedParticles[sorted];
+			float sqrLength = (pos - m_positions[j]).GetSqrLength();
 
-	for (float& density : m_densities)
+			indices[neighbors.count] = j;
+			sqrLengths[neighbors.count] = sqrLength;
+			neighbors.count += (size_t)((sqrLength <= h * h) & (j != i));
+		}
+	}
+}
+
+void	CFluidSystem::BuildNeighborLists(bool squared)
+{
+	CJobSystem& jobSystem = gVars->pPhysicEngine->GetJobSystem();
+	float h = m_radius;
+	size_t count = m_positions.size();
+
+	// Single search pass into fixed particle chunks, then chunks are concatenated.
+	// Chunks don't depend on the thread count, so neither does the neighbor layout.
+	size_t chunkCount = (count + FLUID_GRAIN_SIZE - 1) / FLUID_GRAIN_SIZE;
+	m_neighborChunks.resize(chunkCount);
+	m_neighborStarts.resize(count + 1);
+	m_neighborStarts[0] = 0;
+
+	jobSystem.ParallelFor(chunkCount, 1, [&](size_t beginChunk, size_t endChunk)
 	{
-		density = baseWeight;
+		for (size_t chunk = beginChunk; chunk < endChunk; ++chunk)
+		{
+			SNeighborChunk& neighbors = m_neighborChunks[chunk];
+			neighbors.count = 0;
+
+			size_t end = Min((chunk + 1) * FLUID_GRAIN_SIZE, count);
+			for (size_t i = chunk * FLUID_GRAIN_SIZE; i < end; ++i)
+			{
+				AddNeighbors(i, h, neighbors);
+				m_neighborStarts[i + 1] = (uint32_t)neighbors.count;
+			}
+
+			if (squared)
+			{
+				for (size_t n = 0; n < neighbors.count; ++n)
+				{
+					neighbors.lengths[n] = Max(neighbors.lengths[n], m_minRadius * m_minRadius);
+				}
+			}
+			else
+			{
+				for (size_t n = 0; n < neighbors.count; ++n)
+				{
+					neighbors.lengths[n] = Clamp(sqrtf(neighbors.lengths[n]), m_minRadius, h);
+				}
+			}
+		}
+	});
+
+	// chunk relative ends to global ends
+	uint32_t offset = 0;
+	for (size_t chunk = 0; chunk < chunkCount; ++chunk)
+	{
+		size_t end = Min((chunk + 1) * FLUID_GRAIN_SIZE, count);
+		for (size_t i = chunk * FLUID_GRAIN_SIZE; i < end; ++i)
+		{
+			m_neighborStarts[i + 1] += offset;
+		}
+		offset += (uint32_t)m_neighborChunks[chunk].count;
 	}
 
-	for (SParticleContact& contact : m_contacts)
+	m_neighborIndices.resize(offset);
+	m_neighborLengths.resize(offset);
+	m_squaredNeighborLengths = squared;
+	jobSystem.ParallelFor(chunkCount, 1, [&](size_t beginChunk, size_t endChunk)
 	{
-		const Vec2& aPos = m_positions[contact.a];
-		const Vec2& bPos = m_positions[contact.b];
+		for (size_t chunk = beginChunk; chunk < endChunk; ++chunk)
+		{
+			const SNeighborChunk& neighbors = m_neighborChunks[chunk];
+			uint32_t start = m_neighborStarts[chunk * FLUID_GRAIN_SIZE];
+			std::copy(neighbors.indices.begin(), neighbors.indices.begin() + neighbors.count, m_neighborIndices.begin() + start);
+			std::copy(neighbors.lengths.begin(), neighbors.lengths.begin() + neighbors.count, m_neighborLengths.begin() + start);
+		}
+	});
+}
 
-		float weight = KernelDefault(contact.length, radius);
-		m_densities[contact.a] += weight;
-		m_densities[contact.b] += weight;
+void	CFluidSystem::FindContacts()
+{
+	ComputeGrid();
+	ComputeKeys();
+	SortParticles();
+
+	if (m_framesSinceReorder++ >= m_reorderInterval)
+	{
+		ReorderParticles();
+		m_framesSinceReorder = 0;
 	}
 
-	for (float& density : m_densities)
+	if (m_useNeighborLists)
 	{
-		density *= mass;
+		BuildNeighborLists(m_kernelEvaluation == EKernelEvaluation::Tabulated);
+	}
+	else
+	{
+		BuildContacts();
+	}
+}
+
+template<typename TFloat, bool Tabulated>
+SIMD_KERNEL_INLINE void	CFluidSystem::ComputeDensityPressure(size_t begin, size_t end)
+{
+	const size_t W = TFloat::Width;
+	const SKernelConstants& kernel = m_kernel;
+	float baseWeight = KernelDefault(0.0f, kernel);
+
+	for (size_t i = begin; i < end; ++i)
+	{
+		uint32_t n = m_neighborStarts[i];
+		uint32_t last = m_neighborStarts[i + 1];
+
+		TFloat weights = TFloat::Zero();
+		for (; n + W <= last; n += W)
+		{
+			TFloat length = TFloat::Load(&m_neighborLengths[n]);
+			weights += KernelDefaultSqr(Tabulated ? length : length * length, kernel);
+		}
+
+		float lanes[W];
+		weights.Store(lanes);
+
+		float density = baseWeight;
+		for (size_t lane = 0; lane < W; ++lane)
+		{
+			density += lanes[lane];
+		}
+		for (; n < last; ++n)
+		{
+			float length = m_neighborLengths[n];
+			density += KernelDefaultSqr(Tabulated ? length : length * length, kernel);
+		}
+
+		density *= m_mass;
+		m_densities[i] = density;
+		m_pressures[i] = m_stiffness * (density - m_restDensity);
 	}
 }
 
-void	CFluidSystem::ComputePressure()
+#ifdef SIMD_AVX2
+SIMD_AVX2_ENTRY void	CFluidSystem::ComputeDensityPressureAVX2(size_t begin, size_t end, bool tabulated)
 {
-	for (size_t i = 0; i < m_pressures.size(); ++i)
+	tabulated ? ComputeDensityPressure<SFloat8, true>(begin, end) : ComputeDensityPressure<SFloat8, false>(begin, end);
+}
+#endif
+
+void	CFluidSystem::ComputeDensityPressure()
+{
+	if (m_useNeighborLists)
+	{
+		gVars->pPhysicEngine->GetJobSystem().ParallelFor(m_densities.size(), FLUID_GRAIN_SIZE, [&](size_t begin, size_t end)
+		{
+			bool tabulated = m_squaredNeighborLengths;
+#ifdef SIMD_AVX2
+			if (IsAVX2Supported())
+			{
+				ComputeDensityPressureAVX2(begin, end, tabulated);
+				return;
+			}
+#endif
+			tabulated ? ComputeDensityPressure<SFloat4, true>(begin, end) : ComputeDensityPressure<SFloat4, false>(begin, end);
+		});
+		return;
+	}
+
+	float baseWeight = KernelDefault(0.0f, m_kernel);
+	for (float& density : m_densities)
+	{
+		density = baseWeight;
+	}
+
+	for (SParticleContact& contact : m_contacts)
+	{
+		float weight = KernelDefault(contact.length, m_kernel);
+		m_densities[contact.a] += weight;
+		m_densities[contact.b] += weight;
+	}
+
+	for (size_t i = 0; i < m_densities.size(); ++i)
 	{
+		m_densities[i] *= m_mass;
 		m_pressures[i] = m_stiffness * (m_densities[i] - m_restDensity);
 	}
 }
 
 void	CFluidSystem::ComputeSurfaceTension()
 {
-	float radius = m_radius * 1.5f;// 3.0f;
+	const SKernelConstants& kernel = m_surfaceKernel;
 	float mass = m_mass;
 
-	for (size_t i = 0; i < m_surfaceNormals.size(); ++i)
+	if (m_useNeighborLists)
 	{
-		m_surfaceNormals[i] = Vec2();
-		m_surfaceCurvatures[i] = -(mass / m_densities[i]) * KernelDefaultLaplacian(0.0f, radius);
+		gVars->pPhysicEngine->GetJobSystem().ParallelFor(m_surfaceNormals.size(), FLUID_GRAIN_SIZE, [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				Vec2 normal;
+				float curvature = -(mass / m_densities[i]) * KernelDefaultLaplacian(0.0f, kernel);
+				for (uint32_t n = m_neighborStarts[i]; n < m_neighborStarts[i + 1]; ++n)
+				{
+					uint32_t j = m_neighborIndices[n];
+					float length = m_squaredNeighborLengths ? sqrtf(m_neighborLengths[n]) : m_neighborLengths[n];
+					Vec2 r = m_positions[i] - m_positions[j];
+					float volume = mass / m_densities[j];
+
+					normal += r * KernelDefaultGradientFactor(length, kernel) * volume;
+					curvature += -volume * KernelDefaultLaplacian(length, kernel);
+				}
+				m_surfaceNormals[i] = normal;
+				m_surfaceCurvatures[i] = curvature;
+			}
+		});
 	}
-
-	for (SParticleContact& contact : m_contacts)
+	else
 	{
-		const Vec2& aPos = m_positions[contact.a];
-		const Vec2& bPos = m_positions[contact.b];
+		for (size_t i = 0; i < m_surfaceNormals.size(); ++i)
+		{
+			m_surfaceNormals[i] = Vec2();
+			m_surfaceCurvatures[i] = -(mass / m_densities[i]) * KernelDefaultLaplacian(0.0f, kernel);
+		}
 
-		Vec2 r = aPos - bPos;
-		Vec2 gradient = r * KernelDefaultGradientFactor(contact.length, radius);
+		for (SParticleContact& contact : m_contacts)
+		{
+			const Vec2& aPos = m_positions[contact.a];
+			const Vec2& bPos = m_positions[contact.b];
+
+			Vec2 r = aPos - bPos;
+			Vec2 gradient = r * KernelDefaultGradientFactor(contact.length, kernel);
 
-		m_surfaceNormals[contact.a] += gradient * (mass / m_densities[contact.b]);
-		m_surfaceNormals[contact.b] += gradient * -(mass / m_densities[contact.a]);
+			m_surfaceNormals[contact.a] += gradient * (mass / m_densities[contact.b]);
+			m_surfaceNormals[contact.b] += gradient * -(mass / m_densities[contact.a]);
 
-		float laplacian = KernelDefaultLaplacian(contact.length, radius);
-		m_surfaceCurvatures[contact.a] += -(mass / m_densities[contact.b]) * laplacian;
-		m_surfaceCurvatures[contact.b] += -(mass / m_densities[contact.a]) * laplacian;
+			float laplacian = KernelDefaultLaplacian(contact.length, kernel);
+			m_surfaceCurvatures[contact.a] += -(mass / m_densities[contact.b]) * laplacian;
+			m_surfaceCurvatures[contact.b] += -(mass / m_densities[contact.a]) * laplacian;
+		}
 	}
 
 	float l = 0.5f; // 1f;
@@ -265,8 +850,7 @@ void	CFluidSystem::ComputeSurfaceTension()
 		if (nSqrNorm >= l * l)
 		{
 			Vec2 tensionForce = m_surfaceNormals[i].Normalized() * m_surfaceCurvatures[i] * 5.0f;
-			
-			//m_accelerations[i] += tensionForce / m_densities[i];
+			m_accelerations[i] += tensionForce / m_densities[i];
 
 			//gVars->pRenderer->DrawLine(m_positions[i], m_positions[i] + m_surfaceNormals[i].Normalized() * m_surfaceCurvatures[i] * -0.5f , 1, 0, 0);
 		}
@@ -279,42 +863,161 @@ void	CFluidSystem::ComputeSurfaceTension()
 	}
 }
 
-void	CFluidSystem::AddPressureForces()
+// Pressure and viscosity acceleration factors of a particle pair from its kernel values, invDensities is 1 / (2 * densityA * densityB)
+template<typename T>
+SIMD_KERNEL_INLINE void	PressureViscosityFactors(const T& spikyGradient, const T& nearSpikyGradient, const T& viscosityLaplacian,
+									 const T& pressureSum, const T& densitySum, const T& invDensities,
+									 float mass, float stiffness, float viscosity, T& outPressure, T& outViscosity)
 {
-	float radius = m_radius;
+	outPressure = T(-mass) * pressureSum * invDensities * spikyGradient;
+	outPressure += T(0.02f * mass * stiffness) * densitySum * invDensities * nearSpikyGradient;
+	outViscosity = T(-mass * viscosity) * invDensities * viscosityLaplacian;
+}
+
+template<typename T>
+SIMD_KERNEL_INLINE void	PressureViscosityFactors(const T& length, const T& pressureSum, const T& densitySum, const T& invDensities,
+									 float mass, float stiffness, float viscosity, const SKernelConstants& kernel, T& outPressure, T& outViscosity)
+{
+	PressureViscosityFactors(KernelSpikyGradientFactor(length, kernel), KernelSpikyGradientFactor(length * T(0.8f), kernel), KernelViscosityLaplacian(length, kernel),
+							 pressureSum, densitySum, invDensities, mass, stiffness, viscosity, outPressure, outViscosity);
+}
+
+template<typename TFloat, bool Tabulated>
+SIMD_KERNEL_INLINE void	CFluidSystem::AddPressureViscosityForces(size_t begin, size_t end)
+{
+	const size_t W = TFloat::Width;
+	const SKernelConstants& kernel = m_kernel;
 	float mass = m_mass;
+	float stiffness = m_stiffness;
+	float viscosity = m_viscosity;
 
-	for (SParticleContact& contact : m_contacts)
+	float rx[W], ry[W], dvx[W], dvy[W], pressureSum[W], densitySum[W], invDensities[W];
+	float spikyGradients[W], nearSpikyGradients[W], viscosityLaplacians[W], kernels[3];
+
+	for (size_t i = begin; i < end; ++i)
 	{
-		const Vec2& aPos = m_positions[contact.a];
-		const Vec2& bPos = m_positions[contact.b];
+		uint32_t n = m_neighborStarts[i];
+		uint32_t last = m_neighborStarts[i + 1];
+
+		const Vec2& pos = m_positions[i];
+		const Vec2& vel = m_velocities[i];
+		float pressure = m_pressures[i];
+		float density = m_densities[i];
+
+		TFloat accX = TFloat::Zero();
+		TFloat accY = TFloat::Zero();
+		for (; n + W <= last; n += W)
+		{
+			// SoA gather of neighbor values
+			for (size_t lane = 0; lane < W; ++lane)
+			{
+				uint32_t j = m_neighborIndices[n + lane];
+				rx[lane] = pos.x - m_positions[j].x;
+				ry[lane] = pos.y - m_positions[j].y;
+				dvx[lane] = vel.x - m_velocities[j].x;
+				dvy[lane] = vel.y - m_velocities[j].y;
+				pressureSum[lane] = pressure + m_pressures[j];
+				densitySum[lane] = density + m_densities[j];
+				invDensities[lane] = 1.0f / (2.0f * density * m_densities[j]);
+				if (Tabulated)
+				{
+					m_pressureKernelTable.Lookup(m_neighborLengths[n + lane], kernels);
+					spikyGradients[lane] = kernels[0];
+					nearSpikyGradients[lane] = kernels[1];
+					viscosityLaplacians[lane] = kernels[2];
+				}
+			}
+
+			TFloat pressureFactor, viscosityFactor;
+			if (Tabulated)
+			{
+				PressureViscosityFactors(TFloat::Load(spikyGradients), TFloat::Load(nearSpikyGradients), TFloat::Load(viscosityLaplacians),
+										 TFloat::Load(pressureSum), TFloat::Load(densitySum), TFloat::Load(invDensities),
+										 mass, stiffness, viscosity, pressureFactor, viscosityFactor);
+			}
+			else
+			{
+				PressureViscosityFactors(TFloat::Load(&m_neighborLengths[n]), TFloat::Load(pressureSum), TFloat::Load(densitySum), TFloat::Load(invDensities),
+										 mass, stiffness, viscosity, kernel, pressureFactor, viscosityFactor);
+			}
+
+			accX += TFloat::Load(rx) * pressureFactor + TFloat::Load(dvx) * viscosityFactor;
+			accY += TFloat::Load(ry) * pressureFactor + TFloat::Load(dvy) * viscosityFactor;
+		}
+
+		float lanesX[W], lanesY[W];
+		accX.Store(lanesX);
+		accY.Store(lanesY);
 
-		Vec2 r = aPos - bPos;
-		float length = contact.length;
+		Vec2 acc;
+		for (size_t lane = 0; lane < W; ++lane)
+		{
+			acc += Vec2(lanesX[lane], lanesY[lane]);
+		}
 
-		Vec2 pressureAcc = r * -mass * ((m_pressures[contact.a] + m_pressures[contact.b]) / (2.0f * m_densities[contact.a] * m_densities[contact.b])) * KernelSpikyGradientFactor(length, radius);
-		pressureAcc += r * 0.02f * mass * ((m_stiffness * (m_densities[contact.a] + m_densities[contact.b])) / (2.0f * m_densities[contact.a] * m_densities[contact.b])) * KernelSpikyGradientFactor(length * 0.8f, radius);
-		m_accelerations[contact.a] += pressureAcc;
-		m_accelerations[contact.b] -= pressureAcc;
+		for (; n < last; ++n)
+		{
+			uint32_t j = m_neighborIndices[n];
+
+			float pressureFactor, viscosityFactor;
+			if (Tabulated)
+			{
+				m_pressureKernelTable.Lookup(m_neighborLengths[n], kernels);
+				PressureViscosityFactors(kernels[0], kernels[1], kernels[2],
+										 pressure + m_pressures[j], density + m_densities[j], 1.0f / (2.0f * density * m_densities[j]),
+										 mass, stiffness, viscosity, pressureFactor, viscosityFactor);
+			}
+			else
+			{
+				PressureViscosityFactors(m_neighborLengths[n], pressure + m_pressures[j], density + m_densities[j], 1.0f / (2.0f * density * m_densities[j]),
+										 mass, stiffness, viscosity, kernel, pressureFactor, viscosityFactor);
+			}
+
+			acc += (pos - m_positions[j]) * pressureFactor + (vel - m_velocities[j]) * viscosityFactor;
+		}
+
+		m_accelerations[i] += acc;
 	}
 }
 
-void	CFluidSystem::AddViscosityForces()
+#ifdef SIMD_AVX2
+SIMD_AVX2_ENTRY void	CFluidSystem::AddPressureViscosityForcesAVX2(size_t begin, size_t end, bool tabulated)
 {
-	float radius = m_radius;
-	float mass = m_mass;
-	float viscosity = m_viscosity;
+	tabulated ? AddPressureViscosityForces<SFloat8, true>(begin, end) : AddPressureViscosityForces<SFloat8, false>(begin, end);
+}
+#endif
+
+void	CFluidSystem::AddPressureViscosityForces()
+{
+	if (m_useNeighborLists)
+	{
+		gVars->pPhysicEngine->GetJobSystem().ParallelFor(m_accelerations.size(), FLUID_GRAIN_SIZE, [&](size_t begin, size_t end)
+		{
+			bool tabulated = m_squaredNeighborLengths;
+#ifdef SIMD_AVX2
+			if (IsAVX2Supported())
+			{
+				AddPressureViscosityForcesAVX2(begin, end, tabulated);
+				return;
+			}
+#endif
+			tabulated ? AddPressureViscosityForces<SFloat4, true>(begin, end) : AddPressureViscosityForces<SFloat4, false>(begin, end);
+		});
+		return;
+	}
 
 	for (SParticleContact& contact : m_contacts)
 	{
-		const Vec2& aPos = m_positions[contact.a];
-		const Vec2& bPos = m_positions[contact.b];
+		float densityA = m_densities[contact.a];
+		float densityB = m_densities[contact.b];
 
-		Vec2 deltaVel = m_velocities[contact.a] - m_velocities[contact.b];
-		Vec2 viscosityAcc = deltaVel * -mass * (viscosity / (2.0f * m_densities[contact.a] * m_densities[contact.b])) * KernelViscosityLaplacian(contact.length, radius);
+		float pressureFactor, viscosityFactor;
+		PressureViscosityFactors(contact.length, m_pressures[contact.a] + m_pressures[contact.b], densityA + densityB, 1.0f / (2.0f * densityA * densityB),
+								 m_mass, m_stiffness, m_viscosity, m_kernel, pressureFactor, viscosityFactor);
 
-		m_accelerations[contact.a] += viscosityAcc;
-		m_accelerations[contact.b] -= viscosityAcc;
+		Vec2 acc = (m_positions[contact.a] - m_positions[contact.b]) * pressureFactor + (m_velocities[contact.a] - m_velocities[contact.b]) * viscosityFactor;
+		m_accelerations[contact.a] += acc;
+		m_accelerations[contact.b] -= acc;
 	}
 }
 
@@ -355,102 +1058,309 @@ void	CFluidSystem::BorderCollisions()
 	}
 }
 
-void	CFluidSystem::ApplyForces(float dt)
+template<typename TFloat>
+SIMD_KERNEL_INLINE void	CFluidSystem::ComputeLambdas(size_t begin, size_t end)
 {
-	ClampArray(m_accelerations, m_maxAcceleration);
+	const size_t W = TFloat::Width;
+	const SKernelConstants& kernel = m_kernel;
+	float h = m_radius;
+	float mass = m_mass;
+	float invRestDensity = 1.0f / m_pbfRestDensity;
+	float gradientScale = mass * invRestDensity;
 
-	Vec2 gravity(0.0f, -5);// -9.8f);
-	for (size_t i = 0; i < m_velocities.size(); ++i)
+	float rx[W], ry[W], gradientX[W], gradientY[W];
+
+	for (size_t i = begin; i < end; ++i)
 	{
-		m_velocities[i] += (m_accelerations[i] + gravity) * dt;
+		uint32_t n = m_neighborStarts[i];
+		uint32_t last = m_neighborStarts[i + 1];
+		const Vec2& pos = m_positions[i];
+
+		TFloat densities = TFloat::Zero();
+		TFloat sumX = TFloat::Zero();
+		TFloat sumY = TFloat::Zero();
+		TFloat sqrGradients = TFloat::Zero();
+		for (; n + W <= last; n += W)
+		{
+			for (size_t lane = 0; lane < W; ++lane)
+			{
+				const Vec2& neighborPos = m_positions[m_neighborIndices[n + lane]];
+				rx[lane] = pos.x - neighborPos.x;
+				ry[lane] = pos.y - neighborPos.y;
+			}
+
+			TFloat Rx = TFloat::Load(rx);
+			TFloat Ry = TFloat::Load(ry);
+			TFloat sqrLength = Rx * Rx + Ry * Ry;
+			// neighbors moved out of the kernel since lists were built are masked out
+			TFloat inKernel = TFloat(h * h) > sqrLength;
+			TFloat length = TFloat::Max(TFloat::Sqrt(sqrLength), TFloat(m_minRadius));
+
+			densities += TFloat::And(inKernel, KernelDefault(length, kernel));
+
+			// gradient of constraint i relatively to neighbor position, kept for position corrections
+			TFloat factor = TFloat::And(inKernel, TFloat(gradientScale) * KernelSpiky2DGradientFactor(length, kernel));
+			TFloat Gx = Rx * factor;
+			TFloat Gy = Ry * factor;
+			sumX += Gx;
+			sumY += Gy;
+			sqrGradients += Gx * Gx + Gy * Gy;
+
+			Gx.Store(gradientX);
+			Gy.Store(gradientY);
+			for (size_t lane = 0; lane < W; ++lane)
+			{
+				m_neighborGradients[n + lane] = Vec2(gradientX[lane], gradientY[lane]);
+			}
+		}
+
+		float lanesDensity[W], lanesX[W], lanesY[W], lanesSqr[W];
+		densities.Store(lanesDensity);
+		sumX.Store(lanesX);
+		sumY.Store(lanesY);
+		sqrGradients.Store(lanesSqr);
+
+		float density = KernelDefault(0.0f, kernel);
+		Vec2 gradient;
+		float sqrGradient = 0.0f;
+		for (size_t lane = 0; lane < W; ++lane)
+		{
+			density += lanesDensity[lane];
+			gradient += Vec2(lanesX[lane], lanesY[lane]);
+			sqrGradient += lanesSqr[lane];
+		}
+
+		for (; n < last; ++n)
+		{
+			Vec2 r = pos - m_positions[m_neighborIndices[n]];
+			float sqrLength = r.GetSqrLength();
+			if (sqrLength >= h * h)
+			{
+				m_neighborGradients[n] = Vec2();
+				continue;
+			}
+
+			float length = Max(sqrtf(sqrLength), m_minRadius);
+			density += KernelDefault(length, kernel);
+
+			Vec2 neighborGradient = r * (gradientScale * KernelSpiky2DGradientFactor(length, kernel));
+			m_neighborGradients[n] = neighborGradient;
+			gradient += neighborGradient;
+			sqrGradient += neighborGradient | neighborGradient;
+		}
+
+		// only compression is corrected, free surface particles are not pulled together
+		density *= mass;
+		float constraint = Max(density * invRestDensity - 1.0f, 0.0f);
+		m_densities[i] = density;
+		m_lambdas[i] = -constraint / (sqrGradient + (gradient | gradient) + m_pbfRelaxation);
 	}
 }
 
-void	CFluidSystem::Integrate(float dt)
+#ifdef SIMD_AVX2
+SIMD_AVX2_ENTRY void	CFluidSystem::ComputeLambdasAVX2(size_t begin, size_t end)
 {
-	ClampArray(m_velocities, m_maxSpeed);
-	for (size_t i = 0; i < m_positions.size(); ++i)
-	{
-		m_positions[i] += m_velocities[i] * dt;
-	}
+	ComputeLambdas<SFloat8>(begin, end);
 }
+#endif
 
-void	CFluidSystem::ClampArray(std::vector<Vec2>& array, float limit)
+void	CFluidSystem::ComputeLambdas()
 {
-	for (Vec2& vec : array)
+	gVars->pPhysicEngine->GetJobSystem().ParallelFor(m_positions.size(), FLUID_GRAIN_SIZE, [&](size_t begin, size_t end)
 	{
-		if (vec.GetSqrLength() > limit * limit)
+#ifdef SIMD_AVX2
+		if (IsAVX2Supported())
 		{
-			vec *= limit / vec.GetLength();
+			ComputeLambdasAVX2(begin, end);
+			return;
 		}
-	}
+#endif
+		ComputeLambdas<SFloat4>(begin, end);
+	});
 }
 
-void	CFluidSystem::FillMesh()
+void	CFluidSystem::ApplyDensityCorrections()
 {
-	m_mesh.Fill(m_positions.size(), [&](size_t iVertex, float& x, float& y, float& r, float& g, float& b)
+	CJobSystem& jobSystem = gVars->pPhysicEngine->GetJobSystem();
+	jobSystem.ParallelFor(m_positions.size(), FLUID_GRAIN_SIZE, [&](size_t begin, size_t end)
 	{
-		const Vec2& pos = m_positions[iVertex];
-		x = pos.x;
-		y = pos.y;
-		r = 0.0f;
-		g = 0.0f;
-		b = 1.0f;
+		for (size_t i = begin; i < end; ++i)
+		{
+			Vec2 delta;
+			for (uint32_t n = m_neighborStarts[i]; n < m_neighborStarts[i + 1]; ++n)
+			{
+				delta += m_neighborGradients[n] * (m_lambdas[i] + m_lambdas[m_neighborIndices[n]]);
+			}
+			m_positionDeltas[i] = delta;
+		}
 	});
-}
 
-
-float KernelDefault(float r, float h)
-{
-	float h2 = h * h;
-	float h4 = h2 * h2;
-	float kernel = h2 - r * r;
-	return (kernel * kernel * kernel) * (4.0f / (((float)M_PI) * h4 * h4));
+	jobSystem.ParallelFor(m_positions.size(), FLUID_GRAIN_SIZE, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			Vec2& pos = m_positions[i];
+			pos += m_positionDeltas[i];
+			if (m_min != m_max)
+			{
+				pos = Vec2(Clamp(pos.x, m_min.x, m_max.x), Clamp(pos.y, m_min.y, m_max.y));
+			}
+		}
+	});
 }
 
-float KernelDefaultGradientFactor(float r, float h)
+void	CFluidSystem::ApplyXSPHViscosity()
 {
-	float h2 = h * h;
-	float h4 = h2 * h2;
-	float kernel = h2 - r * r;
-	return -(kernel * kernel) * (6.0f / (((float)M_PI) * h4 * h4));
-}
+	const SKernelConstants& kernel = m_kernel;
+	float h = m_radius;
+	float mass = m_mass;
 
-float KernelDefaultLaplacian(float r, float h)
-{
-	float h2 = h * h;
-	float h4 = h2 * h2;
-	float kernel = h2 - r * r;
-	return -(kernel * kernel) * (6.0f / (((float)M_PI) * h4 * h4)) * (3.0f * h2 - 7.0f * r * r);
-}
+	// velocity changes are gathered first, neighbors must read unchanged velocities
+	CJobSystem& jobSystem = gVars->pPhysicEngine->GetJobSystem();
+	jobSystem.ParallelFor(m_velocities.size(), FLUID_GRAIN_SIZE, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			Vec2 deltaVel;
+			for (uint32_t n = m_neighborStarts[i]; n < m_neighborStarts[i + 1]; ++n)
+			{
+				uint32_t j = m_neighborIndices[n];
+				float length = (m_positions[i] - m_positions[j]).GetLength();
+				if (length >= h)
+					continue;
+
+				deltaVel += (m_velocities[j] - m_velocities[i]) * ((mass / m_densities[j]) * KernelDefault(length, kernel));
+			}
+			m_positionDeltas[i] = deltaVel * m_xsphViscosity;
+		}
+	});
 
+	jobSystem.ParallelFor(m_velocities.size(), FLUID_GRAIN_SIZE, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			m_velocities[i] += m_positionDeltas[i];
+		}
+	});
+}
 
-float KernelSpikyGradientFactorNorm(float r, float h)
+void	CFluidSystem::RigidBodyCollisions()
 {
-	float h2 = h * h;
-	float h5 = h2 * h2 * h;
-	float kernel = h - r;
-	return kernel * kernel * (-15.0f / ((float)M_PI * h5));
+	if (!gVars->pWorld || m_gridWidth == 0 || m_positions.empty())
+		return;
+
+	float particleRadius = m_radius / m_particleRadiusRatio;
+	// grid was built before integration, particles moved by less than a cell since
+	float margin = particleRadius + m_radius;
+	int maxCellX = (int)m_gridWidth - 1;
+	int maxCellY = (int)m_gridHeight - 1;
+
+	CBodyStore& bodies = gVars->pWorld->GetBodies();
+	const std::vector<CPolygonPtr>& polygons = gVars->pWorld->GetPolygons();
+	for (size_t body = 0; body < bodies.GetCount(); ++body)
+	{
+		// body bounds are kept up to date by the solvers, no need to transform the points
+		const CPolygonPtr& poly = polygons[body];
+		Vec2 min = bodies.bounds[body].GetMin();
+		Vec2 max = bodies.bounds[body].GetMax();
+
+		Vec2 minCell = (min - Vec2(margin, margin) - m_gridMin) * m_invCellSize;
+		Vec2 maxCell = (max + Vec2(margin, margin) - m_gridMin) * m_invCellSize;
+		uint32_t minX = (uint32_t)Clamp((int)floorf(minCell.x), 0, maxCellX);
+		uint32_t maxX = (uint32_t)Clamp((int)floorf(maxCell.x), 0, maxCellX);
+		uint32_t minY = (uint32_t)Clamp((int)floorf(minCell.y), 0, maxCellY);
+		uint32_t maxY = (uint32_t)Clamp((int)floorf(maxCell.y), 0, maxCellY);
+
+		// static polygons act as infinite mass, like borders
+		bool isDynamic = (poly->GetDensity() != 0.0f);
+		float invMass = isDynamic ? poly->GetInvMass() : 0.0f;
+		float invInertia = isDynamic ? poly->GetInversedInertiaTensor() : 0.0f;
+		float invParticleMass = 1.0f / m_mass;
+
+		for (uint32_t cellY = minY; cellY <= maxY; ++cellY)
+		{
+			uint32_t rowStart = m_cellStarts[cellY * m_gridWidth + minX];
+			uint32_t rowEnd = m_cellStarts[cellY * m_gridWidth + maxX + 1];
+			for (uint32_t sorted = rowStart; sorted < rowEnd; ++sorted)
+			{
+				uint32_t i = m_sortedParticles[sorted];
+
+				Vec2 normal;
+				float separation = poly->GetPointSeparation(m_positions[i], normal);
+				if (separation >= particleRadius)
+					continue;
+
+				m_positions[i] += normal * (particleRadius - separation);
+
+				Vec2 contactPoint = m_positions[i] - normal * particleRadius;
+				Vec2 r = contactPoint - bodies.positions[body];
+				Vec2 relativeVelocity = m_velocities[i] - poly->GetPointVelocity(contactPoint);
+				float normalVelocity = relativeVelocity | normal;
+				if (normalVelocity >= 0.0f)
+					continue;
+
+				// same response as borders (restitution, tangent velocity kept by friction factor), relative to the polygon surface.
+				// Impulses are applied to the polygon right away, so next particles see its new velocity.
+				float rn = r ^ normal;
+				Vec2 impulse = normal * (-(1.0f + m_wallRestitution) * normalVelocity / (invParticleMass + invMass + rn * rn * invInertia));
+
+				Vec2 tangentVelocity = relativeVelocity - normal * normalVelocity;
+				float tangentSpeed = tangentVelocity.GetLength();
+				if (tangentSpeed > 0.0f)
+				{
+					Vec2 tangent = tangentVelocity / tangentSpeed;
+					float rt = r ^ tangent;
+					impulse += tangent * (-(1.0f - m_wallFriction) * tangentSpeed / (invParticleMass + invMass + rt * rt * invInertia));
+				}
+
+				m_velocities[i] += impulse * invParticleMass;
+				if (isDynamic)
+				{
+					bodies.speeds[body] -= impulse * invMass;
+					bodies.angularVelocities[body] -= (r ^ impulse) * invInertia;
+				}
+			}
+		}
+	}
 }
 
-float KernelSpikyGradientFactor(float r, float h)
+void	CFluidSystem::ApplyForces(float dt)
 {
-	float h2 = h * h;
-	float h5 = h2 * h2 * h;
-	float kernel = h - r;
-	return kernel * kernel * (-15.0f / ((float)M_PI * h5 * r));
+	ClampArray(m_accelerations, m_maxAcceleration);
+
+	gVars->pPhysicEngine->GetJobSystem().ParallelFor(m_velocities.size(), FLUID_GRAIN_SIZE, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			m_velocities[i] += (m_accelerations[i] + m_gravity) * dt;
+		}
+	});
 }
 
-float KernelViscosityLaplacian(float r, float h)
+void	CFluidSystem::Integrate(float dt)
 {
-	float h2 = h * h;
-	float kernel = h - r;
-	return kernel * (30.0f / ((float)M_PI * h2 * h2 * h));
+	ClampArray(m_velocities, m_maxSpeed);
+	gVars->pPhysicEngine->GetJobSystem().ParallelFor(m_positions.size(), FLUID_GRAIN_SIZE, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			m_positions[i] += m_velocities[i] * dt;
+		}
+	});
 }
 
-float KernelPoly6hGradientFactor(float r, float h)
+void	CFluidSystem::ClampArray(std::vector<Vec2>& array, float limit)
 {
-	float h2 = h * h;
-	float kernel = h2 - r * r;
-	return kernel * kernel * (24.0f / ((float)M_PI * h2 * h2 * h2 * h * r));
+	gVars->pPhysicEngine->GetJobSystem().ParallelFor(array.size(), FLUID_GRAIN_SIZE, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			Vec2& vec = array[i];
+			if (vec.GetSqrLength() > limit * limit)
+			{
+				vec *= limit / vec.GetLength();
+			}
+		}
+	});
 }
+
@@ -1,32 +1,89 @@
 #ifndef __FLUID_SYSTEM_H__
 #define __FLUID_SYSTEM_H__
 
-#include "FluidMesh.h"
+#include "FluidKernels.h"
 #include "Maths.h"
 
 #include <vector>
 #include <string>
+#include <cstdint>
 
-float KernelDefault(float r, float h);
-float KernelDefaultGradientFactor(float r, float h);
-float KernelDefaultLaplacian(float r, float h);
-float KernelSpikyGradientFactorNorm(float r, float h);
-float KernelSpikyGradientFactor(float r, float h);
-float KernelViscosityLaplacian(float r, float h);
-float KernelPoly6hGradientFactor(float r, float h);
+#define FLUID_GRAIN_SIZE 256
+#define FLUID_DEFAULT_CAPACITY 32768
+#define FLUID_KERNEL_TABLE_SIZE 1024
+#define FLUID_MAX_GRID_CELLS (1 << 22) // neighbor grid cell count limit, cells grow past it
 
+enum class EFluidSolver : int
+{
+	SPH = 0,		// pressure forces, small time steps
+	PositionBased,	// density constraints solved on positions, stable with frame time steps
 
-struct SParticleContact
+	Count,
+};
+
+inline const char* GetFluidSolverName(EFluidSolver solver)
 {
-	size_t	a, b;
-	float	length;
+	switch (solver)
+	{
+	case EFluidSolver::PositionBased:	return "PBF";
+	default:							return "SPH";
+	}
+}
+
+enum class EKernelEvaluation : int
+{
+	Exact = 0,	// kernel polynomials evaluated on distances
+	Tabulated,	// SPH kernels read from tables on squared distances, neighbor search takes no sqrt
+
+	Count,
 };
 
-struct SParticleProxy
+inline const char* GetKernelEvaluationName(EKernelEvaluation evaluation)
+{
+	switch (evaluation)
+	{
+	case EKernelEvaluation::Tabulated:	return "tabulated kernels";
+	default:							return "exact kernels";
+	}
+}
+
+// Timed stages of a fluid step
+enum class EFluidStage : int
 {
-	SParticleProxy(size_t _i) : i(_i){}
+	Neighbors = 0,	// grid, sort and neighbor search
+	Density,		// densities and pressures, or density constraints
+	Forces,			// pressure and viscosity forces, or XSPH viscosity
+	Integration,	// velocities, positions and borders
+	Coupling,		// rigid body collisions
 
-	size_t i;
+	Count,
+};
+
+inline const char* GetFluidStageName(EFluidStage stage)
+{
+	switch (stage)
+	{
+	case EFluidStage::Neighbors:	return "neighbors";
+	case EFluidStage::Density:		return "density";
+	case EFluidStage::Forces:		return "forces";
+	case EFluidStage::Integration:	return "integration";
+	default:						return "coupling";
+	}
+}
+
+// Substeps of the last Update and time spent in each stage (seconds, summed over substeps)
+struct SFluidStepStats
+{
+	size_t	subStepCount = 0;
+	float	minTimeStep = 0.0f;
+	float	maxTimeStep = 0.0f;
+	float	stageTimes[(int)EFluidStage::Count] = {};
+};
+
+struct SParticleContact
+{
+	size_t	a, b;
+	float	length;
 };
 
 class CFluidSystem
@@ -39,6 +96,8 @@ public:
 	}
 
 private:
+	friend class CWorldSnapshot;
+
 	CFluidSystem();
 	CFluidSystem(const CFluidSystem&);
 	CFluidSystem& operator=(const CFluidSystem&);
@@ -46,35 +105,115 @@ private:
 
 public:
 	void	SetBounds(const Vec2& min, const Vec2& max);
+
+	// Kernel constants, kernel tables, particle mass and PBF rest density are rebuilt when radius or ratio change
+	void	SetRadius(float radius);
+	float	GetRadius() const	{ return m_radius; }
+	void	SetParticleRadiusRatio(float ratio);
+	// Tabulated evaluation trades accuracy (sampleCount samples per kernel) for speed on large particle counts.
+	// Only SPH passes over neighbor lists use tables, PBF and the pair scatter path are always exact.
+	void				SetKernelEvaluation(EKernelEvaluation evaluation, size_t sampleCount = FLUID_KERNEL_TABLE_SIZE);
+	EKernelEvaluation	GetKernelEvaluation() const	{ return m_kernelEvaluation; }
+	// Experimental SPH surface tension, off by default : its normals and curvatures pass is skipped unless enabled
+	void	SetSurfaceTension(bool enabled)	{ m_surfaceTension = enabled; }
+	bool	GetSurfaceTension() const		{ return m_surfaceTension; }
+
+	// Particle pool : arrays are reserved once for capacity particles, emission stops when the pool is full.
+	// Removes extra particles when capacity is under current count.
+	void	SetCapacity(size_t capacity);
+	size_t	GetCapacity() const			{ return m_capacity; }
+	size_t	GetParticleCount() const	{ return m_positions.size(); }
+	// false once a particle position or velocity is NaN or infinite
+	bool	IsFinite() const;
+
+	// Emits up to count particles, functor(i, pos, vel) fills particle i of the batch. Returns emitted count.
+	template<typename TFunctor>
+	size_t	Emit(size_t count, TFunctor functor);
 	void	SpawnParticule(const Vec2& pos, const Vec2& vel);
 	void	Spawn(const Vec2& min, const Vec2& max, float particulesPerMeter, const Vec2& speed);
+
+	// Killed particles are flagged and removed by the compaction at the start of next Update.
+	// Particle indices are only valid until then.
+	void	KillParticle(size_t index);
+	void	KillParticles(const Vec2& center, float radius);
+	// Simulates dt with as many CFL limited substeps as needed
 	void	Update(float dt);
 
+	void		SetSolver(EFluidSolver solver)	{ m_solver = solver; }
+	EFluidSolver	GetSolver() const			{ return m_solver; }
+
+	const SFluidStepStats&	GetStepStats() const	{ return m_stepStats; }
+
+	// Removes every particle
+	void	Reset();
+
+	// Particle state, for rendering and tools
+	const std::vector<Vec2>&	GetPositions() const	{ return m_positions; }
+	const std::vector<Vec2>&	GetVelocities() const	{ return m_velocities; }
+	const std::vector<float>&	GetDensities() const	{ return m_densities; }
+
 private:
+	void	ComputeConstants();
+
+	// Largest stable step for current velocities and accelerations, in [m_minTimeStep, maxTimeStep]
+	float	ComputeTimeStep(float maxTimeStep) const;
+	template<typename TFunctor>
+	void	TimeStage(EFluidStage stage, TFunctor functor);
+
+	void	StepSPH(float dt);
+	void	StepPositionBased(float dt);
+
 	void	ResetAccelerations();
 
+	// Resizes every particle array, new particles are zeroed
+	void	ResizeParticles(size_t count);
+	// Removes killed particles, keeping the others in order
+	void	CompactParticles();
+	template<typename T>
+	void	CompactArray(std::vector<T>& array) const;
+
+	void	ComputeGrid();
 	void	ComputeKeys();
-	int		GetRightKey(int key);
-	int		GetTopKey(int key);
-	void	UpdateProxies();
-	void	AddProxyContacts(size_t a);
+	void	SortParticles();
+	void	ReorderParticles();
+	void	AddCellContacts(size_t a, uint32_t cell, float h);
 	void	AddContact(size_t i, size_t j, float h);
+	void	BuildContacts();
+	struct SNeighborChunk;
+	void	AddNeighbors(size_t i, float h, SNeighborChunk& neighbors) const;
+	// squared : neighbor lengths are stored squared (tabulated kernels), else they are clamped distances
+	void	BuildNeighborLists(bool squared = false);
 	void	FindContacts();
 
-	void	ComputeDensity();
-	void	ComputePressure();
+	// *AVX2 run SFloat8 batches, they are the only fluid code compiled for AVX2
+	template<typename TFloat, bool Tabulated>
+	void	ComputeDensityPressure(size_t begin, size_t end);
+	void	ComputeDensityPressureAVX2(size_t begin, size_t end, bool tabulated);
+	void	ComputeDensityPressure();
 	void	ComputeSurfaceTension();
-	void	AddPressureForces();
-	void	AddViscosityForces();
+	template<typename TFloat, bool Tabulated>
+	void	AddPressureViscosityForces(size_t begin, size_t end);
+	void	AddPressureViscosityForcesAVX2(size_t begin, size_t end, bool tabulated);
+	void	AddPressureViscosityForces();
 	void	BorderCollisions();
 
+	// Position based fluids : lambda of each density constraint, then position corrections from own and neighbors lambdas
+	template<typename TFloat>
+	void	ComputeLambdas(size_t begin, size_t end);
+	void	ComputeLambdasAVX2(size_t begin, size_t end);
+	void	ComputeLambdas();
+	void	ApplyDensityCorrections();
+	void	ApplyXSPHViscosity();
+	// Two way coupling with world polygons : particles near a polygon are found with the particle grid,
+	// pushed out of it and their velocity change is applied back to the polygon as an impulse.
+	void	RigidBodyCollisions();
+
 
 
 	void	ApplyForces(float dt);
 	void	Integrate(float dt);
 
 	void	ClampArray(std::vector<Vec2>& array, float limit);
-	void	FillMesh();
 
 	float				m_radius = 0.2f;
 	float				m_minRadius;
@@ -85,11 +224,40 @@ private:
 	float				m_maxSpeed = 10.0f;
 	float				m_maxAcceleration = 900.0f;
 	float				m_timeScale = 1.0f; // use this to make simulation more stable
+	Vec2				m_gravity = Vec2(0.0f, -5.0f);
 	float				m_wallFriction = 0.4f;
 	float				m_wallRestitution = 0.4f;
 
 	float				m_mass;
 
+	size_t				m_capacity = FLUID_DEFAULT_CAPACITY;
+	std::vector<uint8_t>	m_killed;
+	size_t				m_killedCount = 0;
+
+	// CFL condition : in one step, a particle travels at most m_cflFactor * m_radius at its speed,
+	// and at most m_forceFactor^2 * m_radius from its acceleration
+	float				m_cflFactor = 0.4f;
+	float				m_forceFactor = 0.5f;
+	float				m_minTimeStep = 1.0f / 1000.0f;
+	float				m_maxTimeStep = 1.0f / 60.0f;
+	size_t				m_maxSubSteps = 16; // frame time left after that is dropped, simulation slows down instead of spiraling
+	SFluidStepStats		m_stepStats;
+
+	EFluidSolver		m_solver = EFluidSolver::SPH;
+	size_t				m_pbfIterations = 3;
+	float				m_pbfRestDensity; // density of particles spaced by their radius
+	float				m_pbfMaxTimeStep = 1.0f / 60.0f;
+	float				m_pbfRelaxation = 100.0f; // constraint softness, avoids division by tiny gradients
+	float				m_xsphViscosity = 0.05f;
+
+	SKernelConstants	m_kernel;
+	SKernelConstants	m_surfaceKernel;
+	bool				m_surfaceTension = false;
+
+	EKernelEvaluation	m_kernelEvaluation = EKernelEvaluation::Exact;
+	size_t				m_kernelTableSize = FLUID_KERNEL_TABLE_SIZE;
+	SKernelTable<3>		m_pressureKernelTable;	// spiky gradient factor at r and 0.8 r (near pressure), viscosity laplacian
+
 	std::vector<Vec2>	m_positions;
 	std::vector<Vec2>	m_accelerations;
 	std::vector<Vec2>	m_velocities;
@@ -97,14 +265,68 @@ private:
 	std::vector<float>	m_pressures;
 	std::vector<Vec2>	m_surfaceNormals;
 	std::vector<float>	m_surfaceCurvatures;
-	std::vector<int>	m_keys;
-	std::vector<SParticleProxy>	m_proxies;
+	std::vector<Vec2>	m_previousPositions;
+	std::vector<float>	m_lambdas;
+	std::vector<Vec2>	m_positionDeltas;
+	std::vector<Vec2>	m_neighborGradients;
+
+	// Neighbor search grid : cells are m_radius wide (wider past FLUID_MAX_GRID_CELLS) and cover bounds (or particles when no bounds are set).
+	// Particles are counting sorted by cell, particles of cell c are m_sortedParticles[m_cellStarts[c], m_cellStarts[c + 1]).
+	Vec2					m_gridMin;
+	float					m_invCellSize;
+	uint32_t				m_gridWidth = 0;
+	uint32_t				m_gridHeight = 0;
+	std::vector<uint32_t>	m_cellKeys;
+	std::vector<uint32_t>	m_cellStarts;
+	std::vector<uint32_t>	m_cellCursors;
+	std::vector<uint32_t>	m_sortedParticles;
+
+	// Particle arrays are reordered by cell every few frames for cache locality
+	size_t					m_reorderInterval = 16;
+	size_t					m_framesSinceReorder = 0;
+	std::vector<Vec2>		m_reorderBuffer;
+
+
+	// Gather formulation : each particle reads its own neighbor range and only writes its own values, passes run in parallel
+	// and give the same results whatever the thread count. Otherwise pairs are scattered to both particles sequentially.
+	bool							m_useNeighborLists = true;
+	// Neighbors of particle i are [m_neighborStarts[i], m_neighborStarts[i + 1]), indices and lengths are split for SIMD loads
+	std::vector<uint32_t>			m_neighborStarts;
+	std::vector<uint32_t>			m_neighborIndices;
+	std::vector<float>				m_neighborLengths;
+	bool							m_squaredNeighborLengths = false;
 
+	struct SNeighborChunk
+	{
+		std::vector<uint32_t>	indices;
+		std::vector<float>		lengths;
+		size_t					count = 0;
+	};
+	std::vector<SNeighborChunk>		m_neighborChunks;
 
 	std::vector<SParticleContact>	m_contacts;
 
 	Vec2		m_min, m_max;
-	CFluidMesh	m_mesh;
 };
 
+template<typename TFunctor>
+size_t	CFluidSystem::Emit(size_t count, TFunctor functor)
+{
+	size_t first = m_positions.size();
+	count = Min(count, m_capacity - Min(first, m_capacity));
+	if (count == 0)
+		return 0;
+
+	ResizeParticles(first + count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		functor(i, m_positions[first + i], m_velocities[first + i]);
+		m_previousPositions[first + i] = m_positions[first + i];
+	}
+
+	// new particles are appended unsorted
+	m_framesSinceReorder = m_reorderInterval;
+	return count;
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,92 @@
+#include "FrameArena.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#include "Maths.h"
+#include "JobSystem.h"
+
+// alignment is a power of 2
+static inline uintptr_t	AlignAddress(uintptr_t address, size_t alignment)
+{
+	return (address + alignment - 1) & ~(uintptr_t)(alignment - 1);
+}
+
+CFrameArena::CFrameArena(size_t capacity)
+	: m_capacity(capacity)
+{
+	m_block = static_cast<char*>(malloc(m_capacity));
+}
+
+CFrameArena::~CFrameArena()
+{
+	Reset();
+	free(m_block);
+}
+
+void*	CFrameArena::Allocate(size_t size, size_t alignment)
+{
+	uintptr_t base = reinterpret_cast<uintptr_t>(m_block);
+	size_t offset = (size_t)(AlignAddress(base + m_offset, alignment) - base);
+	if (offset + size <= m_capacity)
+	{
+		m_offset = offset + size;
+		return m_block + offset;
+	}
+
+	// block is full for this frame : heap fallback, counted in the peak so the block fits next frames
+	void* memory = malloc(size + alignment);
+	if (!memory)
+	{
+		throw std::bad_alloc();
+	}
+	m_overflowBlocks.push_back(memory);
+	m_overflowSize += size + alignment;
+	m_peakSize = Max(m_peakSize, GetUsedSize());
+	return reinterpret_cast<void*>(AlignAddress(reinterpret_cast<uintptr_t>(memory), alignment));
+}
+
+void	CFrameArena::Reset()
+{
+	m_peakSize = Max(m_peakSize, GetUsedSize());
+
+	if (!m_overflowBlocks.empty())
+	{
+		for (void* memory : m_overflowBlocks)
+		{
+			free(memory);
+		}
+		m_overflowBlocks.clear();
+		m_overflowSize = 0;
+
+		// grown with some margin, most frames of a same scene have close usages
+		free(m_block);
+		m_capacity = Max(m_capacity * 2, m_peakSize + m_peakSize / 2);
+		m_block = static_cast<char*>(malloc(m_capacity));
+	}
+
+	m_offset = 0;
+}
+
+void	CThreadFrameArenas::Init(size_t threadCount)
+{
+	m_arenas.clear();
+	for (size_t i = 0; i < threadCount; ++i)
+	{
+		m_arenas.push_back(std::unique_ptr<CFrameArena>(new CFrameArena()));
+	}
+}
+
+CFrameArena&	CThreadFrameArenas::Get()
+{
+	return *m_arenas[CJobSystem::GetCurrentThreadIndex()];
+}
+
+void	CThreadFrameArenas::Reset()
+{
+	for (std::unique_ptr<CFrameArena>& arena : m_arenas)
+	{
+		arena->Reset();
+	}
+}
@@ -0,0 +1,86 @@
+#ifndef _FRAME_ARENA_H_
+#define _FRAME_ARENA_H_
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#define FRAME_ARENA_DEFAULT_SIZE (64 * 1024)
+
+// Linear allocator for data living during one simulation step : allocating is a pointer bump, nothing is freed until Reset.
+// When the block is full, allocations go to heap blocks and the block is grown at next Reset to the peak usage,
+// so once warmed up a step never allocates from the heap.
+class CFrameArena
+{
+public:
+	CFrameArena(size_t capacity = FRAME_ARENA_DEFAULT_SIZE);
+	~CFrameArena();
+
+	CFrameArena(const CFrameArena&) = delete;
+	CFrameArena& operator=(const CFrameArena&) = delete;
+
+	void*	Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+	template<typename T>
+	T*		Allocate(size_t count)
+	{
+		return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+	}
+
+	// Invalidates every allocation
+	void	Reset();
+
+	size_t	GetCapacity() const		{ return m_capacity; }
+	size_t	GetUsedSize() const		{ return m_offset + m_overflowSize; }
+	size_t	GetPeakSize() const		{ return m_peakSize; }
+
+private:
+	char*				m_block = nullptr;
+	size_t				m_capacity = 0;
+	size_t				m_offset = 0;
+
+	std::vector<void*>	m_overflowBlocks;
+	size_t				m_overflowSize = 0;
+	size_t				m_peakSize = 0;
+};
+
+// One arena per job system thread (see CJobSystem::GetCurrentThreadIndex), jobs allocate without synchronization
+class CThreadFrameArenas
+{
+public:
+	void			Init(size_t threadCount);
+
+	// Arena of the calling thread
+	CFrameArena&	Get();
+	void			Reset();
+
+private:
+	std::vector<std::unique_ptr<CFrameArena>>	m_arenas;
+};
+
+// std allocator over a frame arena, memory is released by the arena Reset only
+template<typename T>
+class TFrameAllocator
+{
+public:
+	typedef T value_type;
+
+	TFrameAllocator(CFrameArena& arena) : m_arena(&arena){}
+	template<typename U>
+	TFrameAllocator(const TFrameAllocator<U>& other) : m_arena(other.m_arena){}
+
+	T*		allocate(size_t count)			{ return m_arena->Allocate<T>(count); }
+	void	deallocate(T* memory, size_t)	{}
+
+	template<typename U>
+	bool	operator==(const TFrameAllocator<U>& other) const { return m_arena == other.m_arena; }
+	template<typename U>
+	bool	operator!=(const TFrameAllocator<U>& other) const { return m_arena != other.m_arena; }
+
+	CFrameArena*	m_arena;
+};
+
+template<typename T>
+using TFrameVector = std::vector<T, TFrameAllocator<T>>;
+
+#endif
@@ -1,70 +0,0 @@
-#include "GLObject.h"
-
-CGLObject::CGLObject() : m_vertexBufferId(0)
-{}
-
-CGLObject::~CGLObject()
-{
-	DestroyBuffers();
-}
-
-void CGLObject::CreateBuffers()
-{
-	DestroyBuffers();
-
-	float* vertices = new float[3 * points.size()];
-	for (size_t i = 0; i < points.size(); ++i)
-	{
-		vertices[3 * i] = points[i].x;
-		vertices[3 * i + 1] = points[i].y;
-		vertices[3 * i + 2] = 0.0f;
-	}
-
-	glGenBuffers(1, &m_vertexBufferId);
-
-	glBindBuffer(GL_ARRAY_BUFFER, m_vertexBufferId);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 3 * points.size(), vertices, GL_STATIC_DRAW);
-
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-	delete[] vertices;
-}
-
-void CGLObject::BindBuffers()
-{
-	if (m_vertexBufferId != 0)
-	{
-		glBindBuffer(GL_ARRAY_BUFFER, m_vertexBufferId);
-
-		glEnableClientState(GL_VERTEX_ARRAY);
-		glVertexPointer(3, GL_FLOAT, 0, (void*)0);
-	}
-}
-
-
-void CGLObject::DestroyBuffers()
-{
-	if (m_vertexBufferId != 0)
-	{
-		glDeleteBuffers(1, &m_vertexBufferId);
-		m_vertexBufferId = 0;
-	}
-}
-
-void CGLObject::UpdateBuffers()
-{
-	float* vertices = new float[3 * points.size()];
-	for (size_t i = 0; i < points.size(); ++i)
-	{
-		vertices[3 * i] = points[i].x;
-		vertices[3 * i + 1] = points[i].y;
-		vertices[3 * i + 2] = 0.0f;
-	}
-
-	glBindBuffer(GL_ARRAY_BUFFER, m_vertexBufferId);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 3 * points.size(), vertices, GL_STATIC_DRAW);
-
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-	delete[] vertices;
-}
\ No newline at end of file
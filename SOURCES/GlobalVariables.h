@@ -4,7 +4,7 @@
 struct SGlobalVariables
 {
 	class CRenderWindow* pRenderWindow;
-	class CRenderer* pRenderer;
+	class IRenderer* pRenderer;
 	class CWorld* pWorld;
 	class CSceneManager* pSceneManager;
 	class CPhysicEngine* pPhysicEngine;
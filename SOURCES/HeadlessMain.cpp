@@ -0,0 +1,660 @@
+// Headless entry point : runs scenes without window nor OpenGL, for servers, profiling and CI.
+// Command line in PrintUsage
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "AllocationCounter.h"
+#include "Behaviors/CollisionResponse.h"
+#include "Behaviors/SoftStepCollisionResponse.h"
+#include "FixedTimeStep.h"
+#include "FluidBenchmark.h"
+#include "GlobalVariables.h"
+#include "InputRecording.h"
+#include "NullRenderer.h"
+#include "PhysicEngine.h"
+#include "Profiler.h"
+#include "SceneList.h"
+#include "SceneManager.h"
+#include "Timer.h"
+#include "World.h"
+#include "WorldSnapshot.h"
+
+#define HEADLESS_WIDTH 1260
+#define HEADLESS_HEIGHT 768
+#define HEADLESS_WORLD_HEIGHT 50.0f
+#define HEADLESS_FRAME_TIME (1.0f / 60.0f)
+#define HEADLESS_STACKING_SCENE 7 // CSceneStacking in AddAllScenes
+#define HEADLESS_STACKING_TOLERANCE 0.05f // relative change of the pyramid height that counts as a collapse
+#define HEADLESS_SOLVER_BENCHMARK_SCENE 9 // CSceneStacking solved by CCollisionResponse in AddAllScenes
+
+size_t gHeadlessThreadCount = 0; // 0 for hardware concurrency
+bool gHeadlessDeterministic = false;
+bool gHeadlessGravity = false;
+
+void InitHeadless(CRenderWindow* renderWindow = nullptr)
+{
+	gVars = new SGlobalVariables();
+
+	gVars->pRenderWindow = renderWindow ? renderWindow : new CNullRenderWindow(HEADLESS_WIDTH, HEADLESS_HEIGHT);
+	gVars->pRenderer = new CNullRenderer(HEADLESS_WORLD_HEIGHT, (float)HEADLESS_WIDTH / (float)HEADLESS_HEIGHT);
+	gVars->pSceneManager = new CSceneManager();
+	gVars->pPhysicEngine = new CPhysicEngine();
+	if (gHeadlessThreadCount > 0)
+	{
+		gVars->pPhysicEngine->SetThreadCount(gHeadlessThreadCount);
+	}
+	gVars->pPhysicEngine->GetJobSystem().SetDeterministic(gHeadlessDeterministic);
+
+	gVars->bDebug = false;
+	gVars->bDebugElem = false;
+	gVars->bToggleAABB = false;
+	gVars->bToggleMinkoskiCreationDraw = false;
+	gVars->bToggleMinkoskiShapeDraw = false;
+	gVars->bToggleLastSimplexDraw = false;
+	gVars->bToggleEPADebug = false;
+	gVars->bToggleCollision = true;
+	gVars->bToggleGravity = gHeadlessGravity;
+}
+
+bool LoadHeadlessScene(size_t sceneIndex, CRenderWindow* renderWindow = nullptr)
+{
+	InitHeadless(renderWindow);
+	AddAllScenes(gVars->pSceneManager);
+	gVars->pSceneManager->LoadScene(sceneIndex);
+	if (gVars->pWorld == nullptr)
+	{
+		std::cerr << "Invalid scene index " << sceneIndex << std::endl;
+		return false;
+	}
+	return true;
+}
+
+// Same stepping as CRenderer::StepSimulation, with a constant frame time. Returns the number of steps.
+size_t StepHeadlessFrame(CFixedTimeStep& fixedTimeStep, size_t& collisionCount, CInputRecording* recording = nullptr)
+{
+	size_t frameStepCount = fixedTimeStep.Advance(HEADLESS_FRAME_TIME);
+	for (size_t step = 0; step < frameStepCount; ++step)
+	{
+		if (recording)
+		{
+			recording->RecordInput(SInputState::Capture());
+		}
+		gVars->pWorld->SaveTransforms();
+		gVars->pPhysicEngine->Step(fixedTimeStep.GetDeltaTime());
+		gVars->pWorld->Update(fixedTimeStep.GetDeltaTime());
+		collisionCount += gVars->pPhysicEngine->GetCollisions().size();
+		if (recording)
+		{
+			recording->RecordHash(ComputeSimulationHash());
+		}
+	}
+	PROFILE_FRAME();
+	return frameStepCount;
+}
+
+// false once a body or particle diverged to NaN or infinity
+bool IsHeadlessStateFinite()
+{
+	return gVars->pWorld->GetBodies().IsFinite() && CFluidSystem::Get().IsFinite();
+}
+
+// Runs the loaded scene and prints timings, fails if the simulation diverges
+int RunHeadlessFrames(size_t sceneIndex, size_t frameCount)
+{
+	CFixedTimeStep fixedTimeStep;
+	size_t stepCount = 0;
+	size_t collisionCount = 0;
+
+	CTimer timer;
+	timer.Start();
+	for (size_t frame = 0; frame < frameCount; ++frame)
+	{
+		stepCount += StepHeadlessFrame(fixedTimeStep, collisionCount);
+		if (!IsHeadlessStateFinite())
+		{
+			std::cout << "scene " << sceneIndex << " : non finite body or particle state at frame " << frame << std::endl;
+			gVars->pSceneManager->Reset();
+			return 1;
+		}
+	}
+	timer.Stop();
+
+	float duration = timer.GetDuration();
+	std::cout << "scene " << sceneIndex << ", " << gVars->pWorld->GetPolygons().size() << " polygons, "
+		<< frameCount << " frames, " << stepCount << " steps : "
+		<< (duration * 1000.0f / (float)Max(frameCount, (size_t)1)) << " ms/frame, "
+		<< ((float)collisionCount / (float)Max(stepCount, (size_t)1)) << " collisions/step" << std::endl;
+
+	gVars->pSceneManager->Reset();
+	return 0;
+}
+
+int RunHeadless(size_t sceneIndex, size_t frameCount)
+{
+	if (!LoadHeadlessScene(sceneIndex))
+	{
+		return 1;
+	}
+	return RunHeadlessFrames(sceneIndex, frameCount);
+}
+
+// Height between the lowest and the highest dynamic body centers
+float GetDynamicBodiesHeight()
+{
+	const CBodyStore& bodies = gVars->pWorld->GetBodies();
+	float minY = FLT_MAX;
+	float maxY = -FLT_MAX;
+	for (size_t i = 0; i < bodies.GetCount(); ++i)
+	{
+		if (bodies.masses[i] != 0.0f)
+		{
+			minY = Min(minY, bodies.positions[i].y);
+			maxY = Max(maxY, bodies.positions[i].y);
+		}
+	}
+	return (maxY >= minY) ? maxY - minY : 0.0f;
+}
+
+// Stacking scene with gravity on : fails if a body diverges or if the pyramid collapses (or blows up), prints the soft step solver time
+int RunStackingCheck(size_t frameCount)
+{
+	gHeadlessGravity = true;
+	if (!LoadHeadlessScene(HEADLESS_STACKING_SCENE))
+	{
+		return 1;
+	}
+
+	std::shared_ptr<CSoftStepCollisionResponse> solver;
+	gVars->pWorld->ForEachBehavior([&](CBehaviorPtr& behavior)
+	{
+		if (!solver)
+		{
+			solver = std::dynamic_pointer_cast<CSoftStepCollisionResponse>(behavior);
+		}
+	});
+	if (!solver)
+	{
+		std::cerr << "scene " << HEADLESS_STACKING_SCENE << " has no soft step solver" << std::endl;
+		return 1;
+	}
+
+	float startHeight = GetDynamicBodiesHeight();
+	CFixedTimeStep fixedTimeStep;
+	size_t collisionCount = 0;
+	for (size_t frame = 0; frame < frameCount; ++frame)
+	{
+		StepHeadlessFrame(fixedTimeStep, collisionCount);
+		if (!IsHeadlessStateFinite())
+		{
+			std::cout << "stacking : non finite body state at frame " << frame << std::endl;
+			gVars->pSceneManager->Reset();
+			return 1;
+		}
+	}
+	float endHeight = GetDynamicBodiesHeight();
+	bool standing = fabsf(endHeight - startHeight) <= startHeight * HEADLESS_STACKING_TOLERANCE;
+
+	std::cout << "stacking : " << gVars->pWorld->GetPolygons().size() << " polygons, " << frameCount << " frames, pyramid height "
+		<< startHeight << " -> " << endHeight << ", soft step solver " << (solver->GetSolveDuration() * 1000.0f / (float)Max(solver->GetSolveCount(), (size_t)1))
+		<< " ms/step" << std::endl;
+
+	gVars->pSceneManager->Reset();
+	if (!standing)
+	{
+		std::cout << "Pyramid collapsed" << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+// Gravity on, benchmarks the velocity solver paths (scalar, SSE4, AVX8 when supported) on the contacts of each frame,
+// benchmark runs restore the solver state. Prints the frame with the most contacts before the state diverges, fails without contacts.
+int RunSolverBenchmarkCheck(size_t sceneIndex, size_t frameCount)
+{
+	gHeadlessGravity = true;
+	if (!LoadHeadlessScene(sceneIndex))
+	{
+		return 1;
+	}
+
+	std::shared_ptr<CCollisionResponse> solver;
+	gVars->pWorld->ForEachBehavior([&](CBehaviorPtr& behavior)
+	{
+		if (!solver)
+		{
+			solver = std::dynamic_pointer_cast<CCollisionResponse>(behavior);
+		}
+	});
+	if (!solver)
+	{
+		std::cerr << "scene " << sceneIndex << " has no collision response solver" << std::endl;
+		return 1;
+	}
+
+	CFixedTimeStep fixedTimeStep;
+	size_t collisionCount = 0;
+	size_t bestFrame = 0;
+	size_t bestContactCount = 0;
+	std::string bestResult;
+	for (size_t frame = 0; frame < frameCount; ++frame)
+	{
+		solver->RequestSolverBenchmark();
+		StepHeadlessFrame(fixedTimeStep, collisionCount);
+		if (!IsHeadlessStateFinite())
+			break;
+
+		if (solver->GetSolverBenchmarkContactCount() > bestContactCount)
+		{
+			bestFrame = frame;
+			bestContactCount = solver->GetSolverBenchmarkContactCount();
+			bestResult = solver->GetSolverBenchmarkResult();
+		}
+	}
+
+	gVars->pSceneManager->Reset();
+	if (bestContactCount == 0)
+	{
+		std::cout << "scene " << sceneIndex << " : no contacts to benchmark" << std::endl;
+		return 1;
+	}
+
+	std::cout << "scene " << sceneIndex << ", frame " << bestFrame << ", " << bestContactCount << " contacts, "
+		<< SOLVER_BENCHMARK_ITERATIONS << " velocity iterations : " << bestResult << std::endl;
+	return 0;
+}
+
+// Runs frameCount frames to warm up (containers and arenas reach their size), then counts heap allocations of as many frames
+int RunAllocationCheck(size_t sceneIndex, size_t frameCount)
+{
+	if (!LoadHeadlessScene(sceneIndex))
+	{
+		return 1;
+	}
+
+	CFixedTimeStep fixedTimeStep;
+	size_t collisionCount = 0;
+	for (size_t frame = 0; frame < frameCount; ++frame)
+	{
+		StepHeadlessFrame(fixedTimeStep, collisionCount);
+	}
+
+	size_t stepCount = 0;
+	size_t allocationCount = GetHeapAllocationCount();
+	for (size_t frame = 0; frame < frameCount; ++frame)
+	{
+		stepCount += StepHeadlessFrame(fixedTimeStep, collisionCount);
+	}
+	allocationCount = GetHeapAllocationCount() - allocationCount;
+
+	std::cout << "scene " << sceneIndex << ", " << stepCount << " steps after warm up : " << allocationCount << " heap allocations" << std::endl;
+
+	gVars->pSceneManager->Reset();
+	return (allocationCount == 0) ? 0 : 1;
+}
+
+// Profiles frameCount frames after as many warm up frames
+int RunProfile(size_t sceneIndex, size_t frameCount, const std::string& tracePath)
+{
+#ifdef COLLISION_PROFILER
+	if (!LoadHeadlessScene(sceneIndex))
+	{
+		return 1;
+	}
+
+	CFixedTimeStep fixedTimeStep;
+	size_t collisionCount = 0;
+	for (size_t frame = 0; frame < frameCount; ++frame)
+	{
+		StepHeadlessFrame(fixedTimeStep, collisionCount);
+	}
+
+	CProfiler::Get().Reset();
+	for (size_t frame = 0; frame < frameCount; ++frame)
+	{
+		StepHeadlessFrame(fixedTimeStep, collisionCount);
+	}
+
+	CProfiler::Get().WriteSummary(std::cout);
+	bool written = CProfiler::Get().WriteChromeTrace(tracePath);
+	std::cout << (written ? "trace written to " : "failed to write trace ") << tracePath << std::endl;
+
+	gVars->pSceneManager->Reset();
+	return written ? 0 : 1;
+#else
+	std::cerr << "Built without COLLISION_PROFILER" << std::endl;
+	return 1;
+#endif
+}
+
+// Fails if the state of the run never changed or diverged to NaN or infinity
+int RunRecord(const std::string& path, size_t sceneIndex, size_t frameCount)
+{
+	if (!LoadHeadlessScene(sceneIndex))
+	{
+		return 1;
+	}
+
+	CFixedTimeStep fixedTimeStep;
+	CInputRecording recording;
+	recording.Begin((uint32_t)sceneIndex, fixedTimeStep.GetDeltaTime());
+
+	size_t collisionCount = 0;
+	for (size_t frame = 0; frame < frameCount; ++frame)
+	{
+		StepHeadlessFrame(fixedTimeStep, collisionCount, &recording);
+	}
+
+	// a replay can only detect a divergence of a run whose state changes
+	bool moving = false;
+	for (size_t step = 1; step < recording.GetStepCount() && !moving; ++step)
+	{
+		moving = recording.GetHash(step) != recording.GetHash(0);
+	}
+	bool finite = IsHeadlessStateFinite();
+
+	gVars->pSceneManager->Reset();
+	if (!moving || !finite)
+	{
+		std::cerr << "scene " << sceneIndex << " : " << (finite ? "state never changed" : "non finite body or particle state")
+			<< ", recording not written" << std::endl;
+		return 1;
+	}
+	if (!recording.Save(path))
+	{
+		std::cerr << "Failed to write " << path << std::endl;
+		return 1;
+	}
+
+	std::cout << "scene " << sceneIndex << ", " << recording.GetStepCount() << " steps recorded in " << path << std::endl;
+	return 0;
+}
+
+// Same step sequence as CRenderer::StepSimulation, inputs served by the recording
+int RunReplay(const std::string& path)
+{
+	CInputRecording recording;
+	if (!recording.Load(path))
+	{
+		std::cerr << "Invalid recording " << path << std::endl;
+		return 1;
+	}
+
+	CReplayRenderWindow* replayWindow = new CReplayRenderWindow(HEADLESS_WIDTH, HEADLESS_HEIGHT);
+	if (!LoadHeadlessScene(recording.GetSceneIndex(), replayWindow))
+	{
+		return 1;
+	}
+
+	float deltaTime = recording.GetDeltaTime();
+	size_t divergentStep = recording.GetStepCount();
+
+	CTimer timer;
+	timer.Start();
+	for (size_t step = 0; step < recording.GetStepCount(); ++step)
+	{
+		const SInputState& input = recording.GetInput(step);
+		replayWindow->SetInput(input);
+		input.ApplyToggles();
+
+		gVars->pWorld->SaveTransforms();
+		gVars->pPhysicEngine->Step(deltaTime);
+		gVars->pWorld->Update(deltaTime);
+
+		if (ComputeSimulationHash() != recording.GetHash(step))
+		{
+			divergentStep = step;
+			break;
+		}
+	}
+	timer.Stop();
+
+	size_t replayedStepCount = Min(divergentStep + 1, recording.GetStepCount());
+	std::cout << "scene " << recording.GetSceneIndex() << ", " << replayedStepCount << " steps replayed : "
+		<< (timer.GetDuration() * 1000.0f / (float)Max(replayedStepCount, (size_t)1)) << " ms/step" << std::endl;
+
+	gVars->pSceneManager->Reset();
+	if (divergentStep < recording.GetStepCount())
+	{
+		std::cout << "Diverged at step " << divergentStep << std::endl;
+		return 1;
+	}
+
+	std::cout << "Identical to recording" << std::endl;
+	return 0;
+}
+
+// Steps of frameCount frames from the current world, recording their hashes
+void RecordHeadlessFrames(CFixedTimeStep fixedTimeStep, size_t frameCount, CInputRecording& recording)
+{
+	recording.Begin((uint32_t)gVars->pSceneManager->GetCurrentScene(), fixedTimeStep.GetDeltaTime());
+	size_t collisionCount = 0;
+	for (size_t frame = 0; frame < frameCount; ++frame)
+	{
+		StepHeadlessFrame(fixedTimeStep, collisionCount, &recording);
+	}
+}
+
+int RunSnapshot(const std::string& path, size_t sceneIndex, size_t frameCount)
+{
+	if (!LoadHeadlessScene(sceneIndex))
+	{
+		return 1;
+	}
+
+	CFixedTimeStep fixedTimeStep;
+	size_t collisionCount = 0;
+	for (size_t frame = 0; frame < frameCount; ++frame)
+	{
+		StepHeadlessFrame(fixedTimeStep, collisionCount);
+	}
+
+	CTimer timer;
+	timer.Start();
+	bool saved = gVars->pSceneManager->SaveSnapshot(path);
+	timer.Stop();
+	if (!saved)
+	{
+		if (IsHeadlessStateFinite())
+			std::cerr << "Failed to write " << path << std::endl;
+		else
+			std::cerr << "scene " << sceneIndex << " : non finite body or particle state, snapshot not written" << std::endl;
+		return 1;
+	}
+	float saveDuration = timer.GetDuration();
+
+	CInputRecording continued;
+	RecordHeadlessFrames(fixedTimeStep, frameCount, continued);
+
+	timer.Start();
+	bool loaded = gVars->pSceneManager->LoadSnapshot(path);
+	timer.Stop();
+	if (!loaded)
+	{
+		std::cerr << "Invalid snapshot " << path << std::endl;
+		return 1;
+	}
+	float loadDuration = timer.GetDuration();
+
+	CInputRecording resumed;
+	RecordHeadlessFrames(fixedTimeStep, frameCount, resumed);
+
+	size_t divergentStep = 0;
+	while (divergentStep < continued.GetStepCount() && continued.GetHash(divergentStep) == resumed.GetHash(divergentStep))
+	{
+		++divergentStep;
+	}
+
+	std::cout << "scene " << sceneIndex << ", " << gVars->pWorld->GetPolygons().size() << " polygons : saved in "
+		<< saveDuration * 1000.0f << " ms, loaded in " << loadDuration * 1000.0f << " ms" << std::endl;
+
+	gVars->pSceneManager->Reset();
+	if (divergentStep < continued.GetStepCount())
+	{
+		std::cout << "Resumed run diverged at step " << divergentStep << std::endl;
+		return 1;
+	}
+
+	std::cout << "Resumed run identical over " << continued.GetStepCount() << " steps" << std::endl;
+	return 0;
+}
+
+int RunFromSnapshot(const std::string& path, size_t frameCount)
+{
+	InitHeadless();
+	AddAllScenes(gVars->pSceneManager);
+
+	CTimer timer;
+	timer.Start();
+	bool loaded = gVars->pSceneManager->LoadSnapshot(path);
+	timer.Stop();
+	if (!loaded)
+	{
+		std::cerr << "Invalid snapshot " << path << std::endl;
+		return 1;
+	}
+
+	std::cout << "loaded in " << timer.GetDuration() * 1000.0f << " ms" << std::endl;
+	return RunHeadlessFrames(gVars->pSceneManager->GetCurrentScene(), frameCount);
+}
+
+int PrintUsage()
+{
+	std::cerr << "Usage :\n"
+		"CollisionHeadless [sceneIndex] [frameCount]\n"
+		"CollisionHeadless -fluidbench [frameCount] [sph|pbf] [exact|tabulated] : fluid stage timings of a solver and kernel evaluation\n"
+		"CollisionHeadless -stacking [frameCount] : stacking scene with gravity, fails if the pyramid collapses\n"
+		"CollisionHeadless -solverbench [sceneIndex] [frameCount] : velocity solver paths contacts/s, gravity on, on the frame with most contacts\n"
+		"CollisionHeadless -allocations [sceneIndex] [frameCount] : fails if stepping allocates once warmed up\n"
+		"CollisionHeadless -profile [sceneIndex] [frameCount] [trace.json] : Chrome trace and CSV summary, needs COLLISION_PROFILER\n"
+		"CollisionHeadless -record file [sceneIndex] [frameCount] : records inputs and state hashes of a run, fails if its state never changes\n"
+		"CollisionHeadless -replay file : replays a recording (headless or windowed F11), fails at the first diverging step\n"
+		"CollisionHeadless -snapshot file [sceneIndex] [frameCount] : saves the world after frameCount frames, fails if resuming\n"
+		"                                                          from it differs from continuing the run\n"
+		"CollisionHeadless -load file [frameCount] : runs from a world snapshot (headless or windowed F12)\n"
+		"Options before the command : -threads N (job system threads, calling thread included), -deterministic,\n"
+		"                             -gravity (gravity toggle on, it is off by default)"
+		<< std::endl;
+	return 1;
+}
+
+// Optional non negative integer argv[index], defaultValue if absent. false if not a number
+bool ParseCount(int argc, char** argv, int index, size_t defaultValue, size_t& outValue)
+{
+	if (index >= argc)
+	{
+		outValue = defaultValue;
+		return true;
+	}
+
+	const char* text = argv[index];
+	if (*text < '0' || *text > '9')
+		return false;
+	char* end = nullptr;
+	errno = 0;
+	unsigned long long value = std::strtoull(text, &end, 10);
+	if (errno == ERANGE || *end != '\0' || value > SIZE_MAX)
+		return false;
+	outValue = (size_t)value;
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	while (argc > 1)
+	{
+		std::string option = argv[1];
+		if (option == "-threads" && argc > 2)
+		{
+			if (!ParseCount(argc, argv, 2, 0, gHeadlessThreadCount))
+				return PrintUsage();
+			argc -= 2;
+			argv += 2;
+		}
+		else if (option == "-deterministic")
+		{
+			gHeadlessDeterministic = true;
+			argc -= 1;
+			argv += 1;
+		}
+		else if (option == "-gravity")
+		{
+			gHeadlessGravity = true;
+			argc -= 1;
+			argv += 1;
+		}
+		else
+			break;
+	}
+
+	std::string command = (argc > 1) ? argv[1] : "";
+	size_t sceneIndex = 0;
+	size_t frameCount = 0;
+	if (command == "-fluidbench")
+	{
+		EFluidSolver solver = EFluidSolver::SPH;
+		EKernelEvaluation evaluation = EKernelEvaluation::Exact;
+		if (!ParseCount(argc, argv, 2, 60, frameCount))
+			return PrintUsage();
+		for (int i = 3; i < argc; ++i)
+		{
+			if (!ParseFluidBenchmarkOption(argv[i], solver, evaluation))
+				return PrintUsage();
+		}
+		return RunFluidBenchmark(frameCount, solver, evaluation);
+	}
+	if (command == "-stacking")
+	{
+		if (!ParseCount(argc, argv, 2, 300, frameCount))
+			return PrintUsage();
+		return RunStackingCheck(frameCount);
+	}
+	if (command == "-solverbench")
+	{
+		if (!ParseCount(argc, argv, 2, HEADLESS_SOLVER_BENCHMARK_SCENE, sceneIndex) || !ParseCount(argc, argv, 3, 60, frameCount))
+			return PrintUsage();
+		return RunSolverBenchmarkCheck(sceneIndex, frameCount);
+	}
+	if (command == "-allocations")
+	{
+		if (!ParseCount(argc, argv, 2, 0, sceneIndex) || !ParseCount(argc, argv, 3, 120, frameCount))
+			return PrintUsage();
+		return RunAllocationCheck(sceneIndex, frameCount);
+	}
+	if (command == "-profile")
+	{
+		if (!ParseCount(argc, argv, 2, 0, sceneIndex) || !ParseCount(argc, argv, 3, 120, frameCount))
+			return PrintUsage();
+		return RunProfile(sceneIndex, frameCount, (argc > 4) ? argv[4] : "trace.json");
+	}
+
+	if (command == "-record" && argc > 2)
+	{
+		if (!ParseCount(argc, argv, 3, 0, sceneIndex) || !ParseCount(argc, argv, 4, 600, frameCount))
+			return PrintUsage();
+		return RunRecord(argv[2], sceneIndex, frameCount);
+	}
+	if (command == "-replay" && argc > 2)
+	{
+		return RunReplay(argv[2]);
+	}
+	if (command == "-snapshot" && argc > 2)
+	{
+		if (!ParseCount(argc, argv, 3, 0, sceneIndex) || !ParseCount(argc, argv, 4, 120, frameCount))
+			return PrintUsage();
+		return RunSnapshot(argv[2], sceneIndex, frameCount);
+	}
+	if (command == "-load" && argc > 2)
+	{
+		if (!ParseCount(argc, argv, 3, 600, frameCount))
+			return PrintUsage();
+		return RunFromSnapshot(argv[2], frameCount);
+	}
+
+	if (!ParseCount(argc, argv, 1, 0, sceneIndex) || !ParseCount(argc, argv, 2, 600, frameCount))
+		return PrintUsage();
+	return RunHeadless(sceneIndex, frameCount);
+}
@@ -0,0 +1,38 @@
+#ifndef _IRENDERER_H_
+#define _IRENDERER_H_
+
+#include <string>
+
+#include "Maths.h"
+
+// What simulation, behaviors and scenes know of the renderer : world view, debug texts and debug drawing.
+// CRenderer draws with OpenGL, CNullRenderer drops everything for headless runs.
+class IRenderer
+{
+public:
+	virtual ~IRenderer() = default;
+
+	virtual void	SetWorldHeight(float worldHeight) = 0;
+	virtual float	GetWorldWidth() const = 0;
+	virtual float	GetWorldHeight() const = 0;
+
+	// False when texts are dropped (headless, or simulation sub steps but the last one) : texts can be skipped before being formatted
+	virtual bool	IsDisplayingTexts() const = 0;
+	virtual void	DisplayText(const std::string& text) = 0;
+	virtual void	DisplayText(const std::string& text, int x, int y) = 0;
+	virtual void	DisplayTextWorld(const std::string& text, const Vec2& worldPos) = 0;
+	virtual void	DrawLine(const Vec2& from, const Vec2& to, float r, float g, float b) = 0;
+	// Points of a single color, points memory is only read during the call
+	virtual void	DrawPoints(const Vec2* points, size_t count, float r, float g, float b) = 0;
+
+	virtual Vec2	ScreenToWorldPos(const Vec2& pos) const = 0;
+	virtual Vec2	WorldToScreenPos(const Vec2& pos) const = 0;
+
+	// Frame loop, driven by the render window
+	virtual void	Init(){}
+	virtual void	Reset(){}
+	virtual void	Reshape(int width, int height){}
+	virtual void	Update(){}
+};
+
+#endif
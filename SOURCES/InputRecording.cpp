@@ -0,0 +1,194 @@
+#include "InputRecording.h"
+
+#include <fstream>
+
+#include "FluidSystem.h"
+#include "GlobalVariables.h"
+#include "IRenderer.h"
+#include "World.h"
+
+#define INPUT_MOUSE_BUTTON_COUNT 3
+#define INPUT_RECORDING_ENTRY_SIZE 23 // file bytes of an entry : step, mouse position, buttons, keys, toggles
+
+// bit i of SInputState::toggles
+static bool SGlobalVariables::* const gInputToggles[] =
+{
+	&SGlobalVariables::bDebug,
+	&SGlobalVariables::bDebugElem,
+	&SGlobalVariables::bToggleAABB,
+	&SGlobalVariables::bToggleMinkoskiCreationDraw,
+	&SGlobalVariables::bToggleMinkoskiShapeDraw,
+	&SGlobalVariables::bToggleLastSimplexDraw,
+	&SGlobalVariables::bToggleEPADebug,
+	&SGlobalVariables::bToggleCollision,
+	&SGlobalVariables::bToggleGravity,
+};
+
+SInputState SInputState::Capture()
+{
+	SInputState input;
+	input.mousePos = gVars->pRenderer->ScreenToWorldPos(gVars->pRenderWindow->GetMousePos());
+	for (int button = 0; button < INPUT_MOUSE_BUTTON_COUNT; ++button)
+	{
+		input.mouseButtons |= gVars->pRenderWindow->GetMouseButton(button) ? (1u << button) : 0u;
+	}
+	for (uint32_t key = 0; key < (uint32_t)Key::Count; ++key)
+	{
+		input.pressedKeys |= gVars->pRenderWindow->IsPressingKey((Key)key) ? (1u << key) : 0u;
+		input.justPressedKeys |= gVars->pRenderWindow->JustPressedStepKey((Key)key) ? (1u << key) : 0u;
+	}
+
+	for (size_t i = 0; i < sizeof(gInputToggles) / sizeof(gInputToggles[0]); ++i)
+	{
+		input.toggles |= (gVars->*gInputToggles[i]) ? (1u << i) : 0u;
+	}
+	return input;
+}
+
+void SInputState::ApplyToggles() const
+{
+	for (size_t i = 0; i < sizeof(gInputToggles) / sizeof(gInputToggles[0]); ++i)
+	{
+		gVars->*gInputToggles[i] = (toggles & (1u << i)) != 0;
+	}
+}
+
+void CInputRecording::Begin(uint32_t sceneIndex, float deltaTime)
+{
+	m_sceneIndex = sceneIndex;
+	m_deltaTime = deltaTime;
+	m_entries.clear();
+	m_hashes.clear();
+}
+
+void CInputRecording::RecordInput(const SInputState& input)
+{
+	if (m_entries.empty() || m_entries.back().input != input)
+	{
+		m_entries.push_back({ (uint32_t)m_hashes.size(), input });
+	}
+}
+
+void CInputRecording::RecordHash(uint64_t hash)
+{
+	m_hashes.push_back(hash);
+}
+
+const SInputState& CInputRecording::GetInput(size_t step) const
+{
+	// last entry starting at or before step
+	size_t first = 0;
+	size_t last = m_entries.size();
+	while (last - first > 1)
+	{
+		size_t middle = (first + last) / 2;
+		if (m_entries[middle].step <= step)
+			first = middle;
+		else
+			last = middle;
+	}
+	return m_entries[first].input;
+}
+
+template<typename T>
+static void Write(std::ofstream& file, const T& value)
+{
+	file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<typename T>
+static bool Read(std::ifstream& file, T& value)
+{
+	return (bool)file.read(reinterpret_cast<char*>(&value), sizeof(T));
+}
+
+// Little endian : header, entries, hashes
+bool CInputRecording::Save(const std::string& path) const
+{
+	std::ofstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+
+	Write(file, (uint32_t)INPUT_RECORDING_MAGIC);
+	Write(file, (uint32_t)INPUT_RECORDING_VERSION);
+	Write(file, m_sceneIndex);
+	Write(file, m_deltaTime);
+	Write(file, (uint32_t)m_entries.size());
+	Write(file, (uint32_t)m_hashes.size());
+
+	for (const SEntry& entry : m_entries)
+	{
+		Write(file, entry.step);
+		Write(file, entry.input.mousePos.x);
+		Write(file, entry.input.mousePos.y);
+		Write(file, (uint8_t)entry.input.mouseButtons);
+		Write(file, entry.input.pressedKeys);
+		Write(file, entry.input.justPressedKeys);
+		Write(file, (uint16_t)entry.input.toggles);
+	}
+
+	file.write(reinterpret_cast<const char*>(m_hashes.data()), m_hashes.size() * sizeof(uint64_t));
+	return (bool)file;
+}
+
+bool CInputRecording::Load(const std::string& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	uint32_t magic, version, entryCount, stepCount;
+	if (!Read(file, magic) || magic != INPUT_RECORDING_MAGIC || !Read(file, version) || version != INPUT_RECORDING_VERSION)
+		return false;
+
+	if (!Read(file, m_sceneIndex) || !Read(file, m_deltaTime) || !Read(file, entryCount) || !Read(file, stepCount))
+		return false;
+
+	// counts are checked against the file size before anything is allocated from them
+	std::streampos dataBegin = file.tellg();
+	file.seekg(0, std::ios::end);
+	uint64_t dataSize = (uint64_t)(file.tellg() - dataBegin);
+	file.seekg(dataBegin);
+	if ((uint64_t)entryCount * INPUT_RECORDING_ENTRY_SIZE + (uint64_t)stepCount * sizeof(uint64_t) > dataSize)
+		return false;
+
+	m_entries.resize(entryCount);
+	for (SEntry& entry : m_entries)
+	{
+		uint8_t mouseButtons;
+		uint16_t toggles;
+		if (!Read(file, entry.step) || !Read(file, entry.input.mousePos.x) || !Read(file, entry.input.mousePos.y) || !Read(file, mouseButtons)
+			|| !Read(file, entry.input.pressedKeys) || !Read(file, entry.input.justPressedKeys) || !Read(file, toggles))
+			return false;
+
+		entry.input.mouseButtons = mouseButtons;
+		entry.input.toggles = toggles;
+	}
+
+	m_hashes.resize(stepCount);
+	file.read(reinterpret_cast<char*>(m_hashes.data()), m_hashes.size() * sizeof(uint64_t));
+	return (bool)file && (entryCount > 0 || stepCount == 0);
+}
+
+static inline void HashBits(uint64_t& hash, const void* data, size_t size)
+{
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash = (hash ^ bytes[i]) * 1099511628211ull;
+	}
+}
+
+uint64_t ComputeSimulationHash()
+{
+	uint64_t hash = 14695981039346656037ull;
+	if (gVars->pWorld)
+	{
+		const CBodyStore& bodies = gVars->pWorld->GetBodies();
+		HashBits(hash, bodies.positions.data(), bodies.positions.size() * sizeof(Vec2));
+		HashBits(hash, bodies.rotations.data(), bodies.rotations.size() * sizeof(Mat2));
+		HashBits(hash, bodies.speeds.data(), bodies.speeds.size() * sizeof(Vec2));
+		HashBits(hash, bodies.angularVelocities.data(), bodies.angularVelocities.size() * sizeof(float));
+	}
+
+	const std::vector<Vec2>& particles = CFluidSystem::Get().GetPositions();
+	HashBits(hash, particles.data(), particles.size() * sizeof(Vec2));
+	return hash;
+}
@@ -0,0 +1,94 @@
+#ifndef _INPUT_RECORDING_H_
+#define _INPUT_RECORDING_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Maths.h"
+#include "RenderWindow.h"
+
+#define INPUT_RECORDING_MAGIC 0x43455243 // "CREC"
+#define INPUT_RECORDING_VERSION 2 // key bits follow Key
+
+// What a simulation step reads from outside : render window inputs and gVars toggles
+struct SInputState
+{
+	Vec2		mousePos;				// world space, replays run with CNullRenderer whose screen space is the world one
+	uint32_t	mouseButtons = 0;		// bit per button
+	uint32_t	pressedKeys = 0;		// bit per Key
+	uint32_t	justPressedKeys = 0;
+	uint32_t	toggles = 0;			// bit per gVars debug and simulation toggle
+
+	// Current state of gVars window, renderer and toggles
+	static SInputState	Capture();
+	// Sets gVars toggles, window inputs are served by CReplayRenderWindow
+	void				ApplyToggles() const;
+
+	bool operator==(const SInputState& rhs) const
+	{
+		return mousePos.x == rhs.mousePos.x && mousePos.y == rhs.mousePos.y && mouseButtons == rhs.mouseButtons
+			&& pressedKeys == rhs.pressedKeys && justPressedKeys == rhs.justPressedKeys && toggles == rhs.toggles;
+	}
+	bool operator!=(const SInputState& rhs) const { return !(*this == rhs); }
+};
+
+// Inputs of every step of a run from a scene load, and simulation state hash after each step.
+// Inputs are stored when they change only. Replaying inputs on the same scene gives the same hashes,
+// the first different hash tells where a change made the simulation diverge.
+class CInputRecording
+{
+public:
+	void	Begin(uint32_t sceneIndex, float deltaTime);
+	// Call before and after each step
+	void	RecordInput(const SInputState& input);
+	void	RecordHash(uint64_t hash);
+
+	bool	Save(const std::string& path) const;
+	bool	Load(const std::string& path);
+
+	uint32_t	GetSceneIndex() const	{ return m_sceneIndex; }
+	float		GetDeltaTime() const	{ return m_deltaTime; }
+	size_t		GetStepCount() const	{ return m_hashes.size(); }
+	uint64_t	GetHash(size_t step) const	{ return m_hashes[step]; }
+	const SInputState&	GetInput(size_t step) const;
+
+private:
+	struct SEntry
+	{
+		uint32_t	step;	// first step using input
+		SInputState	input;
+	};
+
+	uint32_t				m_sceneIndex = 0;
+	float					m_deltaTime = 0.0f;
+	std::vector<SEntry>		m_entries;
+	std::vector<uint64_t>	m_hashes;
+};
+
+// FNV-1a of the bits of body transforms and velocities, and of fluid particle positions
+uint64_t	ComputeSimulationHash();
+
+// Render window serving recorded inputs
+class CReplayRenderWindow : public CRenderWindow
+{
+public:
+	CReplayRenderWindow(int width, int height)
+		: CRenderWindow(width, height){}
+
+	void			SetInput(const SInputState& input)	{ m_input = input; }
+
+	virtual void	Init() override {}
+
+	virtual Vec2	GetMousePos() override				{ return m_input.mousePos; }
+	virtual bool	GetMouseButton(int button) override	{ return (m_input.mouseButtons & (1u << button)) != 0; }
+	virtual bool	IsPressingKey(Key key) override		{ return (m_input.pressedKeys & (1u << (uint32_t)key)) != 0; }
+	virtual bool	JustPressedKey(Key key) override	{ return (m_input.justPressedKeys & (1u << (uint32_t)key)) != 0; }
+	virtual bool	JustPressedStepKey(Key key) override	{ return JustPressedKey(key); }
+	virtual void	ConsumeStepKeys() override			{ m_input.justPressedKeys = 0; }
+
+private:
+	SInputState	m_input;
+};
+
+#endif
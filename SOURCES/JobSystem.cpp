@@ -0,0 +1,359 @@
+#include "JobSystem.h"
+
+#include <cassert>
+
+#define JOB_SPIN_COUNT 64 // tries to find a job before sleeping
+
+static thread_local size_t tThreadIndex = 0;
+
+bool	CJobSystem::SJobQueue::Push(SJob* job)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (bottom - top >= JOB_QUEUE_SIZE)
+		return false;
+
+	jobs[bottom++ & (JOB_QUEUE_SIZE - 1)] = job;
+	size = bottom - top;
+	return true;
+}
+
+SJob*	CJobSystem::SJobQueue::Pop()
+{
+	if (size == 0)
+		return nullptr;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	if (bottom == top)
+		return nullptr;
+
+	SJob* job = jobs[--bottom & (JOB_QUEUE_SIZE - 1)];
+	size = bottom - top;
+	return job;
+}
+
+SJob*	CJobSystem::SJobQueue::Steal()
+{
+	if (size == 0)
+		return nullptr;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	if (bottom == top)
+		return nullptr;
+
+	SJob* job = jobs[top++ & (JOB_QUEUE_SIZE - 1)];
+	size = bottom - top;
+	return job;
+}
+
+CJobSystem::CJobSystem(size_t threadCount)
+	: m_sleepingWorkers(0), m_queuedJobs(0)
+{
+	StartWorkers(threadCount);
+}
+
+CJobSystem::~CJobSystem()
+{
+	StopWorkers();
+}
+
+void	CJobSystem::SetThreadCount(size_t threadCount)
+{
+	StopWorkers();
+	StartWorkers(threadCount);
+}
+
+size_t	CJobSystem::GetThreadCount() const
+{
+	return m_threads.size();
+}
+
+size_t	CJobSystem::GetCurrentThreadIndex()
+{
+	return tThreadIndex;
+}
+
+void	CJobSystem::SetDeterministic(bool deterministic)
+{
+	m_deterministic = deterministic;
+}
+
+bool	CJobSystem::IsDeterministic() const
+{
+	return m_deterministic;
+}
+
+void	CJobSystem::AddDependency(SJob* job, SJob* dependency)
+{
+	assert(dependency->continuationCount < JOB_MAX_CONTINUATIONS);
+	++job->pendingDependencies;
+	dependency->continuations[dependency->continuationCount++] = job;
+}
+
+void	CJobSystem::Run(SJob* job)
+{
+	if (job->pendingDependencies.fetch_sub(1) == 1)
+	{
+		Push(GetCurrentThreadIndex(), job);
+	}
+}
+
+void	CJobSystem::Wait(SJob* job)
+{
+	size_t threadIndex = GetCurrentThreadIndex();
+	while (job->unfinished.load(std::memory_order_acquire) > 0)
+	{
+		SJob* otherJob = GetJob(threadIndex);
+		if (otherJob)
+		{
+			Execute(otherJob);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+SJob*	CJobSystem::CreateJob(SJob::EKind kind, SJob::TJobFunc func, void* context, size_t begin, size_t end, size_t grainSize)
+{
+	SThreadData& thread = *m_threads[GetCurrentThreadIndex()];
+	// slots of unfinished jobs are skipped, they can outlive as many newer jobs
+	SJob* job = nullptr;
+	for (size_t i = 0; i < JOB_POOL_SIZE && job == nullptr; ++i)
+	{
+		SJob* slot = &thread.pool[thread.nextPoolJob++ & (JOB_POOL_SIZE - 1)];
+		if (slot->unfinished.load(std::memory_order_acquire) == 0)
+		{
+			job = slot;
+		}
+	}
+	assert(job != nullptr); // more than JOB_POOL_SIZE unfinished jobs created by this thread
+
+	job->func = func;
+	job->context = context;
+	job->kind = kind;
+	job->begin = begin;
+	job->end = end;
+	job->grainSize = grainSize;
+	job->stride = 0;
+	job->count = 0;
+	job->parent = nullptr;
+	job->unfinished = 1;
+	job->pendingDependencies = 1;
+	job->continuationCount = 0;
+	return job;
+}
+
+void	CJobSystem::ParallelFor(size_t count, size_t grainSize, SJob::TJobFunc func, void* context)
+{
+	size_t threadCount = GetThreadCount();
+	grainSize = Max(grainSize, (size_t)1);
+
+	if (!m_deterministic)
+	{
+		// ranges are split in halves when executed, idle threads steal the biggest ones
+		size_t rangeSize = Max(grainSize, count / (threadCount * JOB_RANGES_PER_THREAD));
+		SJob* root = CreateJob(SJob::EKind::Range, func, context, 0, count, rangeSize);
+		Execute(root);
+		Wait(root);
+		return;
+	}
+
+	// chunks of grainSize dealt in turn to threads, starting from this one : thread t runs chunks t, t + threadCount...
+	size_t chunkCount = (count + grainSize - 1) / grainSize;
+	size_t threadIndex = GetCurrentThreadIndex();
+	SJob* root = CreateJob(SJob::EKind::Task, nullptr, nullptr, 0, 0, 0);
+	SJob* ownJob = nullptr;
+	for (size_t i = 0; i < Min(threadCount, chunkCount); ++i)
+	{
+		SJob* job = CreateJob(SJob::EKind::StaticRange, func, context, i, chunkCount, grainSize);
+		job->stride = threadCount;
+		job->count = count;
+		job->parent = root;
+		++root->unfinished;
+
+		if (i == 0)
+			ownJob = job;
+		else
+			Push((threadIndex + i) % threadCount, job);
+	}
+
+	Execute(ownJob);
+	Finish(root);
+	Wait(root);
+}
+
+void	CJobSystem::Push(size_t threadIndex, SJob* job)
+{
+	if (!m_threads[threadIndex]->queue.Push(job))
+	{
+		// queue is full, job runs now instead
+		Execute(job);
+		return;
+	}
+
+	++m_queuedJobs;
+	if (m_sleepingWorkers > 0)
+	{
+		std::lock_guard<std::mutex> lock(m_wakeMutex);
+		m_wakeCondition.notify_all();
+	}
+}
+
+SJob*	CJobSystem::GetJob(size_t threadIndex)
+{
+	SThreadData& thread = *m_threads[threadIndex];
+	SJob* job = thread.queue.Pop();
+
+	// no stealing in deterministic mode, jobs run where they were dealt
+	size_t threadCount = GetThreadCount();
+	for (size_t i = 1; !job && !m_deterministic && i < threadCount; ++i)
+	{
+		size_t victim = (threadIndex + thread.nextVictim + i) % threadCount;
+		job = m_threads[victim]->queue.Steal();
+		if (job)
+		{
+			thread.nextVictim = victim;
+		}
+	}
+
+	if (job)
+	{
+		--m_queuedJobs;
+	}
+	return job;
+}
+
+bool	CJobSystem::HasJob(size_t threadIndex) const
+{
+	return m_threads[threadIndex]->queue.size > 0 || (!m_deterministic && m_queuedJobs > 0);
+}
+
+void	CJobSystem::Execute(SJob* job)
+{
+	switch (job->kind)
+	{
+	case SJob::EKind::Task:
+		if (job->func)
+		{
+			job->func(job->context, 0, 0);
+		}
+		break;
+
+	case SJob::EKind::Range:
+		// keeps the first half, second half is left to this thread or to thieves
+		while (job->end - job->begin > job->grainSize)
+		{
+			size_t middle = job->begin + (job->end - job->begin) / 2;
+			SJob* child = CreateJob(SJob::EKind::Range, job->func, job->context, middle, job->end, job->grainSize);
+			child->parent = job;
+			child->pendingDependencies = 0;
+			++job->unfinished;
+			job->end = middle;
+			Push(GetCurrentThreadIndex(), child);
+		}
+		job->func(job->context, job->begin, job->end);
+		break;
+
+	case SJob::EKind::StaticRange:
+		for (size_t chunk = job->begin; chunk < job->end; chunk += job->stride)
+		{
+			job->func(job->context, chunk * job->grainSize, Min((chunk + 1) * job->grainSize, job->count));
+		}
+		break;
+	}
+
+	Finish(job);
+}
+
+void	CJobSystem::Finish(SJob* job)
+{
+	// job may be recycled as soon as it is finished, what is needed is read before
+	SJob* parent = job->parent;
+	int continuationCount = job->continuationCount;
+	SJob* continuations[JOB_MAX_CONTINUATIONS];
+	for (int i = 0; i < continuationCount; ++i)
+	{
+		continuations[i] = job->continuations[i];
+	}
+
+	if (job->unfinished.fetch_sub(1, std::memory_order_acq_rel) != 1)
+		return;
+
+	for (int i = 0; i < continuationCount; ++i)
+	{
+		if (continuations[i]->pendingDependencies.fetch_sub(1) == 1)
+		{
+			Push(GetCurrentThreadIndex(), continuations[i]);
+		}
+	}
+
+	if (parent)
+	{
+		Finish(parent);
+	}
+}
+
+void	CJobSystem::StartWorkers(size_t threadCount)
+{
+	threadCount = Max(threadCount, (size_t)1);
+
+	m_exit = false;
+	m_threads.clear();
+	for (size_t i = 0; i < threadCount; ++i)
+	{
+		m_threads.push_back(std::unique_ptr<SThreadData>(new SThreadData()));
+	}
+
+	for (size_t i = 1; i < threadCount; ++i)
+	{
+		m_workers.push_back(std::thread(&CJobSystem::WorkerLoop, this, i));
+	}
+}
+
+void	CJobSystem::StopWorkers()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_wakeMutex);
+		m_exit = true;
+	}
+	m_wakeCondition.notify_all();
+
+	for (std::thread& worker : m_workers)
+	{
+		worker.join();
+	}
+	m_workers.clear();
+}
+
+void	CJobSystem::WorkerLoop(size_t threadIndex)
+{
+	tThreadIndex = threadIndex;
+
+	size_t spinCount = 0;
+	while (true)
+	{
+		SJob* job = GetJob(threadIndex);
+		if (job)
+		{
+			Execute(job);
+			spinCount = 0;
+			continue;
+		}
+
+		if (++spinCount < JOB_SPIN_COUNT)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_wakeMutex);
+		++m_sleepingWorkers;
+		m_wakeCondition.wait(lock, [&]() { return m_exit || HasJob(threadIndex); });
+		--m_sleepingWorkers;
+
+		if (m_exit)
+			return;
+		spinCount = 0;
+	}
+}
@@ -0,0 +1,176 @@
+#ifndef _JOB_SYSTEM_H_
+#define _JOB_SYSTEM_H_
+
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+#include "Maths.h"
+
+#define JOB_QUEUE_SIZE 1024 // per thread, power of 2
+#define JOB_POOL_SIZE 1024 // per thread, power of 2, at most as many unfinished jobs created by a thread
+#define JOB_MAX_CONTINUATIONS 8
+#define JOB_RANGES_PER_THREAD 8
+
+// Unit of work of CJobSystem. Jobs are taken from per thread pools and recycled : don't keep them once finished.
+struct SJob
+{
+	typedef void(*TJobFunc)(void* context, size_t begin, size_t end);
+
+	enum class EKind
+	{
+		Task,			// func(context, 0, 0)
+		Range,			// func over [begin, end), split in halves down to grainSize
+		StaticRange,	// func over chunks of grainSize, chunk index from begin to end with a stride
+	};
+
+	TJobFunc			func = nullptr;
+	void*				context = nullptr;
+	EKind				kind = EKind::Task;
+	size_t				begin = 0;
+	size_t				end = 0;
+	size_t				grainSize = 0;
+	size_t				stride = 0;
+	size_t				count = 0;
+
+	SJob*				parent = nullptr;
+	std::atomic<int>	unfinished{ 0 };			// this job and its unfinished children
+	std::atomic<int>	pendingDependencies{ 0 };	// unfinished dependencies, plus one until Run is called
+	int					continuationCount = 0;
+	SJob*				continuations[JOB_MAX_CONTINUATIONS];
+};
+
+// Work stealing scheduler shared by every engine stage.
+// Each thread owns a job deque : it pushes and pops at the bottom, idle threads steal from the top of others.
+// The calling thread (index 0) works while it waits, so a single thread setup runs everything inline.
+// Jobs are submitted from one thread at a time outside of the workers, jobs may submit and wait for other jobs.
+class CJobSystem
+{
+public:
+	CJobSystem(size_t threadCount = std::thread::hardware_concurrency());
+	~CJobSystem();
+
+	// Restarts workers, no job must be running
+	void	SetThreadCount(size_t threadCount);
+	// Number of threads running jobs, calling thread included
+	size_t	GetThreadCount() const;
+
+	// Index of the running thread in [0, GetThreadCount()[ : workers are 1 to count - 1, any other thread is 0
+	static size_t	GetCurrentThreadIndex();
+
+	// Deterministic mode, for replays : ParallelFor ranges only depend on count and grain size,
+	// they are dealt to threads in order and never stolen, so jobs run the same way whatever the timing.
+	void	SetDeterministic(bool deterministic);
+	bool	IsDeterministic() const;
+
+	// Job graph : create jobs, add dependencies, then Run them. A job starts once all its dependencies finished.
+	// Functor must live until the job finished.
+	template<typename TFunctor>
+	SJob*	CreateJob(TFunctor& functor)
+	{
+		return CreateJob(SJob::EKind::Task, &CJobSystem::InvokeTask<TFunctor>, &functor, 0, 0, 0);
+	}
+
+	// Neither job nor dependency must be running yet, at most JOB_MAX_CONTINUATIONS jobs depend on a job
+	void	AddDependency(SJob* job, SJob* dependency);
+	void	Run(SJob* job);
+	// Runs other jobs until job finished
+	void	Wait(SJob* job);
+
+	// Call functor(begin, end) over sub ranges of [0, count), blocks until every range is processed.
+	// Ranges are never smaller than grainSize, and grow with count so there are about JOB_RANGES_PER_THREAD per thread.
+	// Small counts are processed on the calling thread only.
+	template<typename TFunctor>
+	void	ParallelFor(size_t count, size_t grainSize, TFunctor functor)
+	{
+		if (count == 0)
+			return;
+
+		if (m_threads.size() == 1 || count <= grainSize)
+		{
+			functor((size_t)0, count);
+			return;
+		}
+
+		ParallelFor(count, grainSize, &CJobSystem::InvokeRange<TFunctor>, &functor);
+	}
+
+	// Call functor(chunk, begin, end) over chunks of [0, count) of chunkSize elements.
+	// Chunks don't depend on threads : outputs written per chunk then merged in chunk order are the same as a sequential run.
+	template<typename TFunctor>
+	void	ParallelForChunks(size_t count, size_t chunkSize, TFunctor functor)
+	{
+		size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+		ParallelFor(chunkCount, 1, [&](size_t beginChunk, size_t endChunk)
+		{
+			for (size_t chunk = beginChunk; chunk < endChunk; ++chunk)
+			{
+				functor(chunk, chunk * chunkSize, Min((chunk + 1) * chunkSize, count));
+			}
+		});
+	}
+
+private:
+	// Job deque of a thread, locked : only contended by steals
+	struct SJobQueue
+	{
+		bool	Push(SJob* job);
+		SJob*	Pop();
+		SJob*	Steal();
+
+		std::mutex			mutex;
+		SJob*				jobs[JOB_QUEUE_SIZE];
+		size_t				top = 0;
+		size_t				bottom = 0;
+		std::atomic<size_t>	size;
+	};
+
+	struct SThreadData
+	{
+		SJobQueue	queue;
+		SJob		pool[JOB_POOL_SIZE];
+		size_t		nextPoolJob = 0;
+		size_t		nextVictim = 0;
+	};
+
+	template<typename TFunctor>
+	static void	InvokeTask(void* context, size_t begin, size_t end)
+	{
+		(*static_cast<TFunctor*>(context))();
+	}
+
+	template<typename TFunctor>
+	static void	InvokeRange(void* context, size_t begin, size_t end)
+	{
+		(*static_cast<TFunctor*>(context))(begin, end);
+	}
+
+	SJob*	CreateJob(SJob::EKind kind, SJob::TJobFunc func, void* context, size_t begin, size_t end, size_t grainSize);
+	void	ParallelFor(size_t count, size_t grainSize, SJob::TJobFunc func, void* context);
+
+	void	Push(size_t threadIndex, SJob* job);
+	SJob*	GetJob(size_t threadIndex);
+	bool	HasJob(size_t threadIndex) const;
+	void	Execute(SJob* job);
+	void	Finish(SJob* job);
+
+	void	StartWorkers(size_t threadCount);
+	void	StopWorkers();
+	void	WorkerLoop(size_t threadIndex);
+
+	std::vector<std::unique_ptr<SThreadData>>	m_threads;
+	std::vector<std::thread>					m_workers;
+	bool										m_deterministic = false;
+
+	// Idle workers sleep until a job is pushed
+	std::mutex					m_wakeMutex;
+	std::condition_variable		m_wakeCondition;
+	std::atomic<size_t>			m_sleepingWorkers;
+	std::atomic<size_t>			m_queuedJobs;
+	bool						m_exit = false;
+};
+
+#endif
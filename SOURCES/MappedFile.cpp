@@ -0,0 +1,105 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+CMappedFile::~CMappedFile()
+{
+	Close();
+}
+
+#ifdef _WIN32
+
+bool CMappedFile::Open(const std::string& path)
+{
+	Close();
+
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	const void* data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (data == nullptr)
+	{
+		if (mapping)
+			CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	m_file = file;
+	m_mapping = mapping;
+	m_data = data;
+	m_size = (size_t)size.QuadPart;
+	return true;
+}
+
+void CMappedFile::Close()
+{
+	if (m_data)
+	{
+		UnmapViewOfFile(m_data);
+		CloseHandle(m_mapping);
+		CloseHandle(m_file);
+	}
+	m_data = nullptr;
+	m_size = 0;
+	m_mapping = nullptr;
+	m_file = nullptr;
+}
+
+#else
+
+bool CMappedFile::Open(const std::string& path)
+{
+	Close();
+
+	int file = open(path.c_str(), O_RDONLY);
+	if (file < 0)
+		return false;
+
+	struct stat status;
+	if (fstat(file, &status) != 0 || status.st_size == 0)
+	{
+		close(file);
+		return false;
+	}
+
+	// the mapping keeps its own reference to the file
+	void* data = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+	if (data == MAP_FAILED)
+		return false;
+
+	m_data = data;
+	m_size = (size_t)status.st_size;
+	return true;
+}
+
+void CMappedFile::Close()
+{
+	if (m_data)
+	{
+		munmap(const_cast<void*>(m_data), m_size);
+	}
+	m_data = nullptr;
+	m_size = 0;
+}
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef _MAPPED_FILE_H_
+#define _MAPPED_FILE_H_
+
+#include <cstddef>
+#include <string>
+
+// Read only memory mapping of a whole file (mmap, MapViewOfFile on Windows).
+// Pages are loaded by the system when first read, data stays valid until Close or destruction.
+class CMappedFile
+{
+public:
+	CMappedFile() = default;
+	~CMappedFile();
+
+	CMappedFile(const CMappedFile&) = delete;
+	CMappedFile& operator=(const CMappedFile&) = delete;
+
+	bool			Open(const std::string& path);
+	void			Close();
+
+	const void*		GetData() const	{ return m_data; }
+	size_t			GetSize() const	{ return m_size; }
+
+private:
+	const void*	m_data = nullptr;
+	size_t		m_size = 0;
+#ifdef _WIN32
+	void*		m_file = nullptr;
+	void*		m_mapping = nullptr;
+#endif
+};
+
+#endif
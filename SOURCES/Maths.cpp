@@ -8,9 +8,29 @@ float Sign(float a)
 	return Select(a >= 0.0f, 1.0f, -1.0f);
 }
 
+#define RANDOM_DEFAULT_STATE 0x9E3779B9u
+
+// xorshift32, state is never 0
+static uint32_t gRandomState = RANDOM_DEFAULT_STATE;
+
+void SetRandomSeed(uint32_t seed)
+{
+	gRandomState = (seed != 0) ? seed : RANDOM_DEFAULT_STATE;
+}
+
+uint32_t GetRandomState()
+{
+	return gRandomState;
+}
+
 float Random(float from, float to)
 {
-	return from + (to - from) * (((float)rand()) / ((float)RAND_MAX));
+	gRandomState ^= gRandomState << 13;
+	gRandomState ^= gRandomState >> 17;
+	gRandomState ^= gRandomState << 5;
+
+	// 24 high bits, exactly representable as float
+	return from + (to - from) * ((float)(gRandomState >> 8) * (1.0f / 16777216.0f));
 }
 
 
@@ -4,6 +4,8 @@
 #define _USE_MATH_DEFINES
 #include <math.h>
 #include <float.h>
+#include <stdint.h>
+#include <algorithm>
 #include <vector>
 
 #define RAD2DEG(x) ((x)*(180.0f/(float)M_PI))
@@ -36,7 +38,11 @@ inline T Clamp(T val, T min, T max)
 
 float Sign(float a);
 
+// Uniform in [from, to), from a generator seeded by SetRandomSeed : same sequence on every platform
 float Random(float from, float to);
+void SetRandomSeed(uint32_t seed);
+// Seeding with the returned state continues the sequence
+uint32_t GetRandomState();
 
 float ClampAngleRadians(float angle);
 
@@ -456,7 +462,7 @@ struct Line
 template<typename T>
 bool find(const T& element, const std::vector<T>& inList)
 {
-	return (std::find(inList.begin(), inList.end(), element) != inList.end())
+	return (std::find(inList.begin(), inList.end(), element) != inList.end());
 }
 
 struct Triangle
@@ -0,0 +1,50 @@
+#ifndef _NULL_RENDERER_H_
+#define _NULL_RENDERER_H_
+
+#include "IRenderer.h"
+#include "RenderWindow.h"
+
+// Renderer of headless runs : keeps the world view so scenes are laid out as in the application, draws nothing
+class CNullRenderer : public IRenderer
+{
+public:
+	CNullRenderer(float worldHeight, float aspectRatio)
+		: m_worldHeight(worldHeight), m_aspectRatio(aspectRatio){}
+
+	virtual void	SetWorldHeight(float worldHeight) override	{ m_worldHeight = worldHeight; }
+	virtual float	GetWorldWidth() const override				{ return m_worldHeight * m_aspectRatio; }
+	virtual float	GetWorldHeight() const override				{ return m_worldHeight; }
+
+	virtual bool	IsDisplayingTexts() const override { return false; }
+	virtual void	DisplayText(const std::string& text) override {}
+	virtual void	DisplayText(const std::string& text, int x, int y) override {}
+	virtual void	DisplayTextWorld(const std::string& text, const Vec2& worldPos) override {}
+	virtual void	DrawLine(const Vec2& from, const Vec2& to, float r, float g, float b) override {}
+	virtual void	DrawPoints(const Vec2* points, size_t count, float r, float g, float b) override {}
+
+	virtual Vec2	ScreenToWorldPos(const Vec2& pos) const override	{ return pos; }
+	virtual Vec2	WorldToScreenPos(const Vec2& pos) const override	{ return pos; }
+
+private:
+	float	m_worldHeight;
+	float	m_aspectRatio;
+};
+
+// Render window of headless runs : no input
+class CNullRenderWindow : public CRenderWindow
+{
+public:
+	CNullRenderWindow(int width, int height)
+		: CRenderWindow(width, height){}
+
+	virtual void	Init() override {}
+
+	virtual Vec2	GetMousePos() override				{ return Vec2(); }
+	virtual bool	GetMouseButton(int button) override	{ return false; }
+	virtual bool	IsPressingKey(Key key) override		{ return false; }
+	virtual bool	JustPressedKey(Key key) override	{ return false; }
+	virtual bool	JustPressedStepKey(Key key) override	{ return false; }
+	virtual void	ConsumeStepKeys() override {}
+};
+
+#endif
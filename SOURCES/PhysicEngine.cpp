@@ -1,16 +1,20 @@
 #include "PhysicEngine.h"
 
 #include <iostream>
+#include <new>
 #include <string>
 #include "GlobalVariables.h"
 #include "World.h"
-#include "Renderer.h" // for debugging only
+#include "IRenderer.h" // for debugging only
+#include "Profiler.h"
 #include "Timer.h"
 
 #include "BroadPhase.h"
 #include "BroadPhaseBrut.h"
 #include "BroadPhaseSAP.h"
 
+#define NARROW_PHASE_GRAIN_SIZE 16
+
 
 void	CPhysicEngine::Reset()
 {
@@ -19,6 +23,9 @@ void	CPhysicEngine::Reset()
 
 	m_active = true;
 
+	m_frameArenas.Init(m_jobSystem.GetThreadCount());
+
+	delete m_broadPhase;
 	//m_broadPhase = new CBroadPhaseBrut(); // Brut Broad phase.
 	m_broadPhase = new CBroadPhaseSAP(); // Sweep and Prune Broad phase.
 }
@@ -28,31 +35,58 @@ void	CPhysicEngine::Activate(bool active)
 	m_active = active;
 }
 
+void	CPhysicEngine::SetThreadCount(size_t threadCount)
+{
+	m_jobSystem.SetThreadCount(threadCount);
+	m_frameArenas.Init(m_jobSystem.GetThreadCount());
+}
+
 void	CPhysicEngine::DetectCollisions()
 {
-	CTimer timer;
-	timer.Start();
-	CollisionBroadPhase();
-	timer.Stop();
-	if (gVars->bDebug)
+	// Narrowphase job starts once broadphase job finished, both spread their work over the job system
+	float broadPhaseDuration = 0.0f;
+	float narrowPhaseDuration = 0.0f;
+	auto broadPhase = [&]()
 	{
-		gVars->pRenderer->DisplayText("Collision broadphase duration " + std::to_string(timer.GetDuration() * 1000.0f) + " ms");
-	}
-
-	timer.Start();
-	CollisionNarrowPhase();
-	timer.Stop();
-	if (gVars->bDebug)
+		PROFILE_ZONE("PhysicEngine::BroadPhase");
+		CTimer timer;
+		timer.Start();
+		CollisionBroadPhase();
+		timer.Stop();
+		broadPhaseDuration = timer.GetDuration();
+	};
+	auto narrowPhase = [&]()
+	{
+		PROFILE_ZONE("PhysicEngine::NarrowPhase");
+		CTimer timer;
+		timer.Start();
+		CollisionNarrowPhase();
+		timer.Stop();
+		narrowPhaseDuration = timer.GetDuration();
+	};
+
+	SJob* broadPhaseJob = m_jobSystem.CreateJob(broadPhase);
+	SJob* narrowPhaseJob = m_jobSystem.CreateJob(narrowPhase);
+	m_jobSystem.AddDependency(narrowPhaseJob, broadPhaseJob);
+	m_jobSystem.Run(narrowPhaseJob);
+	m_jobSystem.Run(broadPhaseJob);
+	m_jobSystem.Wait(narrowPhaseJob);
+
+	if (gVars->bDebug && gVars->pRenderer->IsDisplayingTexts())
 	{
-		gVars->pRenderer->DisplayText("Collision narrowphase duration " + std::to_string(timer.GetDuration() * 1000.0f) + " ms, collisions : " + std::to_string(m_collidingPairs.size()));
+		gVars->pRenderer->DisplayText("Collision broadphase duration " + std::to_string(broadPhaseDuration * 1000.0f) + " ms");
+		gVars->pRenderer->DisplayText("Collision narrowphase duration " + std::to_string(narrowPhaseDuration * 1000.0f) + " ms, collisions : " + std::to_string(m_collidingPairs.size()));
 	}
 }
 
-
 void	CPhysicEngine::Step(float deltaTime)
 {
+	PROFILE_ZONE("PhysicEngine::Step");
 	deltaTime = Min(deltaTime, 1.0f / 15.0f);
 
+	// scratch memory of last step is released
+	m_frameArenas.Reset();
+
 	if (!m_active)
 		return;
 
@@ -62,30 +96,55 @@ void	CPhysicEngine::Step(float deltaTime)
 
 void	CPhysicEngine::CollisionBroadPhase()
 {
+	for (CAABB& bounds : gVars->pWorld->GetBodies().bounds)
+	{
+		bounds.isOverlaping = false;
+	}
 	m_pairsToCheck.clear();
 	m_broadPhase->GetCollidingPairsToCheck(m_pairsToCheck);
+	PROFILE_COUNTER(BroadPhasePairs, m_pairsToCheck.size());
 }
 
 void	CPhysicEngine::CollisionNarrowPhase()
 {
-	for each (CPolygonPtr ptr in gVars->pWorld->GetPolygons())
+	for (const CPolygonPtr& ptr : gVars->pWorld->GetPolygons())
 	{
 		ptr->isOverlaping = false;
 	}
 	m_collidingPairs.clear();
 
-	for (const SPolygonPair& pair : m_pairsToCheck)
-	{
-		SCollision collision;
-		collision.polyA = pair.polyA;
-		collision.polyB = pair.polyB;
-		collision.index = std::make_tuple(pair.polyA->GetIndex(), pair.polyB->GetIndex());
+	// Pairs are checked in parallel, collisions are then gathered in pair order so their order doesn't depend on threads
+	size_t pairCount = m_pairsToCheck.size();
+	CFrameArena& arena = GetFrameArena();
+	SCollision* collisions = arena.Allocate<SCollision>(pairCount);
+	bool* colliding = arena.Allocate<bool>(pairCount);
 
-		if ((pair.polyA->GetMass() != 0 || pair.polyB->GetMass() != 0) && pair.polyA->CheckCollision(*(pair.polyB), collision))
+	m_jobSystem.ParallelFor(pairCount, NARROW_PHASE_GRAIN_SIZE, [&](size_t begin, size_t end)
+	{
+		PROFILE_ZONE("NarrowPhaseRange");
+		for (size_t i = begin; i < end; ++i)
 		{
-			m_collidingPairs.push_back(collision);
-			pair.polyA->isOverlaping = true;
-			pair.polyB->isOverlaping = true;
+			const SPolygonPair& pair = m_pairsToCheck[i];
+			SCollision& collision = *new (&collisions[i]) SCollision();
+			collision.polyA = pair.polyA;
+			collision.polyB = pair.polyB;
+
+			colliding[i] = (pair.polyA->GetMass() != 0 || pair.polyB->GetMass() != 0) && pair.polyA->CheckCollision(*(pair.polyB), collision);
 		}
+	});
+
+	for (size_t i = 0; i < pairCount; ++i)
+	{
+		if (!colliding[i])
+			continue;
+
+		SCollision& collision = collisions[i];
+		// narrow phase may swap polyA and polyB
+		collision.index = std::make_tuple(collision.polyA->GetIndex(), collision.polyB->GetIndex());
+		m_collidingPairs.push_back(collision);
+		collision.polyA->isOverlaping = true;
+		collision.polyB->isOverlaping = true;
 	}
-}
\ No newline at end of file
+
+	PROFILE_COUNTER(Contacts, m_collidingPairs.size());
+}
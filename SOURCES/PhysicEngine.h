@@ -6,6 +6,8 @@
 #include "Maths.h"
 #include "Polygon.h"
 #include "Collision.h"
+#include "FrameArena.h"
+#include "JobSystem.h"
 
 class IBroadPhase;
 
@@ -32,6 +34,13 @@ public:
 	}
 	void						CollisionBroadPhase();
 
+	std::vector<SCollision>&	GetCollisions() { return m_collidingPairs; }
+	CJobSystem&					GetJobSystem() { return m_jobSystem; }
+	// Restarts the job system workers, not during a step
+	void						SetThreadCount(size_t threadCount);
+	// Scratch memory of the calling thread, valid until next Step
+	CFrameArena&				GetFrameArena() { return m_frameArenas.Get(); }
+
 private:
 	friend class CPenetrationVelocitySolver;
 
@@ -40,28 +49,29 @@ private:
 	bool						m_active = true;
 
 	// Collision detection
-	IBroadPhase* m_broadPhase;
+	IBroadPhase* m_broadPhase = nullptr;
 	std::vector<SPolygonPair>	m_pairsToCheck;
 	std::vector<SCollision>		m_collidingPairs;
+
+	CJobSystem					m_jobSystem;
+	CThreadFrameArenas			m_frameArenas;
 public:
-	const std::vector<SPolygonPair> GetBroadPhaseResultPaired() const { return m_pairsToCheck; };
-	const std::vector<CPolygon> GetBroadPhaseResult() const
+	const std::vector<SPolygonPair>& GetBroadPhaseResultPaired() const { return m_pairsToCheck; };
+	void GetBroadPhaseResult(std::vector<CPolygonPtr>& outPolygons) const
 	{
-		std::vector<CPolygon> result;
-		for (SPolygonPair pair : m_pairsToCheck)
+		outPolygons.clear();
+		for (const SPolygonPair& pair : m_pairsToCheck)
 		{
-			result.push_back(*pair.polyA.get());
-			result.push_back(*pair.polyB.get());
+			outPolygons.push_back(pair.polyA);
+			outPolygons.push_back(pair.polyB);
 		}
-
-		return result;
 	};
 
 	const bool IsInBroadPhaseResult(const CPolygon* poly) const
 	{
-		for (SPolygonPair pair : m_pairsToCheck)
+		for (const SPolygonPair& pair : m_pairsToCheck)
 		{
-			if (pair.polyA.get() == poly || pair.polyB.get() == poly)
+			if (pair.polyA == poly || pair.polyB == poly)
 				return true;
 		}
 
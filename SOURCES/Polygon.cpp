@@ -1,58 +1,60 @@
 #include "Polygon.h"
-#include <GL/glu.h>
-
-#include "InertiaTensor.h"
 
 #include "PhysicEngine.h"
+#include "Profiler.h"
 #include "GlobalVariables.h"
 
 #define	MAXITERATION 1000
+// polytope grows of one point per EPA iteration, arena memory of reallocations is only released at frame end
+#define	EPA_RESERVED_POINTS 16
 
-CPolygon::CPolygon(size_t index)
-	: CGLObject(), m_index(index), density(0.1f), aabb(new CAABB(points, position, rotation))
+CPolygon::CPolygon(CBodyStore& bodies, SBodyHandle handle, size_t index)
+	: m_bodies(bodies), m_handle(handle), m_index(index)
 {}
 
 CPolygon::~CPolygon()
 {
-	delete aabb;
 }
 
-void CPolygon::Build()
+void CPolygon::SetShape(const CShapePtr& shape)
 {
-	m_lines.clear();
+	m_shape = shape;
+	m_bodies.positions[m_index] += shape->GetCentroid();
+	if (m_bodies.IsUnsaved(m_index))
+	{
+		m_bodies.previousPositions[m_index] += shape->GetCentroid();
+	}
+	UpdateMassData();
+	GetAABB().ApplyRotation(GetPoints(), GetRotation());
+}
 
-	ComputeArea();
-	RecenterOnCenterOfMass();
-	ComputeLocalInertiaTensor();
+void CPolygon::GetInterpolatedTransform(float alpha, Vec2& outPosition, Mat2& outRotation) const
+{
+	// rotation is blended on its first axis then re-orthonormalized
+	const Vec2& position = GetPosition();
+	const Mat2& rotation = GetRotation();
+	const Vec2& previousPosition = m_bodies.previousPositions[m_index];
+	const Mat2& previousRotation = m_bodies.previousRotations[m_index];
+
+	outPosition = previousPosition + (position - previousPosition) * alpha;
+	Vec2 axis = previousRotation.X + (rotation.X - previousRotation.X) * alpha;
+	outRotation = rotation;
+	if (axis.GetSqrLength() > 0.0001f)
+	{
+		outRotation.X = axis.Normalized();
+		outRotation.Y = outRotation.X.GetNormal();
+	}
+}
 
-	CreateBuffers();
-	BuildLines();
-	aabb->ApplyRotation(points, rotation);
+void	CPolygon::SetDensity(float density)
+{
+	m_density = density;
+	UpdateMassData();
 }
 
-void CPolygon::Draw()
+SBodyHandle	CPolygon::GetHandle() const
 {
-	// Set transforms (assuming model view mode is set)
-	float transfMat[16] = { rotation.X.x, rotation.X.y, 0.0f, 0.0f,
-							rotation.Y.x, rotation.Y.y, 0.0f, 0.0f,
-							0.0f, 0.0f, 0.0f, 1.0f,
-							position.x, position.y, -1.0f, 1.0f };
-	glPushMatrix();
-	glMultMatrixf(transfMat);
-
-	// Draw vertices
-	BindBuffers();
-	if (isOverlaping)
-		glColor3f(0, 1, 0);
-	else
-		glColor3f(0, 0, 1);
-	glDrawArrays(GL_LINE_LOOP, 0, points.size());
-	glDisableClientState(GL_VERTEX_ARRAY);
-
-	glPopMatrix();
-
-	if (gVars->bDebugElem && gVars->bToggleAABB)
-		aabb->Draw();
+	return m_handle;
 }
 
 size_t	CPolygon::GetIndex() const
@@ -62,26 +64,30 @@ size_t	CPolygon::GetIndex() const
 
 float	CPolygon::GetArea() const
 {
-	return fabsf(m_signedArea);
+	return m_shape->GetArea();
 }
 
 Vec2	CPolygon::TransformPoint(const Vec2& point) const
 {
-	return position + rotation * point;
+	return GetPosition() + GetRotation() * point;
 }
 
 Vec2	CPolygon::InverseTransformPoint(const Vec2& point) const
 {
-	return rotation.GetInverseOrtho() * (point - position);
+	return GetRotation().GetInverseOrtho() * (point - GetPosition());
 }
 
 bool	CPolygon::IsPointInside(const Vec2& point) const
 {
+	float boundingRadius = m_shape->GetBoundingRadius() + EPSILON;
+	if ((point - GetPosition()).GetSqrLength() > boundingRadius * boundingRadius)
+		return false;
+
 	float maxDist = -FLT_MAX;
 
-	for (const Line& line : m_lines)
+	for (const Line& line : m_shape->GetLines())
 	{
-		Line globalLine = line.Transform(rotation, position);
+		Line globalLine = line.Transform(GetRotation(), GetPosition());
 		float pointDist = globalLine.GetPointDist(point);
 		maxDist = Max(maxDist, pointDist);
 	}
@@ -89,6 +95,26 @@ bool	CPolygon::IsPointInside(const Vec2& point) const
 	return maxDist <= 0.0f;
 }
 
+float	CPolygon::GetPointSeparation(const Vec2& point, Vec2& outNormal) const
+{
+	Vec2 localPoint = InverseTransformPoint(point);
+	float maxDist = -FLT_MAX;
+	Vec2 normal;
+
+	for (const Line& line : m_shape->GetLines())
+	{
+		float pointDist = line.GetPointDist(localPoint);
+		if (pointDist > maxDist)
+		{
+			maxDist = pointDist;
+			normal = line.GetNormal();
+		}
+	}
+
+	outNormal = GetRotation() * normal;
+	return maxDist;
+}
+
 bool	CPolygon::IsLineIntersectingPolygon(const Line& line, Vec2& colPoint, float& colDist) const
 {
 	//float dist = 0.0f;
@@ -97,7 +123,7 @@ bool	CPolygon::IsLineIntersectingPolygon(const Line& line, Vec2& colPoint, float
 	float lastDist = 0.0f;
 	bool intersecting = false;
 
-	for (const Vec2& point : points)
+	for (const Vec2& point : GetPoints())
 	{
 		Vec2 globalPoint = TransformPoint(point);
 		float dist = line.GetPointDist(globalPoint);
@@ -121,29 +147,32 @@ bool	CPolygon::IsLineIntersectingPolygon(const Line& line, Vec2& colPoint, float
 
 bool	CPolygon::CheckCollision(CPolygon& poly, SCollision& collisionInfo)
 {
-	std::vector<Vec2> outSimplex;
+	TFrameVector<Vec2> outSimplex(gVars->pPhysicEngine->GetFrameArena());
+	outSimplex.reserve(EPA_RESERVED_POINTS);
 	if (GJK(poly, outSimplex))
 	{
-		EPA(std::vector<Vec2>(outSimplex), poly, collisionInfo);
+		EPA(outSimplex, poly, collisionInfo);
+		collisionInfo.polyA->BuildManifold(*collisionInfo.polyB, collisionInfo);
 		return true;
 	}
 	return false;
 }
 
-bool	CPolygon::CheckCollisionDebug(CPolygon& poly, SCollision& collisionInfo, Vec2& otherResult, std::vector<Vec2>& outSimplex)
+bool	CPolygon::CheckCollisionDebug(CPolygon& poly, SCollision& collisionInfo, Vec2& otherResult, TFrameVector<Vec2>& outSimplex)
 {
 	if (GJK(poly, outSimplex))
 	{
 		if (gVars->bToggleEPADebug)
-			EPADebug(std::vector<Vec2>(outSimplex), poly, collisionInfo, otherResult);
+			EPADebug(outSimplex, poly, collisionInfo, otherResult);
 		else
-			EPA(std::vector<Vec2>(outSimplex), poly, collisionInfo);
+			EPA(outSimplex, poly, collisionInfo);
+		collisionInfo.polyA->BuildManifold(*collisionInfo.polyB, collisionInfo);
 		return true;
 	}
 	return false;
 }
 
-bool CPolygon::GJK(const CPolygon& poly, std::vector<Vec2>& outSimplex) const
+bool CPolygon::GJK(const CPolygon& poly, TFrameVector<Vec2>& outSimplex) const
 {
 	Vec2 dir = Vec2(1.0f, 0.0f);
 
@@ -167,6 +196,7 @@ bool CPolygon::GJK(const CPolygon& poly, std::vector<Vec2>& outSimplex) const
 
 	for (size_t i = 0; i < MAXITERATION; i++)
 	{
+		PROFILE_COUNTER(GJKIterations, 1);
 		if (C.GetSqrLength() != 0)
 		{
 			ACangle = Clamp(ANormalized | CNormalized, -1.0f, 1.0f);
@@ -212,7 +242,7 @@ bool CPolygon::GJK(const CPolygon& poly, std::vector<Vec2>& outSimplex) const
 	return false;
 }
 
-void CPolygon::EPA(std::vector<Vec2>& polytope, CPolygon& poly, SCollision& collisionInfo)
+void CPolygon::EPA(TFrameVector<Vec2>& polytope, CPolygon& poly, SCollision& collisionInfo)
 {
 	Vec2 A = Vec2(0, 0);
 	Vec2 B = Vec2(0, 0);
@@ -226,6 +256,7 @@ void CPolygon::EPA(std::vector<Vec2>& polytope, CPolygon& poly, SCollision& coll
 	size_t minIndex = 0;
 	for (size_t limit = 0; limit < MAXITERATION; limit++)
 	{
+		PROFILE_COUNTER(EPAIterations, 1);
 		minDistance = FLT_MAX;
 		for (size_t i = 0; i < polytope.size(); i++)
 		{
@@ -256,14 +287,14 @@ void CPolygon::EPA(std::vector<Vec2>& polytope, CPolygon& poly, SCollision& coll
 			//PolyA:
 			Vec2 pt1 = Support(minNormal * -1);
 			Vec2 t1 = pt1 + minNormal * (minDistance - EPSILON);
-			float AT1L = (t1 - position).GetLength();
-			float T1BL = (poly.position - t1).GetLength();
+			float AT1L = (t1 - GetPosition()).GetLength();
+			float T1BL = (poly.GetPosition() - t1).GetLength();
 			
 			//PolyB:
 			Vec2 pt2 = poly.Support(minNormal);
 			Vec2 t2 = pt2 - minNormal * (minDistance - EPSILON);
-			float AT2L = (t2 - position).GetLength();
-			float T2BL = (poly.position - t2).GetLength();
+			float AT2L = (t2 - GetPosition()).GetLength();
+			float T2BL = (poly.GetPosition() - t2).GetLength();
 
 			bool testResult = ((AT1L + T1BL) - (AT2L + T2BL) < EPSILON);
 			bool t1In = poly.IsPointInside(t1);
@@ -280,7 +311,7 @@ void CPolygon::EPA(std::vector<Vec2>& polytope, CPolygon& poly, SCollision& coll
 				{
 					collisionInfo.point = t2;
 					collisionInfo.normal = minNormal;
-					collisionInfo.polyA.swap(collisionInfo.polyB);
+					std::swap(collisionInfo.polyA, collisionInfo.polyB);
 
 				}
 			}
@@ -293,7 +324,7 @@ void CPolygon::EPA(std::vector<Vec2>& polytope, CPolygon& poly, SCollision& coll
 			{
 				collisionInfo.point = t2;
 				collisionInfo.normal = minNormal;
-				collisionInfo.polyA.swap(collisionInfo.polyB);
+				std::swap(collisionInfo.polyA, collisionInfo.polyB);
 			}
 			else
 			{
@@ -306,7 +337,7 @@ void CPolygon::EPA(std::vector<Vec2>& polytope, CPolygon& poly, SCollision& coll
 				{
 					collisionInfo.point = t2;
 					collisionInfo.normal = minNormal;
-					collisionInfo.polyA.swap(collisionInfo.polyB);
+					std::swap(collisionInfo.polyA, collisionInfo.polyB);
 
 				}
 			}
@@ -317,7 +348,121 @@ void CPolygon::EPA(std::vector<Vec2>& polytope, CPolygon& poly, SCollision& coll
 	}
 }
 
-void CPolygon::EPADebug(std::vector<Vec2>& polytope, CPolygon& poly, SCollision& collisionInfo, Vec2& otherResult)
+void CPolygon::BuildManifold(const CPolygon& poly, SCollision& collisionInfo) const
+{
+	collisionInfo.manifoldSize = 0;
+
+	// Separating axis test on both polygons edges, EPA normal is not reliable for shallow contacts
+	size_t edgeA, edgeB;
+	float separationA = FindMaxSeparation(poly, edgeA);
+	float separationB = poly.FindMaxSeparation(*this, edgeB);
+	if (separationA > EPSILON || separationB > EPSILON)
+		return;
+
+	// Reference edge is the one of least penetration, A is favored to keep feature ids stable
+	bool flip = separationB > separationA + 0.1f * EPSILON;
+	const CPolygon& refPoly = flip ? poly : *this;
+	const CPolygon& incPoly = flip ? *this : poly;
+	size_t refEdge = flip ? edgeB : edgeA;
+
+	Vec2 refFrom, refTo, refNormal;
+	refPoly.GetWorldEdge(refEdge, refFrom, refTo, refNormal);
+
+	size_t incEdge = incPoly.GetBestEdge(refNormal * -1.0f);
+	Vec2 incFrom, incTo, incNormal;
+	incPoly.GetWorldEdge(incEdge, incFrom, incTo, incNormal);
+
+	Vec2 incPoints[2] = { incFrom, incTo };
+	size_t incIds[2] = { incEdge, (incEdge + 1) % incPoly.GetPoints().size() };
+
+	// Clip incident edge by reference edge side planes
+	Vec2 tangent = (refTo - refFrom).Normalized();
+	float sideOffsets[2] = { -(refFrom | tangent), refTo | tangent };
+	Vec2 sideNormals[2] = { tangent * -1.0f, tangent };
+	for (size_t side = 0; side < 2; ++side)
+	{
+		float dist0 = (incPoints[0] | sideNormals[side]) - sideOffsets[side];
+		float dist1 = (incPoints[1] | sideNormals[side]) - sideOffsets[side];
+		if (dist0 > 0.0f && dist1 > 0.0f)
+			return;
+
+		if (dist0 > 0.0f || dist1 > 0.0f)
+		{
+			Vec2 clipped = incPoints[0] + (incPoints[1] - incPoints[0]) * (dist0 / (dist0 - dist1));
+			incPoints[(dist0 > 0.0f) ? 0 : 1] = clipped;
+		}
+	}
+
+	for (size_t i = 0; i < 2; ++i)
+	{
+		float separation = (incPoints[i] - refFrom) | refNormal;
+		if (separation > EPSILON)
+			continue;
+
+		// Contact point halfway between incident point and reference edge
+		Vec2 point = incPoints[i] - refNormal * (separation * 0.5f);
+		size_t featureId = ((flip ? 1 : 0) << 15) | ((refEdge & 0x7F) << 8) | (incIds[i] & 0xFF);
+
+		collisionInfo.manifold[collisionInfo.manifoldSize++] = SContactInfo(collisionInfo.polyA, collisionInfo.polyB,
+			point, flip ? refNormal * -1.0f : refNormal, -separation, featureId);
+	}
+}
+
+void CPolygon::GetWorldEdge(size_t index, Vec2& from, Vec2& to, Vec2& normal) const
+{
+	const std::vector<Vec2>& points = GetPoints();
+	from = TransformPoint(points[index]);
+	to = TransformPoint(points[(index + 1) % points.size()]);
+
+	// points are centered on center of mass, outward whatever the winding
+	normal = (to - from).GetNormal().Normalized();
+	if ((normal | (from - GetPosition())) < 0.0f)
+		normal *= -1.0f;
+}
+
+float CPolygon::FindMaxSeparation(const CPolygon& poly, size_t& outEdge) const
+{
+	float maxSeparation = -FLT_MAX;
+	outEdge = 0;
+	for (size_t index = 0; index < GetPoints().size(); ++index)
+	{
+		Vec2 from, to, normal;
+		GetWorldEdge(index, from, to, normal);
+
+		float separation = FLT_MAX;
+		for (const Vec2& point : poly.GetPoints())
+		{
+			separation = Min(separation, (poly.TransformPoint(point) - from) | normal);
+		}
+
+		if (separation > maxSeparation)
+		{
+			maxSeparation = separation;
+			outEdge = index;
+		}
+	}
+	return maxSeparation;
+}
+
+size_t CPolygon::GetBestEdge(const Vec2& dir) const
+{
+	size_t bestEdge = 0;
+	float bestProjection = -FLT_MAX;
+	for (size_t index = 0; index < GetPoints().size(); ++index)
+	{
+		Vec2 from, to, normal;
+		GetWorldEdge(index, from, to, normal);
+		float projection = normal | dir;
+		if (projection > bestProjection)
+		{
+			bestProjection = projection;
+			bestEdge = index;
+		}
+	}
+	return bestEdge;
+}
+
+void CPolygon::EPADebug(TFrameVector<Vec2>& polytope, CPolygon& poly, SCollision& collisionInfo, Vec2& otherResult)
 {
 	Vec2 A = Vec2(0, 0);
 	Vec2 B = Vec2(0, 0);
@@ -361,14 +506,14 @@ void CPolygon::EPADebug(std::vector<Vec2>& polytope, CPolygon& poly, SCollision&
 			//PolyA:
 			Vec2 pt1 = Support(minNormal * -1);
 			Vec2 t1 = pt1 + minNormal * (minDistance - EPSILON);
-			float AT1L = (t1 - position).GetLength();
-			float T1BL = (poly.position - t1).GetLength();
+			float AT1L = (t1 - GetPosition()).GetLength();
+			float T1BL = (poly.GetPosition() - t1).GetLength();
 
 			//PolyB:
 			Vec2 pt2 = poly.Support(minNormal);
 			Vec2 t2 = pt2 - minNormal * (minDistance - EPSILON);
-			float AT2L = (t2 - position).GetLength();
-			float T2BL = (poly.position - t2).GetLength();
+			float AT2L = (t2 - GetPosition()).GetLength();
+			float T2BL = (poly.GetPosition() - t2).GetLength();
 
 			bool testResult = ((AT1L + T1BL) - (AT2L + T2BL) < EPSILON);
 			bool t1In = poly.IsPointInside(t1);
@@ -386,7 +531,7 @@ void CPolygon::EPADebug(std::vector<Vec2>& polytope, CPolygon& poly, SCollision&
 				{
 					collisionInfo.point = t2;
 					collisionInfo.normal = minNormal;
-					collisionInfo.polyA.swap(collisionInfo.polyB);
+					std::swap(collisionInfo.polyA, collisionInfo.polyB);
 					otherResult = t1;
 				}
 			}
@@ -400,7 +545,7 @@ void CPolygon::EPADebug(std::vector<Vec2>& polytope, CPolygon& poly, SCollision&
 			{
 				collisionInfo.point = t2;
 				collisionInfo.normal = minNormal;
-				collisionInfo.polyA.swap(collisionInfo.polyB);
+				std::swap(collisionInfo.polyA, collisionInfo.polyB);
 				otherResult = t1;
 			}
 			else
@@ -415,7 +560,7 @@ void CPolygon::EPADebug(std::vector<Vec2>& polytope, CPolygon& poly, SCollision&
 				{
 					collisionInfo.point = t2;
 					collisionInfo.normal = minNormal;
-					collisionInfo.polyA.swap(collisionInfo.polyB);
+					std::swap(collisionInfo.polyA, collisionInfo.polyB);
 					otherResult = t1;
 
 				}
@@ -428,7 +573,7 @@ void CPolygon::EPADebug(std::vector<Vec2>& polytope, CPolygon& poly, SCollision&
 
 float CPolygon::GetMass() const
 {
-	return density * GetArea();
+	return m_bodies.masses[m_index];
 }
 
 float CPolygon::GetInvMass() const
@@ -439,7 +584,7 @@ float CPolygon::GetInvMass() const
 
 float CPolygon::GetInertiaTensor() const
 {
-	return m_localInertiaTensor * GetMass();
+	return m_bodies.inertias[m_index];
 }
 
 float CPolygon::GetInversedInertiaTensor() const
@@ -450,62 +595,12 @@ float CPolygon::GetInversedInertiaTensor() const
 
 Vec2 CPolygon::GetPointVelocity(const Vec2& point) const
 {
-	return speed + (point - position).GetNormal() * angularVelocity;
+	return GetSpeed() + (point - GetPosition()).GetNormal() * GetAngularVelocity();
 }
 
-void CPolygon::BuildLines()
+void CPolygon::UpdateMassData()
 {
-	for (size_t index = 0; index < points.size(); ++index)
-	{
-		const Vec2 pointA = points[index];
-		const Vec2 pointB = points[(index + 1) % points.size()];
-
-		Vec2 lineDir = (pointA - pointB).Normalized();
-
-		m_lines.push_back(Line(pointB, lineDir, (pointA - pointB).GetLength()));
-	}
-}
-
-void CPolygon::ComputeArea()
-{
-	m_signedArea = 0.0f;
-	for (size_t index = 0; index < points.size(); ++index)
-	{
-		const Vec2& pointA = points[index];
-		const Vec2& pointB = points[(index + 1) % points.size()];
-		m_signedArea += pointA.x * pointB.y - pointB.x * pointA.y;
-	}
-	m_signedArea *= 0.5f;
-}
-
-void CPolygon::RecenterOnCenterOfMass()
-{
-	Vec2 centroid;
-	for (size_t index = 0; index < points.size(); ++index)
-	{
-		const Vec2& pointA = points[index];
-		const Vec2& pointB = points[(index + 1) % points.size()];
-		float factor = pointA.x * pointB.y - pointB.x * pointA.y;
-		centroid.x += (pointA.x + pointB.x) * factor;
-		centroid.y += (pointA.y + pointB.y) * factor;
-	}
-	centroid /= 6.0f * m_signedArea;
-
-	for (Vec2& point : points)
-	{
-		point -= centroid;
-	}
-	position += centroid;
-}
-
-void CPolygon::ComputeLocalInertiaTensor()
-{
-	m_localInertiaTensor = 0.0f;
-	for (size_t i = 0; i + 1 < points.size(); ++i)
-	{
-		const Vec2& pointA = points[i];
-		const Vec2& pointB = points[i + 1];
-
-		m_localInertiaTensor += ComputeInertiaTensor_Triangle(Vec2(), pointA, pointB);
-	}
+	float mass = m_density * GetArea();
+	m_bodies.masses[m_index] = mass;
+	m_bodies.inertias[m_index] = m_shape->GetLocalInertiaTensor() * mass;
 }
@@ -2,50 +2,125 @@
 #define _POLYGON_H_
 
 #include <vector>
-#include <memory>
 
-#include "GLObject.h"
 #include "Maths.h"
 #include "AABB.h"
+#include "BodyStore.h"
+#include "FrameArena.h"
+#include "Shape.h"
 
 struct SCollision;
 
-class CPolygon : public CGLObject
+// Body of a shared shape and collision queries. Simulation state (transform, velocities, mass data, bounds) is stored
+// in the world body store, at the polygon dense index.
+class CPolygon
 {
 private:
 	friend class CWorld;
+	friend class CWorldSnapshot;
 
-	CPolygon(size_t index);
+	CPolygon(CBodyStore& bodies, SBodyHandle handle, size_t index);
+	CPolygon(const CPolygon&) = delete;
+	CPolygon& operator=(const CPolygon&) = delete;
 public:
 	~CPolygon();
 
-	Vec2				position;
-	Mat2				rotation;
 	float				bounciness = 0.5f;
 	float				friction = 0.5f;
 
+	inline const Vec2& GetPosition() const
+	{
+		return m_bodies.positions[m_index];
+	}
+
 	inline void SetPosition(const Vec2& inPosition)
 	{
-		position = inPosition;
-		aabb->position = inPosition;
+		m_bodies.positions[m_index] = inPosition;
+		m_bodies.bounds[m_index].position = inPosition;
+		if (m_bodies.IsUnsaved(m_index))
+		{
+			m_bodies.previousPositions[m_index] = inPosition;
+		}
 	}
 
 	inline void AddPosition(const Vec2& inPosition)
 	{
-		position += inPosition;
-		aabb->position += inPosition;
+		m_bodies.positions[m_index] += inPosition;
+		m_bodies.bounds[m_index].position += inPosition;
+		if (m_bodies.IsUnsaved(m_index))
+		{
+			m_bodies.previousPositions[m_index] += inPosition;
+		}
+	}
+
+	inline const Mat2& GetRotation() const
+	{
+		return m_bodies.rotations[m_index];
 	}
 
 	inline void SetRotation(const Mat2& inRotation)
 	{
-		rotation = inRotation;
-		aabb->ApplyRotation(points, inRotation);
+		m_bodies.rotations[m_index] = inRotation;
+		m_bodies.bounds[m_index].ApplyRotation(GetPoints(), inRotation);
+		if (m_bodies.IsUnsaved(m_index))
+		{
+			m_bodies.previousRotations[m_index] = inRotation;
+		}
+	}
+
+	inline const Vec2& GetSpeed() const
+	{
+		return m_bodies.speeds[m_index];
 	}
 
-	void				Build();
-	void				Draw();
+	inline void SetSpeed(const Vec2& inSpeed)
+	{
+		m_bodies.speeds[m_index] = inSpeed;
+	}
+
+	inline float GetAngularVelocity() const
+	{
+		return m_bodies.angularVelocities[m_index];
+	}
+
+	inline void SetAngularVelocity(float inAngularVelocity)
+	{
+		m_bodies.angularVelocities[m_index] = inAngularVelocity;
+	}
+
+	inline CAABB& GetAABB()
+	{
+		return m_bodies.bounds[m_index];
+	}
+
+	// 0 makes the polygon static
+	inline float GetDensity() const
+	{
+		return m_density;
+	}
+
+	void				SetDensity(float density);
+
+	SBodyHandle			GetHandle() const;
+	// Dense index in the body store, changes when another polygon is removed
 	size_t				GetIndex() const;
 
+	inline const CShapePtr& GetShape() const
+	{
+		return m_shape;
+	}
+
+	// Local space, centered on center of mass
+	inline const std::vector<Vec2>& GetPoints() const
+	{
+		return m_shape->GetPoints();
+	}
+
+	// Polygon moves by the shape centroid, so the points given to create the shape keep their place
+	void				SetShape(const CShapePtr& shape);
+	// Transform blended between previous (alpha 0) and current (alpha 1) ones, for rendering
+	void				GetInterpolatedTransform(float alpha, Vec2& outPosition, Mat2& outRotation) const;
+
 	float				GetArea() const;
 
 	Vec2				TransformPoint(const Vec2& point) const;
@@ -53,12 +128,18 @@ public:
 
 	// if point is outside then returned distance is negative (and doesn't make sense)
 	bool				IsPointInside(const Vec2& point) const;
+	// Max signed distance from point to edge lines, negative inside. outNormal is the world normal of that edge.
+	float				GetPointSeparation(const Vec2& point, Vec2& outNormal) const;
 
 	bool				CheckCollision(CPolygon& poly, SCollision& collisionInfo);
-	bool				CheckCollisionDebug(CPolygon& poly, SCollision& collisionInfo, Vec2& otherResult = Vec2(), std::vector<Vec2>& outSimplex = std::vector<Vec2>());
-	bool				GJK(const CPolygon& poly, std::vector<Vec2>& outSimplex) const;
-	void				EPA(std::vector<Vec2>& polytope, CPolygon& poly, SCollision& collisionInfo);
-	void				EPADebug(std::vector<Vec2>& polytope, CPolygon& poly, SCollision& collisionInfo, Vec2& otherResult);
+	// Simplex and polytope are allocated from the frame arena of the calling thread
+	bool				CheckCollisionDebug(CPolygon& poly, SCollision& collisionInfo, Vec2& otherResult, TFrameVector<Vec2>& outSimplex);
+	bool				GJK(const CPolygon& poly, TFrameVector<Vec2>& outSimplex) const;
+	void				EPA(TFrameVector<Vec2>& polytope, CPolygon& poly, SCollision& collisionInfo);
+	void				EPADebug(TFrameVector<Vec2>& polytope, CPolygon& poly, SCollision& collisionInfo, Vec2& otherResult);
+	// Fills collisionInfo manifold by clipping incident edge against reference edge (least penetrating axis), this must be collisionInfo polyA.
+	// Manifold stays empty if polygons are actually separated.
+	void				BuildManifold(const CPolygon& poly, SCollision& collisionInfo) const;
 	// If line intersect polygon, colDist is the penetration distance, and colPoint most penetrating point of poly inside the line
 	bool				IsLineIntersectingPolygon(const Line& line, Vec2& colPoint, float& colDist) const;
 	float				GetMass() const;
@@ -67,30 +148,11 @@ public:
 	float				GetInversedInertiaTensor() const;
 
 	Vec2				GetPointVelocity(const Vec2& point) const;
-	// Physics
-	float				density;
-	Vec2				speed;
-	CAABB* aabb;
-	bool isOverlaping = false;
-	float				angularVelocity = 0.0f;
-	Vec2				forces;
-	float				torques = 0.0f;
+	bool				isOverlaping = false;
 
 	inline const Vec2 Support(const Vec2& dir) const
 	{
-		Vec2 support;
-		float maxProjection = -FLT_MAX;
-		for (Vec2 vertex : points)
-		{
-			vertex = rotation * vertex + position;
-			float projection = vertex | dir;
-			if (projection > maxProjection)
-			{
-				maxProjection = projection;
-				support = vertex;
-			}
-		}
-		return support;
+		return m_shape->Support(dir, GetRotation(), GetPosition());
 	}
 
 	inline const std::vector<Vec2> MinkovskiDiff(const CPolygon& poly, std::vector<Vec2>& outABase, std::vector<Vec2>& outBBase) const
@@ -111,21 +173,25 @@ public:
 	}
 
 private:
-	void				BuildLines();
+	// Edge from points[index] to next point, normal pointing outward
+	void				GetWorldEdge(size_t index, Vec2& from, Vec2& to, Vec2& normal) const;
+	size_t				GetBestEdge(const Vec2& dir) const;
+	// Max over this edges of poly distance to the edge, negative when overlapping
+	float				FindMaxSeparation(const CPolygon& poly, size_t& outEdge) const;
 
-	void				ComputeArea();
-	void				RecenterOnCenterOfMass(); // Area must be computed
-	void				ComputeLocalInertiaTensor(); // Must be centered on center of mass
-	size_t				m_index;
+	void				UpdateMassData();
 
-	std::vector<Line>	m_lines;
+	CBodyStore&			m_bodies;
+	SBodyHandle			m_handle;
+	size_t				m_index;
 
-	float				m_signedArea;
+	CShapePtr			m_shape;
 
 	// Physics
-	float				m_localInertiaTensor; // don't consider mass
+	float				m_density = 0.1f;
 };
 
-typedef std::shared_ptr<CPolygon>	CPolygonPtr;
+// Polygons are owned by the world, pointers stay valid until the polygon is removed
+typedef CPolygon*	CPolygonPtr;
 
 #endif
\ No newline at end of file
@@ -0,0 +1,209 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <ostream>
+
+static thread_local void* tThreadBuffer = nullptr;
+
+CProfiler& CProfiler::Get()
+{
+	static CProfiler profiler;
+	return profiler;
+}
+
+CProfiler::CProfiler()
+	: m_startTime(GetTime()), m_frames(PROFILER_FRAME_RING_SIZE)
+{}
+
+uint64_t CProfiler::GetTime()
+{
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+CProfiler::SThreadBuffer& CProfiler::GetThreadBuffer()
+{
+	if (tThreadBuffer == nullptr)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		SThreadBuffer* buffer = new SThreadBuffer();
+		for (std::atomic<uint64_t>& counter : buffer->counters)
+		{
+			counter = 0;
+		}
+		buffer->threadId = (uint32_t)m_threadBuffers.size();
+		m_threadBuffers.push_back(std::unique_ptr<SThreadBuffer>(buffer));
+		tThreadBuffer = buffer;
+	}
+	return *static_cast<SThreadBuffer*>(tThreadBuffer);
+}
+
+uint32_t CProfiler::EnterZone()
+{
+	return GetThreadBuffer().depth++;
+}
+
+void CProfiler::LeaveZone(const char* name, uint64_t beginTime, uint32_t depth)
+{
+	uint64_t endTime = GetTime();
+	SThreadBuffer& buffer = GetThreadBuffer();
+	buffer.depth = depth;
+
+	uint64_t zoneCount = buffer.zoneCount.load(std::memory_order_relaxed);
+	SZone& zone = buffer.zones[zoneCount & (PROFILER_ZONE_RING_SIZE - 1)];
+	zone.name = name;
+	zone.beginTime = beginTime;
+	zone.endTime = endTime;
+	zone.depth = depth;
+	buffer.zoneCount.store(zoneCount + 1, std::memory_order_release);
+}
+
+void CProfiler::AddCounter(EProfileCounter counter, uint64_t value)
+{
+	// single writer, no atomic add needed
+	std::atomic<uint64_t>& threadCounter = GetThreadBuffer().counters[(size_t)counter];
+	threadCounter.store(threadCounter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+uint64_t CProfiler::SumCounter(EProfileCounter counter) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	uint64_t sum = 0;
+	for (const std::unique_ptr<SThreadBuffer>& buffer : m_threadBuffers)
+	{
+		sum += buffer->counters[(size_t)counter].load(std::memory_order_relaxed);
+	}
+	return sum;
+}
+
+void CProfiler::EndFrame()
+{
+	SFrame& frame = m_frames[m_frameCount & (PROFILER_FRAME_RING_SIZE - 1)];
+	frame.endTime = GetTime();
+	for (size_t i = 0; i < (size_t)EProfileCounter::Count; ++i)
+	{
+		uint64_t total = SumCounter((EProfileCounter)i);
+		frame.counters[i] = total - m_frameCounters[i];
+		m_frameCounters[i] = total;
+	}
+	++m_frameCount;
+}
+
+const char* CProfiler::GetCounterName(EProfileCounter counter)
+{
+	switch (counter)
+	{
+	case EProfileCounter::BroadPhasePairs:	return "BroadPhasePairs";
+	case EProfileCounter::Contacts:			return "Contacts";
+	case EProfileCounter::GJKIterations:	return "GJKIterations";
+	case EProfileCounter::EPAIterations:	return "EPAIterations";
+	case EProfileCounter::SolverIterations:	return "SolverIterations";
+	default:								return "Unknown";
+	}
+}
+
+bool CProfiler::WriteChromeTrace(const std::string& path) const
+{
+	std::ofstream file(path);
+	if (!file)
+		return false;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	// complete events ("X") per zone, times in us since profiler start
+	file << "{\"traceEvents\":[\n";
+	bool first = true;
+	for (const std::unique_ptr<SThreadBuffer>& buffer : m_threadBuffers)
+	{
+		uint64_t zoneCount = buffer->zoneCount.load(std::memory_order_acquire);
+		for (uint64_t i = zoneCount - std::min(zoneCount, (uint64_t)PROFILER_ZONE_RING_SIZE); i < zoneCount; ++i)
+		{
+			const SZone& zone = buffer->zones[i & (PROFILER_ZONE_RING_SIZE - 1)];
+			file << (first ? "" : ",\n") << "{\"name\":\"" << zone.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << buffer->threadId
+				<< ",\"ts\":" << (double)(zone.beginTime - m_startTime) * 0.001 << ",\"dur\":" << (double)(zone.endTime - zone.beginTime) * 0.001 << "}";
+			first = false;
+		}
+	}
+
+	// one counter track per counter, a sample per frame
+	for (uint64_t i = m_frameCount - std::min(m_frameCount, (uint64_t)PROFILER_FRAME_RING_SIZE); i < m_frameCount; ++i)
+	{
+		const SFrame& frame = m_frames[i & (PROFILER_FRAME_RING_SIZE - 1)];
+		for (size_t counter = 0; counter < (size_t)EProfileCounter::Count; ++counter)
+		{
+			file << (first ? "" : ",\n") << "{\"name\":\"" << GetCounterName((EProfileCounter)counter) << "\",\"ph\":\"C\",\"pid\":0,\"ts\":"
+				<< (double)(frame.endTime - m_startTime) * 0.001 << ",\"args\":{\"value\":" << frame.counters[counter] << "}}";
+			first = false;
+		}
+	}
+	file << "\n]}\n";
+
+	return (bool)file;
+}
+
+void CProfiler::WriteSummary(std::ostream& stream) const
+{
+	struct SZoneStats
+	{
+		uint32_t	depth = UINT32_MAX;
+		uint64_t	calls = 0;
+		uint64_t	totalTime = 0;
+		uint64_t	maxTime = 0;
+	};
+
+	// zones still in rings, by name
+	std::map<std::string, SZoneStats> zoneStats;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (const std::unique_ptr<SThreadBuffer>& buffer : m_threadBuffers)
+		{
+			uint64_t zoneCount = buffer->zoneCount.load(std::memory_order_acquire);
+			for (uint64_t i = zoneCount - std::min(zoneCount, (uint64_t)PROFILER_ZONE_RING_SIZE); i < zoneCount; ++i)
+			{
+				const SZone& zone = buffer->zones[i & (PROFILER_ZONE_RING_SIZE - 1)];
+				SZoneStats& stats = zoneStats[zone.name];
+				uint64_t duration = zone.endTime - zone.beginTime;
+				stats.depth = std::min(stats.depth, zone.depth);
+				stats.calls++;
+				stats.totalTime += duration;
+				stats.maxTime = std::max(stats.maxTime, duration);
+			}
+		}
+	}
+
+	double frameCount = (double)std::max(m_frameCount, (uint64_t)1);
+	stream << "zone,depth,calls,total ms,ms per frame,average us,max us\n";
+	for (const auto& entry : zoneStats)
+	{
+		const SZoneStats& stats = entry.second;
+		stream << entry.first << "," << stats.depth << "," << stats.calls << ","
+			<< (double)stats.totalTime * 1e-6 << "," << (double)stats.totalTime * 1e-6 / frameCount << ","
+			<< (double)stats.totalTime * 1e-3 / (double)stats.calls << "," << (double)stats.maxTime * 1e-3 << "\n";
+	}
+
+	stream << "counter,total,per frame\n";
+	for (size_t counter = 0; counter < (size_t)EProfileCounter::Count; ++counter)
+	{
+		uint64_t total = SumCounter((EProfileCounter)counter);
+		stream << GetCounterName((EProfileCounter)counter) << "," << total << "," << (double)total / frameCount << "\n";
+	}
+}
+
+void CProfiler::Reset()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (const std::unique_ptr<SThreadBuffer>& buffer : m_threadBuffers)
+	{
+		buffer->zoneCount = 0;
+		for (std::atomic<uint64_t>& counter : buffer->counters)
+		{
+			counter = 0;
+		}
+	}
+
+	m_startTime = GetTime();
+	m_frameCount = 0;
+	std::fill(m_frameCounters, m_frameCounters + (size_t)EProfileCounter::Count, 0);
+}
@@ -0,0 +1,121 @@
+#ifndef _PROFILER_H_
+#define _PROFILER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define PROFILER_ZONE_RING_SIZE (64 * 1024) // zones kept per thread, power of 2, oldest are overwritten
+#define PROFILER_FRAME_RING_SIZE 4096 // frames kept for counter tracks, power of 2
+
+enum class EProfileCounter : int
+{
+	BroadPhasePairs,
+	Contacts,
+	GJKIterations,
+	EPAIterations,
+	SolverIterations,
+
+	Count,
+};
+
+// Scoped zones and counters recorded per thread without locks, exported as a Chrome trace (chrome://tracing, Perfetto)
+// and summarized as CSV. Instrumented code uses the PROFILE_ macros : they compile to nothing unless COLLISION_PROFILER is defined.
+class CProfiler
+{
+public:
+	static CProfiler&	Get();
+
+	// Steady clock, ns
+	static uint64_t	GetTime();
+
+	// Returns depth of the new zone on calling thread
+	uint32_t	EnterZone();
+	void		LeaveZone(const char* name, uint64_t beginTime, uint32_t depth);
+
+	void		AddCounter(EProfileCounter counter, uint64_t value);
+	// Closes a frame : counters since last frame become a sample of the counter tracks
+	void		EndFrame();
+
+	// Following calls read every thread data, no zone nor counter must be recorded meanwhile
+	bool		WriteChromeTrace(const std::string& path) const;
+	// zone,depth,calls,total ms,ms per frame,average us,max us then counter,total,per frame
+	void		WriteSummary(std::ostream& stream) const;
+	void		Reset();
+
+	static const char*	GetCounterName(EProfileCounter counter);
+
+private:
+	CProfiler();
+
+	struct SZone
+	{
+		const char*	name;
+		uint64_t	beginTime;
+		uint64_t	endTime;
+		uint32_t	depth;
+	};
+
+	// Written by its thread only, zoneCount is published after the zone is written
+	struct SThreadBuffer
+	{
+		SZone					zones[PROFILER_ZONE_RING_SIZE];
+		std::atomic<uint64_t>	zoneCount{ 0 };
+		std::atomic<uint64_t>	counters[(size_t)EProfileCounter::Count];
+		uint32_t				depth = 0;
+		uint32_t				threadId = 0;
+	};
+
+	struct SFrame
+	{
+		uint64_t	endTime;
+		uint64_t	counters[(size_t)EProfileCounter::Count];
+	};
+
+	SThreadBuffer&	GetThreadBuffer();
+	uint64_t		SumCounter(EProfileCounter counter) const;
+
+	// Registration of thread buffers, once per thread
+	mutable std::mutex							m_mutex;
+	std::vector<std::unique_ptr<SThreadBuffer>>	m_threadBuffers;
+
+	uint64_t				m_startTime;
+	std::vector<SFrame>		m_frames;
+	uint64_t				m_frameCount = 0;
+	uint64_t				m_frameCounters[(size_t)EProfileCounter::Count] = {};	// totals at last EndFrame
+};
+
+class CProfileZone
+{
+public:
+	CProfileZone(const char* name)
+		: m_name(name), m_depth(CProfiler::Get().EnterZone()), m_beginTime(CProfiler::GetTime()){}
+	~CProfileZone()
+	{
+		CProfiler::Get().LeaveZone(m_name, m_beginTime, m_depth);
+	}
+
+private:
+	const char*	m_name;
+	uint32_t	m_depth;
+	uint64_t	m_beginTime;
+};
+
+#ifdef COLLISION_PROFILER
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+// Zone from here to the end of the scope, name must be a string literal
+#define PROFILE_ZONE(name) CProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_COUNTER(counter, value) CProfiler::Get().AddCounter(EProfileCounter::counter, (uint64_t)(value))
+#define PROFILE_FRAME() CProfiler::Get().EndFrame()
+#else
+#define PROFILE_ZONE(name)
+#define PROFILE_COUNTER(counter, value)
+#define PROFILE_FRAME()
+#endif
+
+#endif
@@ -0,0 +1,35 @@
+#include "RenderSnapshot.h"
+
+#include "Polygon.h"
+#include "World.h"
+
+void	CRenderSnapshot::Capture(CWorld* world, float alpha, bool captureBounds)
+{
+	positions.clear();
+	rotations.clear();
+	overlapping.clear();
+	shapes.clear();
+	bounds.clear();
+	worldDraws.Clear();
+
+	if (world == nullptr)
+		return;
+
+	for (const CPolygonPtr& polygon : world->GetPolygons())
+	{
+		Vec2 position;
+		Mat2 rotation;
+		polygon->GetInterpolatedTransform(alpha, position, rotation);
+		positions.push_back(position);
+		rotations.push_back(rotation);
+		overlapping.push_back(polygon->isOverlaping);
+
+		shapes.push_back(polygon->GetShape());
+	}
+
+	if (captureBounds)
+	{
+		const std::vector<CAABB>& worldBounds = world->GetBodies().bounds;
+		bounds.assign(worldBounds.begin(), worldBounds.end());
+	}
+}
@@ -0,0 +1,100 @@
+#ifndef _RENDER_SNAPSHOT_H_
+#define _RENDER_SNAPSHOT_H_
+
+#include <vector>
+#include <string>
+
+#include "Maths.h"
+#include "AABB.h"
+#include "Shape.h"
+
+class CWorld;
+
+struct SRenderText
+{
+	SRenderText(const std::string& _text, int _x, int _y) : text(_text), x(_x), y(_y){}
+
+	std::string	text;
+	int x, y; // screen space (0,0) left bottom corner
+};
+
+// Texts of a frame : placed ones, and lines stacked from the top left corner when rendered
+struct SRenderTextList
+{
+	std::vector<SRenderText>	texts;
+	std::vector<std::string>	lines;
+	bool						mute = false;
+
+	void	Clear()
+	{
+		texts.clear();
+		lines.clear();
+	}
+
+	void	Append(const SRenderTextList& other)
+	{
+		texts.insert(texts.end(), other.texts.begin(), other.texts.end());
+		lines.insert(lines.end(), other.lines.begin(), other.lines.end());
+	}
+};
+
+// Debug draws recorded in call order, to be issued later by the render thread
+struct SDrawList
+{
+	struct SCommand
+	{
+		bool	isLine;	// else points
+		size_t	first;	// in vertices
+		size_t	count;
+		float	r, g, b;
+	};
+
+	std::vector<Vec2>		vertices;
+	std::vector<SCommand>	commands;
+
+	void	Clear()
+	{
+		vertices.clear();
+		commands.clear();
+	}
+
+	void	AddLine(const Vec2& from, const Vec2& to, float r, float g, float b)
+	{
+		commands.push_back({ true, vertices.size(), 2, r, g, b });
+		vertices.push_back(from);
+		vertices.push_back(to);
+	}
+
+	void	AddPoints(const Vec2* points, size_t count, float r, float g, float b)
+	{
+		commands.push_back({ false, vertices.size(), count, r, g, b });
+		vertices.insert(vertices.end(), points, points + count);
+	}
+};
+
+// Everything the renderer needs to draw a frame, copied out of the world between simulation frames.
+// The renderer keeps two : one is drawn while the simulation of next frame records its debug draws in the other.
+class CRenderSnapshot
+{
+public:
+	// Copies interpolated polygon transforms and shapes, and bounds when asked. Empty if world is null.
+	void	Capture(CWorld* world, float alpha, bool captureBounds);
+
+	size_t	GetPolygonCount() const	{ return positions.size(); }
+
+	// Polygons
+	std::vector<Vec2>	positions;
+	std::vector<Mat2>	rotations;
+	std::vector<char>	overlapping;
+	std::vector<CShapePtr>	shapes;	// immutable, shared with the world instead of copying points
+	std::vector<CAABB>	bounds;
+
+	// Recorded while simulating
+	SDrawList			simulationDraws;
+	SRenderTextList		simulationTexts;
+
+	// Recorded while capturing (behaviors Render)
+	SDrawList			worldDraws;
+};
+
+#endif
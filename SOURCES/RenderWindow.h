@@ -10,7 +10,13 @@ enum class Key : unsigned int
 	F3,
 	F4,
 	F5,
+	F6,
+	F7,
 	F8,
+	F9,
+	F10,
+	F11,
+	F12,
 	NumPad0,
 	NumPad1,
 	NumPad2,
@@ -37,7 +43,11 @@ public:
 	virtual Vec2	GetMousePos() = 0;
 	virtual bool	GetMouseButton(int button) = 0;
 	virtual bool	IsPressingKey(Key key) = 0;
+	// Pressed since last frame
 	virtual bool	JustPressedKey(Key key) = 0;
+	// Pressed since last ConsumeStepKeys, for simulation steps : presses of frames running no step are kept for next one
+	virtual bool	JustPressedStepKey(Key key) = 0;
+	virtual void	ConsumeStepKeys() = 0;
 
 protected:
 	int	m_width;
@@ -2,21 +2,26 @@
 #include <GL/glew.h>
 
 #include <stdio.h>
-#include <iostream>
 #include <string>
 
 #include "GlobalVariables.h"
 #include "Renderer.h"
 #include "RenderWindow.h"
+#include "AABB.h"
 #include "Polygon.h"
 #include "PhysicEngine.h"
+#include "Profiler.h"
 #include "SceneManager.h"
 #include "World.h"
 
 #include "drawtext.h"
 
+// While set, draws and texts of the calling thread are recorded in these lists instead of being issued (see CRenderer::Update)
+static thread_local SDrawList* tRecordedDraws = nullptr;
+static thread_local SRenderTextList* tRecordedTexts = nullptr;
+
 CRenderer::CRenderer(float worldHeight)
-	: m_worldHeight(worldHeight), m_lastFPS(0.0f), m_lastFPSSince(0.0f), m_textCursor(0), m_FPS(FPS::Unlocked)
+	: m_worldHeight(worldHeight), m_lastFPS(0.0f), m_lastFPSSince(0.0f), m_FPS(FPS::Unlocked)
 {}
 
 CRenderer::~CRenderer(){}
@@ -39,14 +44,37 @@ float	CRenderer::GetWorldHeight() const
 	return m_worldHeight;
 }
 
+SRenderTextList& CRenderer::GetTextList()
+{
+	return tRecordedTexts ? *tRecordedTexts : m_renderTexts;
+}
+
+const SRenderTextList& CRenderer::GetTextList() const
+{
+	return tRecordedTexts ? *tRecordedTexts : m_renderTexts;
+}
+
+bool CRenderer::IsDisplayingTexts() const
+{
+	return !GetTextList().mute;
+}
+
 void CRenderer::DisplayText(const std::string& text)
 {
-	DisplayText(text, 50, gVars->pRenderWindow->Getheight() - 50 - 30 * m_textCursor++);
+	SRenderTextList& textList = GetTextList();
+	if (textList.mute)
+		return;
+
+	textList.lines.push_back(text);
 }
 
 void CRenderer::DisplayText(const std::string& text, int x, int y)
 {
-	m_renderTexts.push_back(SRenderText(text, x, y));
+	SRenderTextList& textList = GetTextList();
+	if (textList.mute)
+		return;
+
+	textList.texts.push_back(SRenderText(text, x, y));
 }
 
 void CRenderer::DisplayTextWorld(const std::string& text, const Vec2& worldPos)
@@ -57,6 +85,28 @@ void CRenderer::DisplayTextWorld(const std::string& text, const Vec2& worldPos)
 
 
 void CRenderer::DrawLine(const Vec2& from, const Vec2& to, float r, float g, float b)
+{
+	if (tRecordedDraws)
+	{
+		tRecordedDraws->AddLine(from, to, r, g, b);
+		return;
+	}
+
+	DrawLineNow(from, to, r, g, b);
+}
+
+void CRenderer::DrawPoints(const Vec2* points, size_t count, float r, float g, float b)
+{
+	if (tRecordedDraws)
+	{
+		tRecordedDraws->AddPoints(points, count, r, g, b);
+		return;
+	}
+
+	DrawPointsNow(points, count, r, g, b);
+}
+
+void CRenderer::DrawLineNow(const Vec2& from, const Vec2& to, float r, float g, float b)
 {
 	glColor3f(r, g, b);
 	glBegin(GL_LINES);
@@ -65,6 +115,94 @@ void CRenderer::DrawLine(const Vec2& from, const Vec2& to, float r, float g, flo
 	glEnd();
 }
 
+void CRenderer::DrawPointsNow(const Vec2* points, size_t count, float r, float g, float b)
+{
+	m_pointMesh.SetColor(r, g, b);
+	m_pointMesh.Upload(points, count);
+	m_pointMesh.Draw();
+}
+
+void CRenderer::DrawPolygon(const Vec2& position, const Mat2& rotation, const Vec2* points, size_t pointCount, bool overlapping)
+{
+	// Set transforms (assuming model view mode is set)
+	float transfMat[16] = { rotation.X.x, rotation.X.y, 0.0f, 0.0f,
+							rotation.Y.x, rotation.Y.y, 0.0f, 0.0f,
+							0.0f, 0.0f, 0.0f, 1.0f,
+							position.x, position.y, -1.0f, 1.0f };
+	glPushMatrix();
+	glMultMatrixf(transfMat);
+
+	// Draw vertices from client memory
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glVertexPointer(2, GL_FLOAT, sizeof(Vec2), points);
+	if (overlapping)
+		glColor3f(0, 1, 0);
+	else
+		glColor3f(0, 0, 1);
+	glDrawArrays(GL_LINE_LOOP, 0, (GLsizei)pointCount);
+	glDisableClientState(GL_VERTEX_ARRAY);
+
+	glPopMatrix();
+}
+
+void CRenderer::DrawAABBs(const std::vector<CAABB>& bounds)
+{
+	// Outlines of all bounds as one line list, green when overlapping after broad phase
+	m_debugLineVertices.clear();
+	m_debugLineColors.clear();
+	for (const CAABB& aabb : bounds)
+	{
+		Vec2 min = aabb.GetMin();
+		Vec2 max = aabb.GetMax();
+		Vec2 corners[4] = { Vec2(min.x, min.y), Vec2(min.x, max.y), Vec2(max.x, max.y), Vec2(max.x, min.y) };
+		for (size_t i = 0; i < 4; ++i)
+		{
+			m_debugLineVertices.push_back(corners[i]);
+			m_debugLineVertices.push_back(corners[(i + 1) % 4]);
+		}
+		float green = aabb.isOverlaping ? 1.0f : 0.0f;
+		for (size_t i = 0; i < 8; ++i)
+		{
+			m_debugLineColors.push_back(0.0f);
+			m_debugLineColors.push_back(green);
+			m_debugLineColors.push_back(1.0f - green);
+		}
+	}
+
+	if (m_debugLineVertices.empty())
+		return;
+
+	glPushMatrix();
+	glTranslatef(0.0f, 0.0f, -1.0f);
+
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+	glVertexPointer(2, GL_FLOAT, sizeof(Vec2), m_debugLineVertices.data());
+	glColorPointer(3, GL_FLOAT, 0, m_debugLineColors.data());
+	glDrawArrays(GL_LINES, 0, (GLsizei)m_debugLineVertices.size());
+	glDisableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+
+	glPopMatrix();
+	glColor3f(0, 0, 0);
+}
+
+void CRenderer::DrawList(const SDrawList& drawList)
+{
+	for (const SDrawList::SCommand& command : drawList.commands)
+	{
+		const Vec2* vertices = &drawList.vertices[command.first];
+		if (command.isLine)
+		{
+			DrawLineNow(vertices[0], vertices[1], command.r, command.g, command.b);
+		}
+		else
+		{
+			DrawPointsNow(vertices, command.count, command.r, command.g, command.b);
+		}
+	}
+}
+
 Vec2 CRenderer::ScreenToWorldPos(const Vec2& pos) const
 {
 	float width = (float)gVars->pRenderWindow->GetWidth();
@@ -150,34 +288,99 @@ void CRenderer::Update()
 			gVars->bToggleGravity = !gVars->bToggleGravity;
 		}
 	}
+
+	if (gVars->pRenderWindow->JustPressedKey(Key::F5))
+	{
+		m_FPS = (FPS)(((int)m_FPS + 1) % (int)FPS::Count);
+	}
+
+	if (gVars->pRenderWindow->JustPressedKey(Key::F10))
+	{
+		m_frameLatency = 1 - m_frameLatency;
+	}
+
+	if (gVars->pRenderWindow->JustPressedKey(Key::F11))
+	{
+		if (m_isRecording)
+			StopRecording();
+		else
+			StartRecording();
+	}
+	
+	if (gVars->pRenderWindow->JustPressedKey(Key::F12))
+	{
+		bool saved = gVars->pSceneManager->SaveSnapshot(RENDER_SNAPSHOT_PATH);
+		ShowStatus(std::string(saved ? "World saved in " : "Failed to write ") + RENDER_SNAPSHOT_PATH);
+	}
 	
 	gVars->pSceneManager->CheckSceneUpdate();
+	if (m_isRecording)
+	{
+		if (gVars->pSceneManager->GetLoadCount() != m_recordingLoadCount)
+		{
+			StopRecording();
+		}
+		else
+		{
+			DisplayText("Recording inputs (F11: stop) : " + std::to_string(m_inputRecording.GetStepCount()) + " steps");
+		}
+	}
 
 	PreRenderFrame();
 
 	float frameTime = UpdateFrameTime();
 	DrawFPS(frameTime);
 
+	if (m_statusTime > 0.0f)
+	{
+		DisplayText(m_statusText);
+		m_statusTime -= frameTime;
+	}
 
-	gVars->pPhysicEngine->Step(frameTime);
-	
-	timer.Start();
-	UpdateWorld(frameTime);
-	timer.Stop();
-	if (gVars->bDebug)
+	if (m_frameLatency == 0)
 	{
-		DisplayText("Update duration : " + std::to_string(timer.GetDuration()));
+		SimulateFrame(frameTime, m_snapshots[m_simulationSnapshot]);
+	}
+
+	// Simulated frame is completed by the world state, then drawn while next one records in the other snapshot
+	CRenderSnapshot& snapshot = m_snapshots[m_simulationSnapshot];
+	CaptureSnapshot(snapshot);
+	m_simulationSnapshot = 1 - m_simulationSnapshot;
+
+	// With one frame latency, world is only touched by the simulation job until it is waited,
+	// the render thread reads the snapshot only
+	CJobSystem& jobSystem = gVars->pPhysicEngine->GetJobSystem();
+	CRenderSnapshot& nextSnapshot = m_snapshots[m_simulationSnapshot];
+	auto simulateNextFrame = [&]()
+	{
+		SimulateFrame(frameTime, nextSnapshot);
+	};
+	SJob* simulationJob = nullptr;
+	if (m_frameLatency == 1)
+	{
+		simulationJob = jobSystem.CreateJob(simulateNextFrame);
+		jobSystem.Run(simulationJob);
 	}
 
 	timer.Start();
-	RenderPolygons();
+	RenderSnapshot(snapshot);
 	timer.Stop();
+	float renderDuration = timer.GetDuration();
+
+	if (simulationJob)
+	{
+		jobSystem.Wait(simulationJob);
+	}
+
 	if (gVars->bDebug)
 	{
-		DisplayText("Render duration : " + std::to_string(timer.GetDuration()));
+		DisplayText("Update duration : " + std::to_string(m_simulationDuration));
+		DisplayText("Render duration : " + std::to_string(renderDuration));
+		DisplayText("Frame latency : " + std::to_string(m_frameLatency));
 	}
 
 	RenderTexts();
+	PROFILE_FRAME();
 
 	UpdateLockFPS();
 }
@@ -229,16 +432,114 @@ void  CRenderer::UpdateWorld(float frameTime)
 	}
 }
 
-void  CRenderer::RenderPolygons()
+void  CRenderer::StepSimulation(float frameTime)
+{
+	size_t stepCount = m_fixedTimeStep.Advance(frameTime);
+	float deltaTime = m_fixedTimeStep.GetDeltaTime();
+	SRenderTextList& textList = GetTextList();
+
+	for (size_t step = 0; step < stepCount; ++step)
+	{
+		bool lastStep = (step + 1 == stepCount);
+		size_t firstText = textList.texts.size();
+		size_t firstLine = textList.lines.size();
+		textList.mute = !lastStep;
+
+		if (m_isRecording)
+		{
+			m_inputRecording.RecordInput(SInputState::Capture());
+		}
+
+		if (gVars->pWorld)
+		{
+			gVars->pWorld->SaveTransforms();
+		}
+
+		gVars->pPhysicEngine->Step(deltaTime);
+		UpdateWorld(deltaTime);
+
+		if (m_isRecording)
+		{
+			m_inputRecording.RecordHash(ComputeSimulationHash());
+		}
+
+		// key presses are handled by the first step after them
+		gVars->pRenderWindow->ConsumeStepKeys();
+
+		if (lastStep)
+		{
+			m_stepTexts.texts.assign(textList.texts.begin() + firstText, textList.texts.end());
+			m_stepTexts.lines.assign(textList.lines.begin() + firstLine, textList.lines.end());
+		}
+	}
+	textList.mute = false;
+
+	if (stepCount == 0)
+	{
+		textList.Append(m_stepTexts);
+	}
+
+	if (gVars->bDebug)
+	{
+		DisplayText("Physics : " + std::to_string((int)m_fixedTimeStep.GetFrequency()) + " Hz, substeps : " + std::to_string(stepCount));
+	}
+}
+
+// Steps simulation for a frame, its draws and texts are recorded in snapshot
+void  CRenderer::SimulateFrame(float frameTime, CRenderSnapshot& snapshot)
+{
+	PROFILE_ZONE("Renderer::SimulateFrame");
+	CTimer timer;
+	timer.Start();
+
+	snapshot.simulationDraws.Clear();
+	snapshot.simulationTexts.Clear();
+	tRecordedDraws = &snapshot.simulationDraws;
+	tRecordedTexts = &snapshot.simulationTexts;
+
+	StepSimulation(frameTime);
+
+	tRecordedDraws = nullptr;
+	tRecordedTexts = nullptr;
+
+	timer.Stop();
+	m_simulationDuration = timer.GetDuration();
+}
+
+void  CRenderer::CaptureSnapshot(CRenderSnapshot& snapshot)
+{
+	PROFILE_ZONE("Renderer::CaptureSnapshot");
+	float alpha = m_fixedTimeStep.GetAlpha();
+	snapshot.Capture(gVars->pWorld, alpha, gVars->bDebugElem && gVars->bToggleAABB);
+
+	if (gVars->pWorld)
+	{
+		tRecordedDraws = &snapshot.worldDraws;
+		gVars->pWorld->RenderBehaviors(alpha);
+		tRecordedDraws = nullptr;
+	}
+}
+
+void  CRenderer::RenderSnapshot(const CRenderSnapshot& snapshot)
 {
+	PROFILE_ZONE("Renderer::RenderSnapshot");
+	m_renderTexts.Append(snapshot.simulationTexts);
+	DrawList(snapshot.simulationDraws);
+
 	glColor3f(0.0f, 0.0f, 0.0f);
 
 	glPushMatrix();
 
-	if (gVars->pWorld)
+	for (size_t i = 0; i < snapshot.GetPolygonCount(); ++i)
 	{
-		gVars->pWorld->RenderPolygons();
+		const std::vector<Vec2>& points = snapshot.shapes[i]->GetPoints();
+		DrawPolygon(snapshot.positions[i], snapshot.rotations[i], points.data(), points.size(), snapshot.overlapping[i] != 0);
 	}
+	if (!snapshot.bounds.empty())
+	{
+		DrawAABBs(snapshot.bounds);
+	}
+	DrawList(snapshot.worldDraws);
 
 	glPopMatrix();
 }
@@ -260,7 +561,7 @@ void  CRenderer::RenderTexts()
 	glMatrixMode(GL_MODELVIEW);
 	glLoadIdentity();
 
-	for (const SRenderText& text : m_renderTexts)
+	for (const SRenderText& text : m_renderTexts.texts)
 	{
 		glPushMatrix();
 
@@ -270,17 +571,22 @@ void  CRenderer::RenderTexts()
 		glPopMatrix();
 	}
 
-	m_renderTexts.clear();
-	m_textCursor = 0;
+	// lines stacked from the top left corner
+	for (size_t i = 0; i < m_renderTexts.lines.size(); ++i)
+	{
+		glPushMatrix();
+
+		glTranslatef(50.0f, (float)(height - 50 - 30 * (int)i), 0.0f);
+		dtx_string(m_renderTexts.lines[i].c_str());
+
+		glPopMatrix();
+	}
+
+	m_renderTexts.Clear();
 }
 
 void  CRenderer::UpdateLockFPS()
 {
-	if (gVars->pRenderWindow->JustPressedKey(Key::F5))
-	{
-		m_FPS = (FPS)(((int)m_FPS + 1) % (int)FPS::Count);
-	}
-
 	if (m_FPS != FPS::Unlocked)
 	{
 		float frameTimeLimit = (m_FPS == FPS::Locked30) ? 1.0f / 30.0f : 1.0f / 60.0f;
@@ -291,6 +597,36 @@ void  CRenderer::UpdateLockFPS()
 	}
 }
 
+void  CRenderer::StartRecording()
+{
+	// recording starts from a fresh scene, as replays do
+	gVars->pSceneManager->ReloadScene();
+	m_fixedTimeStep.Reset();
+
+	m_inputRecording.Begin((uint32_t)gVars->pSceneManager->GetCurrentScene(), m_fixedTimeStep.GetDeltaTime());
+	m_recordingLoadCount = gVars->pSceneManager->GetLoadCount();
+	m_isRecording = true;
+}
+
+void  CRenderer::StopRecording()
+{
+	m_isRecording = false;
+	if (m_inputRecording.Save(RENDER_RECORDING_PATH))
+	{
+		ShowStatus(std::to_string(m_inputRecording.GetStepCount()) + " steps of inputs recorded in " + RENDER_RECORDING_PATH);
+	}
+	else
+	{
+		ShowStatus(std::string("Failed to write ") + RENDER_RECORDING_PATH);
+	}
+}
+
+void  CRenderer::ShowStatus(const std::string& text)
+{
+	m_statusText = text;
+	m_statusTime = RENDER_STATUS_DURATION;
+}
+
 float  CRenderer::UpdateFrameTime()
 {
 	m_frameTimer.Stop();
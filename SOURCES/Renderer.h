@@ -5,7 +5,17 @@
 #include <string>
 
 #include "Timer.h"
+#include "FixedTimeStep.h"
+#include "FluidMesh.h"
+#include "IRenderer.h"
+#include "InputRecording.h"
 #include "Maths.h"
+#include "RenderSnapshot.h"
+
+#define RENDER_RECORDING_PATH "recording.rec" // replayed with CollisionHeadless -replay
+#define RENDER_SNAPSHOT_PATH "world.snap" // F12, loaded with CollisionHeadless -load
+#define RENDER_STATUS_DURATION 3.0f // seconds a key action result stays displayed
+#define RENDER_FRAME_LATENCY 1 // 0 : frame is drawn after being simulated, 1 : frame is drawn while next one is simulated (F10 toggles)
 
 
 enum class FPS : int
@@ -17,58 +27,94 @@ enum class FPS : int
 	Count,
 };
 
-struct SRenderText
-{
-	SRenderText(const std::string& _text, int _x, int _y) : text(_text), x(_x), y(_y){}
-
-	std::string	text;
-	int x, y; // screen space (0,0) left bottom corner
-};
-
-class CRenderer
+// OpenGL renderer, only this class, the render window and FluidMesh include GL headers
+class CRenderer : public IRenderer
 {
 public:
 	CRenderer(float worldHeight);
 	~CRenderer();
 
-	void	SetWorldHeight(float worldHeight);
-	float	GetWorldWidth() const;
-	float	GetWorldHeight() const;
+	virtual void	SetWorldHeight(float worldHeight) override;
+	virtual float	GetWorldWidth() const override;
+	virtual float	GetWorldHeight() const override;
 
-	void	DisplayText(const std::string& text);
-	void	DisplayText(const std::string& text, int x, int y);
-	void	DisplayTextWorld(const std::string& text, const Vec2& worldPos);
-	void	DrawLine(const Vec2& from, const Vec2& to, float r, float g, float b);
+	virtual bool	IsDisplayingTexts() const override;
+	virtual void	DisplayText(const std::string& text) override;
+	virtual void	DisplayText(const std::string& text, int x, int y) override;
+	virtual void	DisplayTextWorld(const std::string& text, const Vec2& worldPos) override;
+	virtual void	DrawLine(const Vec2& from, const Vec2& to, float r, float g, float b) override;
+	virtual void	DrawPoints(const Vec2* points, size_t count, float r, float g, float b) override;
 
-	Vec2	ScreenToWorldPos(const Vec2& pos) const;
-	Vec2	WorldToScreenPos(const Vec2& pos) const;
+	virtual Vec2	ScreenToWorldPos(const Vec2& pos) const override;
+	virtual Vec2	WorldToScreenPos(const Vec2& pos) const override;
 
-	void	Init();
-	void	Reset();
-	void	Reshape(int width, int height);
-	void	Update();
+	virtual void	Init() override;
+	virtual void	Reset() override;
+	virtual void	Reshape(int width, int height) override;
+	virtual void	Update() override;
 
 private:
+	void	DrawPolygon(const Vec2& position, const Mat2& rotation, const Vec2* points, size_t pointCount, bool overlapping);
+	void	DrawAABBs(const std::vector<CAABB>& bounds);
+	void	DrawList(const SDrawList& drawList);
+	void	DrawLineNow(const Vec2& from, const Vec2& to, float r, float g, float b);
+	void	DrawPointsNow(const Vec2* points, size_t count, float r, float g, float b);
 	void	SetProjectionMatrix();
 	void	PreRenderFrame();
 	void	DrawFPS(float frameTime);
 	void	UpdateWorld(float frameTime);
-	void	RenderPolygons();
+	void	StepSimulation(float frameTime);
+	void	SimulateFrame(float frameTime, CRenderSnapshot& snapshot);
+	void	CaptureSnapshot(CRenderSnapshot& snapshot);
+	void	RenderSnapshot(const CRenderSnapshot& snapshot);
 	void	RenderTexts();
 	void	UpdateLockFPS();
+	void	StartRecording();
+	void	StopRecording();
+	void	ShowStatus(const std::string& text);
 
 	float	UpdateFrameTime();
 
+	// Texts of the calling thread : the frame ones, or the recording ones while simulating
+	SRenderTextList&		GetTextList();
+	const SRenderTextList&	GetTextList() const;
+
 private:
 	float m_worldHeight; // height in world units
 
 	CTimer m_frameTimer;
 
-	std::vector<SRenderText>	m_renderTexts;
-	int							m_textCursor;
+	SRenderTextList				m_renderTexts;
+
+	// Physics runs at fixed frequency, texts of intermediate substeps are dropped
+	// and the ones of last substep are kept for frames without any
+	CFixedTimeStep				m_fixedTimeStep;
+	SRenderTextList				m_stepTexts;
+
+	// Frames are drawn from a snapshot of the world. Simulation of a frame records its debug draws and texts
+	// in m_snapshots[m_simulationSnapshot], the snapshot is completed by the world state once simulated, then drawn.
+	CRenderSnapshot				m_snapshots[2];
+	size_t						m_simulationSnapshot = 0;
+	int							m_frameLatency = RENDER_FRAME_LATENCY;
+	float						m_simulationDuration = 0.0f;
+
+	// F11 reloads the scene and records inputs of its steps until F11 or another scene load
+	CInputRecording				m_inputRecording;
+	bool						m_isRecording = false;
+	size_t						m_recordingLoadCount = 0;
+
+	// Result of the last key action (recording saved...), displayed for RENDER_STATUS_DURATION
+	std::string					m_statusText;
+	float						m_statusTime = 0.0f;
 
 	struct dtx_font* m_font;
 
+	CFluidMesh	m_pointMesh;
+
+	// debug AABB outlines, rebuilt each frame they are drawn
+	std::vector<Vec2>	m_debugLineVertices;
+	std::vector<float>	m_debugLineColors;
+
 	float	m_lastFPS;
 	float	m_lastFPSSince;
 	FPS		m_FPS;
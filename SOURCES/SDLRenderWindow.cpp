@@ -17,7 +17,13 @@ CSDLRenderWindow::CSDLRenderWindow(int width, int height)
 	m_sdlKeyMap[SDL_SCANCODE_F3] = Key::F3;
 	m_sdlKeyMap[SDL_SCANCODE_F4] = Key::F4;
 	m_sdlKeyMap[SDL_SCANCODE_F5] = Key::F5;
+	m_sdlKeyMap[SDL_SCANCODE_F6] = Key::F6;
+	m_sdlKeyMap[SDL_SCANCODE_F7] = Key::F7;
 	m_sdlKeyMap[SDL_SCANCODE_F8] = Key::F8;
+	m_sdlKeyMap[SDL_SCANCODE_F9] = Key::F9;
+	m_sdlKeyMap[SDL_SCANCODE_F10] = Key::F10;
+	m_sdlKeyMap[SDL_SCANCODE_F11] = Key::F11;
+	m_sdlKeyMap[SDL_SCANCODE_F12] = Key::F12;
 	m_sdlKeyMap[SDL_SCANCODE_KP_0] = Key::NumPad0;
 	m_sdlKeyMap[SDL_SCANCODE_KP_1] = Key::NumPad1;
 	m_sdlKeyMap[SDL_SCANCODE_KP_2] = Key::NumPad2;
@@ -51,6 +57,10 @@ void CSDLRenderWindow::Init()
 	context = SDL_GL_CreateContext(window);
 	SDL_GL_SetSwapInterval(0);
 
+	// loads buffer objects and extensions entry points (fluid particles stream through persistent mapped buffers when supported)
+	glewExperimental = GL_TRUE;
+	glewInit();
+
 	gVars->pRenderer->Init();
 
 	while (ProcessEvents())
@@ -105,6 +115,19 @@ bool CSDLRenderWindow::JustPressedKey(Key key)
 	return m_justPressedKeys[(size_t)key];
 }
 
+bool CSDLRenderWindow::JustPressedStepKey(Key key)
+{
+	return m_justPressedStepKeys[(size_t)key];
+}
+
+void CSDLRenderWindow::ConsumeStepKeys()
+{
+	for (size_t i = 0; i < (size_t)Key::Count; ++i)
+	{
+		m_justPressedStepKeys[i] = false;
+	}
+}
+
 bool CSDLRenderWindow::ProcessEvents()
 {
 	for (size_t i = 0; i < (size_t)Key::Count; ++i)
@@ -143,6 +166,7 @@ bool CSDLRenderWindow::ProcessEvents()
 				if (itSdlKey != m_sdlKeyMap.end())
 				{
 					m_justPressedKeys[(size_t)itSdlKey->second] = !m_pressedKeys[(size_t)itSdlKey->second];
+					m_justPressedStepKeys[(size_t)itSdlKey->second] |= m_justPressedKeys[(size_t)itSdlKey->second];
 					m_pressedKeys[(size_t)itSdlKey->second] = true;					
 				}
 			}
@@ -169,5 +193,6 @@ void CSDLRenderWindow::ResetKeys()
 	{
 		m_pressedKeys[i] = false;
 		m_justPressedKeys[i] = false;
+		m_justPressedStepKeys[i] = false;
 	}
 }
\ No newline at end of file
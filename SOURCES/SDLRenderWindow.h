@@ -17,6 +17,8 @@ public:
 	virtual bool	GetMouseButton(int button) override;
 	virtual bool	IsPressingKey(Key key) override;
 	virtual bool	JustPressedKey(Key key) override;
+	virtual bool	JustPressedStepKey(Key key) override;
+	virtual void	ConsumeStepKeys() override;
 
 private:
 	bool			ProcessEvents();
@@ -25,6 +27,7 @@ private:
 	std::unordered_map<unsigned int, Key>	m_sdlKeyMap;
 	bool									m_pressedKeys[(size_t)Key::Count];
 	bool									m_justPressedKeys[(size_t)Key::Count];
+	bool									m_justPressedStepKeys[(size_t)Key::Count];
 };
 
 #endif
\ No newline at end of file
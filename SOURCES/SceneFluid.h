@@ -1,24 +1,56 @@
 #ifndef _SCENE_FLUID_H_
 #define _SCENE_FLUID_H_
 
-#include "Scenes\BaseScene.h"
+#include "Scenes/BaseScene.h"
 
+#include "Behaviors/CollisionResponse.h"
+#include "Behaviors/FluidSystemUpdate.h"
 #include "FluidSpawner.h"
 
 class CSceneFluid : public CBaseScene
 {
 public:
-	CSceneFluid() : CBaseScene(1.0f, 10.0f){}
+	CSceneFluid(size_t debrisCount = 6) : CBaseScene(0.5f, 10.0f), m_debrisCount(debrisCount){}
 
 protected:
 
 
 	virtual void Create() override
 	{
-		CBaseScene::Create();
+		CreateBehaviors();
+		CreateBorderRectangles();
 
+		float halfWidth = gVars->pRenderer->GetWorldWidth() * 0.5f - m_borderSize;
+		float halfHeight = gVars->pRenderer->GetWorldHeight() * 0.5f - m_borderSize;
+
+		CFluidSystem& fluid = CFluidSystem::Get();
+		fluid.Spawn(Vec2(-halfWidth, -halfHeight), Vec2(-halfWidth * 0.2f, halfHeight * 0.6f), 15.0f, Vec2());
+
+		// debris falling in the fluid
+		for (size_t i = 0; i < m_debrisCount; ++i)
+		{
+			CPolygonPtr poly = (i % 2 == 0) ? gVars->pWorld->AddRectangle(0.8f, 0.4f) : gVars->pWorld->AddSymetricPolygon(0.3f, 5);
+			poly->SetPosition(Vec2(-halfWidth * 0.8f + i * 0.9f, halfHeight * 0.8f));
+		}
+	}
+
+	virtual void CreateBehaviors() override
+	{
+		Setup();
+
+		gVars->pWorld->AddBehavior<CCollisionResponse>(nullptr);
+		gVars->pWorld->AddBehavior<CFluidSystemUpdate>(nullptr);
 		gVars->pWorld->AddBehavior<CFluidSpawner>(nullptr);
+
+		float halfWidth = gVars->pRenderer->GetWorldWidth() * 0.5f - m_borderSize;
+		float halfHeight = gVars->pRenderer->GetWorldHeight() * 0.5f - m_borderSize;
+
+		CFluidSystem& fluid = CFluidSystem::Get();
+		fluid.Reset();
+		fluid.SetBounds(Vec2(-halfWidth, -halfHeight), Vec2(halfWidth, halfHeight));
 	}
+
+	size_t m_debrisCount;
 };
 
-#endif
\ No newline at end of file
+#endif
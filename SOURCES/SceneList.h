@@ -0,0 +1,30 @@
+#ifndef _SCENE_LIST_H_
+#define _SCENE_LIST_H_
+
+#include "SceneManager.h"
+
+#include "Scenes/SceneDebugCollisions.h"
+#include "Scenes/SceneBouncingPolys.h"
+#include "Scenes/SceneSimplePhysic.h"
+#include "Scenes/SceneSpheres.h"
+#include "Scenes/SceneComplexPhysic.h"
+#include "Scenes/SceneSmallPhysic.h"
+#include "Scenes/SceneStacking.h"
+#include "SceneFluid.h"
+
+// Scenes of the application, in F2/F3 order. Shared with the headless driver so scene indices match.
+inline void AddAllScenes(CSceneManager* sceneManager)
+{
+	sceneManager->AddScene(new CSceneDebugCollisions());
+	sceneManager->AddScene(new CSceneBouncingPolys(2, Vec2(5.0f, 10.0f)));
+	sceneManager->AddScene(new CSceneBouncingPolys(200));
+	sceneManager->AddScene(new CSceneSpheres());
+	sceneManager->AddScene(new CSceneSmallPhysic());
+	sceneManager->AddScene(new CSceneSimplePhysic());
+	sceneManager->AddScene(new CSceneComplexPhysic(25));
+	sceneManager->AddScene(new CSceneStacking(44));
+	sceneManager->AddScene(new CSceneFluid());
+	sceneManager->AddScene(new CSceneStacking(44, 1.0f, false));
+}
+
+#endif
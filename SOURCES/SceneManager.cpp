@@ -6,8 +6,11 @@
 #include "GlobalVariables.h"
 #include "PhysicEngine.h"
 #include "World.h"
+#include "WorldSnapshot.h"
 #include "RenderWindow.h"
-#include "Renderer.h"
+#include "IRenderer.h"
+
+#define SCENE_RANDOM_SEED 0x5EED
 
 void CSceneManager::Reset()
 {
@@ -34,6 +37,9 @@ void CSceneManager::LoadScene(size_t index)
 
 	Reset();
 
+	// scenes built with Random are the same on each load
+	SetRandomSeed(SCENE_RANDOM_SEED + (uint32_t)index);
+
 	gVars->pWorld = new CWorld();
 	m_scenes[index]->Create();
 
@@ -42,7 +48,11 @@ void CSceneManager::LoadScene(size_t index)
 		behavior->Start();
 	});
 
+	// nothing to interpolate from yet
+	gVars->pWorld->SaveTransforms();
+
 	m_currentScene = index;
+	++m_loadCount;
 }
 
 void CSceneManager::ReloadScene()
@@ -50,9 +60,43 @@ void CSceneManager::ReloadScene()
 	LoadScene(m_currentScene);
 }
 
+bool CSceneManager::SaveSnapshot(const std::string& path) const
+{
+	return CWorldSnapshot::Save(path, (uint32_t)m_currentScene);
+}
+
+bool CSceneManager::LoadSnapshot(const std::string& path)
+{
+	CWorldSnapshot snapshot;
+	if (!snapshot.Open(path) || snapshot.GetSceneIndex() >= m_scenes.size())
+	{
+		return false;
+	}
+
+	size_t index = snapshot.GetSceneIndex();
+	Reset();
+
+	SetRandomSeed(SCENE_RANDOM_SEED + (uint32_t)index);
+
+	gVars->pWorld = new CWorld();
+	m_scenes[index]->CreateBehaviors();
+
+	gVars->pWorld->ForEachBehavior([&](CBehaviorPtr& behavior)
+	{
+		behavior->Start();
+	});
+
+	// previous transforms are in the snapshot
+	snapshot.Restore(*gVars->pWorld);
+
+	m_currentScene = index;
+	++m_loadCount;
+	return true;
+}
+
 void CSceneManager::CheckSceneUpdate()
 {
-	gVars->pRenderer->DisplayText("F1: Reset scene, F2: prev scene, F3: next scene, cur scene: " + std::to_string(m_currentScene) + ", F4: debug, F5: lock FPS, F8: Draw debug elements");
+	gVars->pRenderer->DisplayText("F1: Reset scene, F2: prev scene, F3: next scene, cur scene: " + std::to_string(m_currentScene) + ", F4: debug, F5: lock FPS, F8: Draw debug elements, F10: frame latency, F11: record inputs, F12: save world");
 
 	if (gVars->pRenderWindow->JustPressedKey(Key::F2) && m_currentScene > 0)
 	{
@@ -1,12 +1,17 @@
 #ifndef _SCENE_MANAGER_H_
 #define _SCENE_MANAGER_H_
 
+#include <cstddef>
+#include <string>
 #include <vector>
 
 class IScene
 {
 public:
 	virtual void	Create() = 0;
+	// Settings and behaviors only, for scenes loaded from a world snapshot which holds the bodies.
+	// By default the whole scene is created and its polygons are then replaced by the snapshot ones.
+	virtual void	CreateBehaviors() { Create(); }
 };
 
 class CSceneManager
@@ -18,11 +23,21 @@ public:
 	void LoadScene(size_t index);
 	void ReloadScene();
 
+	// Current scene state, between two steps
+	bool SaveSnapshot(const std::string& path) const;
+	// Loads the snapshot scene with the snapshot state, false if the file is not a valid snapshot
+	bool LoadSnapshot(const std::string& path);
+
 	void CheckSceneUpdate();
 
+	size_t	GetCurrentScene() const	{ return m_currentScene; }
+	// Incremented by each LoadScene and LoadSnapshot
+	size_t	GetLoadCount() const	{ return m_loadCount; }
+
 private:
 	std::vector<IScene*>	m_scenes;
 	size_t					m_currentScene = 0;
+	size_t					m_loadCount = 0;
 };
 
 #endif
\ No newline at end of file
@@ -6,7 +6,7 @@
 #include "Behavior.h"
 #include "PhysicEngine.h"
 #include "GlobalVariables.h"
-#include "Renderer.h"
+#include "IRenderer.h"
 #include "World.h"
 
 #include "Behaviors/PolygonMoverTool.h"
@@ -19,35 +19,39 @@ protected:
 
 	virtual void Create() override
 	{
-		gVars->pRenderer->SetWorldHeight(m_worldHeight);
+		Setup();
 		CreateBorderRectangles();
+	}
 
-		
+	// World height and tools, scenes overriding CreateBehaviors call it instead of Create
+	void Setup()
+	{
+		gVars->pRenderer->SetWorldHeight(m_worldHeight);
 		gVars->pWorld->AddBehavior<CPolygonMoverTool>(nullptr);
 	}
 	
 	void CreateBorderRectangles()
 	{
-		CPolygonPtr poly;
+		CPolygonPtr poly = nullptr;
 
 		float halfWidth = gVars->pRenderer->GetWorldWidth() * 0.5f;
 		float halfHeight = gVars->pRenderer->GetWorldHeight() * 0.5f;
 
 		poly = gVars->pWorld->AddRectangle(halfWidth * 2.0f, m_borderSize);
 		poly->SetPosition(Vec2(0.0f, -halfHeight + 0.5f * m_borderSize));
-		poly->density = 0.0f;
+		poly->SetDensity(0.0f);
 
 		poly = gVars->pWorld->AddRectangle(halfWidth * 2.0f, m_borderSize);
 		poly->SetPosition(Vec2(0.0f, halfHeight - 0.5f * m_borderSize));
-		poly->density = 0.0f;
+		poly->SetDensity(0.0f);
 
 		poly = gVars->pWorld->AddRectangle(m_borderSize, halfHeight * 2.0f);
 		poly->SetPosition(Vec2(-halfWidth + 0.5f * m_borderSize, 0.0f));
-		poly->density = 0.0f;
+		poly->SetDensity(0.0f);
 
 		poly = gVars->pWorld->AddRectangle(m_borderSize, halfHeight * 2.0f);
 		poly->SetPosition(Vec2(halfWidth - 0.5f * m_borderSize, 0.0f));
-		poly->density = 0.0f;
+		poly->SetDensity(0.0f);
 	}
 
 	float m_borderSize;
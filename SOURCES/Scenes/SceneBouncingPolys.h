@@ -17,10 +17,8 @@ public:
 protected:
 	virtual void Create() override
 	{
-		CBaseScene::Create();
-
-		//gVars->pWorld->AddBehavior<CSimplePolygonBounce>(nullptr);
-		gVars->pWorld->AddBehavior<CCollisionResponse>(nullptr);
+		CreateBehaviors();
+		CreateBorderRectangles();
 
 		float width = gVars->pRenderer->GetWorldWidth();
 		float height = gVars->pRenderer->GetWorldHeight();
@@ -41,6 +39,14 @@ protected:
 		}
 	}
 
+	virtual void CreateBehaviors() override
+	{
+		Setup();
+
+		//gVars->pWorld->AddBehavior<CSimplePolygonBounce>(nullptr);
+		gVars->pWorld->AddBehavior<CCollisionResponse>(nullptr);
+	}
+
 private:
 	size_t m_polyCount;
 };
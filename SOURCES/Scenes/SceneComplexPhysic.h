@@ -12,9 +12,8 @@ public:
 private:
 	virtual void Create() override
 	{
-		CBaseScene::Create();
-
-		gVars->pWorld->AddBehavior<CCollisionResponse>(nullptr);
+		CreateBehaviors();
+		CreateBorderRectangles();
 
 		float width = gVars->pRenderer->GetWorldWidth();
 		float height = gVars->pRenderer->GetWorldHeight();
@@ -35,6 +34,12 @@ private:
 		}
 	}
 
+	virtual void CreateBehaviors() override
+	{
+		Setup();
+		gVars->pWorld->AddBehavior<CCollisionResponse>(nullptr);
+	}
+
 private:
 	size_t m_polyCount;
 	float m_scale;
@@ -20,7 +20,7 @@ private:
 
 		CPolygonPtr block = gVars->pWorld->AddRectangle(coeff * 13.0f, coeff * 15.0f);
 		block->SetPosition(Vec2(0.0f, -coeff * 7.0f));
-		block->density = 0.0f;
+		block->SetDensity(0.0f);
 
 		CPolygonPtr rectangle = gVars->pWorld->AddRectangle(coeff * 30.0f, coeff * 10.0f);
 		rectangle->SetPosition(Vec2(coeff * 15.0f, coeff * 5.0f));
@@ -29,12 +29,12 @@ private:
 		{
 
 			CPolygonPtr sqr = gVars->pWorld->AddSquare(coeff * 10.0f);
-			sqr->density = 0.5f;
+			sqr->SetDensity(0.5f);
 			sqr->SetPosition(Vec2(coeff * 15.0f, coeff * 15.0f));
 		}
 		CPolygonPtr tri = gVars->pWorld->AddTriangle(coeff * 5.0f, coeff * 5.0f);
 		tri->SetPosition(Vec2(coeff * 5.0f, coeff * 15.0f));
-		tri->density *= 5.0f;
+		tri->SetDensity(tri->GetDensity() * 5.0f);
 		//
 		gVars->pWorld->AddSymetricPolygon(coeff * 10.0f, 50)->SetPosition(Vec2(-coeff * 20.0f, coeff * 5.0f));
 	}
@@ -33,9 +33,8 @@ private:
 		circle->SetPosition(Vec2(5.0f * m_scale, -2.5f * m_scale));
 		
 		
-		circle->speed.x = -40.0f * m_scale;
-		circle->speed.y = 0.0f * m_scale;
-		circle->density = 0.1f;
+		circle->SetSpeed(Vec2(-40.0f * m_scale, 0.0f * m_scale));
+		circle->SetDensity(0.1f);
 	}
 
 	float m_scale;
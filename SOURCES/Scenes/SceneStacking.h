@@ -0,0 +1,54 @@
+#ifndef _SCENE_STACKING_H_
+#define _SCENE_STACKING_H_
+
+#include "BaseScene.h"
+
+#include "Behaviors/CollisionResponse.h"
+#include "Behaviors/SoftStepCollisionResponse.h"
+
+// Box pyramid solved with soft step substepping (or the iterative collision response), baseCount 44 makes ~1000 bodies
+class CSceneStacking : public CBaseScene
+{
+public:
+	CSceneStacking(size_t baseCount, float size = 1.0f, bool softStep = true)
+		: CBaseScene(0.5f * size, (float)baseCount * size * 1.4f), m_baseCount(baseCount), m_size(size), m_softStep(softStep){}
+
+private:
+	virtual void Create() override
+	{
+		CreateBehaviors();
+		CreateBorderRectangles();
+
+		// small gaps, exactly touching boxes give degenerated GJK results
+		float bottom = -gVars->pRenderer->GetWorldHeight() * 0.5f + m_borderSize + m_size * 0.51f;
+		float spacing = m_size * 1.05f;
+		float rowHeight = m_size * 1.02f;
+
+		for (size_t row = 0; row < m_baseCount; ++row)
+		{
+			size_t rowCount = m_baseCount - row;
+			float left = -0.5f * (float)(rowCount - 1) * spacing;
+
+			for (size_t i = 0; i < rowCount; ++i)
+			{
+				CPolygonPtr box = gVars->pWorld->AddSquare(m_size);
+				box->SetPosition(Vec2(left + (float)i * spacing, bottom + (float)row * rowHeight));
+			}
+		}
+	}
+
+	virtual void CreateBehaviors() override
+	{
+		Setup();
+		if (m_softStep)
+			gVars->pWorld->AddBehavior<CSoftStepCollisionResponse>(nullptr);
+		else
+			gVars->pWorld->AddBehavior<CCollisionResponse>(nullptr);
+	}
+
+	size_t	m_baseCount;
+	float	m_size;
+	bool	m_softStep;
+};
+
+#endif
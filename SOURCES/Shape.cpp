@@ -0,0 +1,168 @@
+#include "Shape.h"
+
+#include "InertiaTensor.h"
+
+CShapePtr CShape::Create(const std::vector<Vec2>& points)
+{
+	std::shared_ptr<CShape> shape(new CShape());
+	shape->m_points = points;
+	std::vector<Vec2>& shapePoints = shape->m_points;
+	size_t count = shapePoints.size();
+
+	float signedArea = 0.0f;
+	for (size_t index = 0; index < count; ++index)
+	{
+		const Vec2& pointA = shapePoints[index];
+		const Vec2& pointB = shapePoints[(index + 1) % count];
+		signedArea += pointA.x * pointB.y - pointB.x * pointA.y;
+	}
+	signedArea *= 0.5f;
+	shape->m_signedArea = signedArea;
+
+	Vec2 centroid;
+	for (size_t index = 0; index < count; ++index)
+	{
+		const Vec2& pointA = shapePoints[index];
+		const Vec2& pointB = shapePoints[(index + 1) % count];
+		float factor = pointA.x * pointB.y - pointB.x * pointA.y;
+		centroid.x += (pointA.x + pointB.x) * factor;
+		centroid.y += (pointA.y + pointB.y) * factor;
+	}
+	centroid /= 6.0f * signedArea;
+	shape->m_centroid = centroid;
+
+	for (Vec2& point : shapePoints)
+	{
+		point -= centroid;
+		shape->m_boundingRadius = Max(shape->m_boundingRadius, point.GetLength());
+	}
+
+	for (size_t i = 0; i + 1 < count; ++i)
+	{
+		shape->m_localInertiaTensor += ComputeInertiaTensor_Triangle(Vec2(), shapePoints[i], shapePoints[i + 1]);
+	}
+
+	shape->m_lines.reserve(count);
+	for (size_t index = 0; index < count; ++index)
+	{
+		const Vec2 pointA = shapePoints[index];
+		const Vec2 pointB = shapePoints[(index + 1) % count];
+
+		Vec2 lineDir = (pointA - pointB).Normalized();
+
+		shape->m_lines.push_back(Line(pointB, lineDir, (pointA - pointB).GetLength()));
+	}
+
+	return shape;
+}
+
+Vec2 CShape::ClimbSupport(const Vec2& dir, const Mat2& rotation, const Vec2& position) const
+{
+	size_t count = m_points.size();
+	auto Project = [&](size_t index)
+	{
+		Vec2 vertex = rotation * m_points[index] + position;
+		return vertex | dir;
+	};
+
+	size_t index = 0;
+	float projection = Project(0);
+	if (projection != projection)
+		return Vec2(); // invalid transform, no projection is greater than -FLT_MAX in the linear search
+
+	size_t step = (Project(1) > projection) ? 1 : count - 1;
+	for (size_t i = 1; i < count; ++i)
+	{
+		size_t next = (index + step) % count;
+		float nextProjection = Project(next);
+		if (!(nextProjection > projection))
+			break;
+		index = next;
+		projection = nextProjection;
+	}
+
+	// an edge orthogonal to dir has equal projections, the linear search keeps the lowest index
+	size_t support = index;
+	for (size_t next = (index + 1) % count; next != index && Project(next) == projection; next = (next + 1) % count)
+	{
+		support = Min(support, next);
+	}
+	for (size_t previous = (index + count - 1) % count; previous != index && Project(previous) == projection; previous = (previous + count - 1) % count)
+	{
+		support = Min(support, previous);
+	}
+	return rotation * m_points[support] + position;
+}
+
+CShapePtr CShapeCache::GetTriangle(float base, float height)
+{
+	SShapeKey key = { EShapeType::Triangle, base, height, 0 };
+	CShapePtr shape = Find(key);
+	if (shape == nullptr)
+	{
+		shape = CShape::Create({ { -base * 0.5f, -height * 0.5f }, { base * 0.5f, -height * 0.5f }, { 0.0f, height * 0.5f } });
+		Add(key, shape);
+	}
+	return shape;
+}
+
+CShapePtr CShapeCache::GetRectangle(float width, float height)
+{
+	SShapeKey key = { EShapeType::Rectangle, width, height, 0 };
+	CShapePtr shape = Find(key);
+	if (shape == nullptr)
+	{
+		shape = CShape::Create({ { -width * 0.5f, -height * 0.5f }, { width * 0.5f, -height * 0.5f },
+			{ width * 0.5f, height * 0.5f }, { -width * 0.5f, height * 0.5f } });
+		Add(key, shape);
+	}
+	return shape;
+}
+
+CShapePtr CShapeCache::GetSymetricPolygon(float radius, size_t sides)
+{
+	SShapeKey key = { EShapeType::SymetricPolygon, radius, 0.0f, (uint32_t)sides };
+	CShapePtr shape = Find(key);
+	if (shape == nullptr)
+	{
+		std::vector<Vec2> points;
+		float dAngle = 360.0f / (float)sides;
+		for (size_t i = 0; i < sides; ++i)
+		{
+			float angle = i * dAngle;
+			points.push_back(Vec2(cosf(DEG2RAD(angle)), sinf(DEG2RAD(angle))) * radius);
+		}
+		shape = CShape::Create(points);
+		Add(key, shape);
+	}
+	return shape;
+}
+
+CShapePtr CShapeCache::Find(const SShapeKey& key) const
+{
+	SShapeKey normalizedKey = key;
+	if (!Normalize(normalizedKey))
+		return nullptr;
+
+	auto it = m_shapes.find(normalizedKey);
+	return (it != m_shapes.end()) ? it->second : nullptr;
+}
+
+void CShapeCache::Add(const SShapeKey& key, const CShapePtr& shape)
+{
+	SShapeKey normalizedKey = key;
+	if (Normalize(normalizedKey))
+	{
+		m_shapes[normalizedKey] = shape;
+	}
+}
+
+bool CShapeCache::Normalize(SShapeKey& key)
+{
+	if (key.a != key.a || key.b != key.b)
+		return false;
+
+	key.a = (key.a == 0.0f) ? 0.0f : key.a;
+	key.b = (key.b == 0.0f) ? 0.0f : key.b;
+	return true;
+}
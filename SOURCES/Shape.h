@@ -0,0 +1,137 @@
+#ifndef _SHAPE_H_
+#define _SHAPE_H_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "Maths.h"
+
+// From this point count, support points are found by climbing from a point to its neighbours instead of testing every point
+#define SHAPE_HILL_CLIMBING_MIN_POINTS 16
+
+class CShape;
+typedef std::shared_ptr<const CShape>	CShapePtr;
+
+// Immutable convex polygon geometry, shared by every body built with the same parameters.
+// Points are centered on the center of mass, mass data is for a unit density.
+class CShape
+{
+private:
+	friend class CWorldSnapshot;
+
+	CShape() = default;
+	CShape(const CShape&) = delete;
+	CShape& operator=(const CShape&) = delete;
+public:
+	// Points in any winding, they are moved by -GetCentroid() to be centered on the center of mass
+	static CShapePtr	Create(const std::vector<Vec2>& points);
+
+	const std::vector<Vec2>&	GetPoints() const	{ return m_points; }
+	// Line i goes from point i + 1 to point i
+	const std::vector<Line>&	GetLines() const	{ return m_lines; }
+
+	// Center of mass in space of the points given to Create
+	const Vec2&	GetCentroid() const				{ return m_centroid; }
+	float		GetSignedArea() const			{ return m_signedArea; }
+	float		GetArea() const					{ return fabsf(m_signedArea); }
+	// Multiplied by body mass
+	float		GetLocalInertiaTensor() const	{ return m_localInertiaTensor; }
+	// Max distance from center of mass to a point
+	float		GetBoundingRadius() const		{ return m_boundingRadius; }
+
+	// Transformed point of max projection on dir, first one of equal projections
+	inline Vec2	Support(const Vec2& dir, const Mat2& rotation, const Vec2& position) const
+	{
+		if (m_points.size() >= SHAPE_HILL_CLIMBING_MIN_POINTS)
+			return ClimbSupport(dir, rotation, position);
+
+		Vec2 support;
+		float maxProjection = -FLT_MAX;
+		for (Vec2 vertex : m_points)
+		{
+			vertex = rotation * vertex + position;
+			float projection = vertex | dir;
+			if (projection > maxProjection)
+			{
+				maxProjection = projection;
+				support = vertex;
+			}
+		}
+		return support;
+	}
+
+private:
+	// Same result as the linear search : projections of a convex polygon points only increase then decrease along its boundary
+	Vec2		ClimbSupport(const Vec2& dir, const Mat2& rotation, const Vec2& position) const;
+
+	std::vector<Vec2>	m_points;
+	std::vector<Line>	m_lines;
+	Vec2				m_centroid;
+	float				m_signedArea = 0.0f;
+	float				m_localInertiaTensor = 0.0f;
+	float				m_boundingRadius = 0.0f;
+};
+
+enum class EShapeType : uint32_t
+{
+	Custom = 0,	// not cached
+	Triangle,
+	Rectangle,
+	SymetricPolygon,
+};
+
+// Construction parameters of a cached shape
+struct SShapeKey
+{
+	EShapeType	type;
+	float		a;		// triangle base, rectangle width, polygon radius
+	float		b;		// triangle or rectangle height
+	uint32_t	sides;	// polygon
+
+	// Strict weak order once normalized by CShapeCache (no NaN)
+	bool	operator<(const SShapeKey& other) const
+	{
+		if (type != other.type)
+			return type < other.type;
+		if (a != other.a)
+			return a < other.a;
+		if (b != other.b)
+			return b < other.b;
+		return sides < other.sides;
+	}
+};
+
+// Shapes of a world by construction parameters, bodies built with the same ones share a single shape.
+// -0.0 parameters share the shape of 0.0 ones, shapes with NaN parameters are not cached as NaN has no order.
+class CShapeCache
+{
+public:
+	CShapePtr	GetTriangle(float base, float height);
+	CShapePtr	GetRectangle(float width, float height);
+	CShapePtr	GetSymetricPolygon(float radius, size_t sides);
+
+	// nullptr if not cached
+	CShapePtr	Find(const SShapeKey& key) const;
+	// Replaces the shape already cached with key, ignored for NaN keys
+	void		Add(const SShapeKey& key, const CShapePtr& shape);
+	size_t		GetCount() const	{ return m_shapes.size(); }
+
+	template<typename TFunctor>
+	void	ForEachShape(TFunctor functor) const
+	{
+		for (const auto& entry : m_shapes)
+		{
+			functor(entry.first, entry.second);
+		}
+	}
+
+private:
+	// false for NaN keys
+	static bool	Normalize(SShapeKey& key);
+
+	std::map<SShapeKey, CShapePtr>	m_shapes;
+};
+
+#endif
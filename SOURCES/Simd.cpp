@@ -0,0 +1,35 @@
+#include "Simd.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+static bool DetectAVX2()
+{
+#if !defined(SIMD_AVX2)
+	return false;
+#elif defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7)
+		return false;
+
+	// OS must save AVX registers (OSXSAVE + AVX, then XCR0 SSE and AVX states)
+	__cpuid(info, 1);
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+	if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+		return false;
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+bool	IsAVX2Supported()
+{
+	static const bool supported = DetectAVX2();
+	return supported;
+}
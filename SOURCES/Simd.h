@@ -0,0 +1,105 @@
+#ifndef _SIMD_H_
+#define _SIMD_H_
+
+#include <xmmintrin.h>
+#include <emmintrin.h>
+
+// The core is built for the baseline instruction set (SSE2), 8 lanes paths are only selected at runtime if the CPU supports AVX2.
+// MSVC exposes AVX intrinsics to any function. GCC and Clang only to functions targeting AVX2 : SFloat8 is usable
+// in SIMD_AVX2_ENTRY functions, which inline the whole kernel they call so no other code is compiled with AVX2 instructions.
+// Kernels templated on the float type are SIMD_KERNEL_INLINE : flatten does nothing without optimizations, and an
+// out of line SFloat8 kernel would pass its vectors to the AVX2 members with a different calling convention.
+#if defined(_MSC_VER)
+#define SIMD_AVX2
+#define SIMD_AVX2_INLINE inline
+#define SIMD_AVX2_ENTRY
+#define SIMD_KERNEL_INLINE __forceinline
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_AVX2
+#define SIMD_AVX2_INLINE inline __attribute__((target("avx2")))
+#define SIMD_AVX2_ENTRY __attribute__((target("avx2"), flatten))
+#define SIMD_KERNEL_INLINE inline __attribute__((always_inline))
+#else
+#define SIMD_KERNEL_INLINE inline
+#endif
+
+#ifdef SIMD_AVX2
+#include <immintrin.h>
+#endif
+
+bool	IsAVX2Supported();
+
+// 4 lanes float, SSE2
+struct SFloat4
+{
+	static const size_t Width = 4;
+
+	__m128 v;
+
+	SFloat4() = default;
+	SFloat4(__m128 _v) : v(_v) {}
+	explicit SFloat4(float f) : v(_mm_set1_ps(f)) {}
+
+	static inline SFloat4	Load(const float* ptr)	{ return _mm_loadu_ps(ptr); }
+	inline void				Store(float* ptr) const	{ _mm_storeu_ps(ptr, v); }
+
+	inline SFloat4 operator+(const SFloat4& rhs) const { return _mm_add_ps(v, rhs.v); }
+	inline SFloat4 operator-(const SFloat4& rhs) const { return _mm_sub_ps(v, rhs.v); }
+	inline SFloat4 operator*(const SFloat4& rhs) const { return _mm_mul_ps(v, rhs.v); }
+	inline SFloat4 operator/(const SFloat4& rhs) const { return _mm_div_ps(v, rhs.v); }
+	inline SFloat4 operator-() const { return _mm_sub_ps(_mm_setzero_ps(), v); }
+
+	inline SFloat4& operator+=(const SFloat4& rhs) { v = _mm_add_ps(v, rhs.v); return *this; }
+
+	// comparisons return lane masks (all bits set when true)
+	inline SFloat4 operator!=(const SFloat4& rhs) const { return _mm_cmpneq_ps(v, rhs.v); }
+	inline SFloat4 operator>(const SFloat4& rhs) const { return _mm_cmpgt_ps(v, rhs.v); }
+
+	static inline SFloat4	Zero() { return _mm_setzero_ps(); }
+	static inline SFloat4	Min(const SFloat4& a, const SFloat4& b) { return _mm_min_ps(a.v, b.v); }
+	static inline SFloat4	Max(const SFloat4& a, const SFloat4& b) { return _mm_max_ps(a.v, b.v); }
+	static inline SFloat4	Abs(const SFloat4& a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v); }
+	static inline SFloat4	Sqrt(const SFloat4& a) { return _mm_sqrt_ps(a.v); }
+	// mask ? a : 0
+	static inline SFloat4	And(const SFloat4& mask, const SFloat4& a) { return _mm_and_ps(mask.v, a.v); }
+	// mask ? a : b
+	static inline SFloat4	Select(const SFloat4& mask, const SFloat4& a, const SFloat4& b) { return _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)); }
+};
+
+#ifdef SIMD_AVX2
+// 8 lanes float, AVX2 : only in SIMD_AVX2_ENTRY functions
+struct SFloat8
+{
+	static const size_t Width = 8;
+
+	__m256 v;
+
+	SFloat8() = default;
+	SIMD_AVX2_INLINE SFloat8(__m256 _v) : v(_v) {}
+	SIMD_AVX2_INLINE explicit SFloat8(float f) : v(_mm256_set1_ps(f)) {}
+
+	static SIMD_AVX2_INLINE SFloat8	Load(const float* ptr)	{ return _mm256_loadu_ps(ptr); }
+	SIMD_AVX2_INLINE void	Store(float* ptr) const	{ _mm256_storeu_ps(ptr, v); }
+
+	SIMD_AVX2_INLINE SFloat8 operator+(const SFloat8& rhs) const { return _mm256_add_ps(v, rhs.v); }
+	SIMD_AVX2_INLINE SFloat8 operator-(const SFloat8& rhs) const { return _mm256_sub_ps(v, rhs.v); }
+	SIMD_AVX2_INLINE SFloat8 operator*(const SFloat8& rhs) const { return _mm256_mul_ps(v, rhs.v); }
+	SIMD_AVX2_INLINE SFloat8 operator/(const SFloat8& rhs) const { return _mm256_div_ps(v, rhs.v); }
+	SIMD_AVX2_INLINE SFloat8 operator-() const { return _mm256_sub_ps(_mm256_setzero_ps(), v); }
+
+	SIMD_AVX2_INLINE SFloat8& operator+=(const SFloat8& rhs) { v = _mm256_add_ps(v, rhs.v); return *this; }
+
+	SIMD_AVX2_INLINE SFloat8 operator!=(const SFloat8& rhs) const { return _mm256_cmp_ps(v, rhs.v, _CMP_NEQ_UQ); }
+	SIMD_AVX2_INLINE SFloat8 operator>(const SFloat8& rhs) const { return _mm256_cmp_ps(v, rhs.v, _CMP_GT_OQ); }
+
+	static SIMD_AVX2_INLINE SFloat8	Zero() { return _mm256_setzero_ps(); }
+	static SIMD_AVX2_INLINE SFloat8	Min(const SFloat8& a, const SFloat8& b) { return _mm256_min_ps(a.v, b.v); }
+	static SIMD_AVX2_INLINE SFloat8	Max(const SFloat8& a, const SFloat8& b) { return _mm256_max_ps(a.v, b.v); }
+	static SIMD_AVX2_INLINE SFloat8	Abs(const SFloat8& a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v); }
+	static SIMD_AVX2_INLINE SFloat8	Sqrt(const SFloat8& a) { return _mm256_sqrt_ps(a.v); }
+	static SIMD_AVX2_INLINE SFloat8	And(const SFloat8& mask, const SFloat8& a) { return _mm256_and_ps(mask.v, a.v); }
+	static SIMD_AVX2_INLINE SFloat8	Select(const SFloat8& mask, const SFloat8& a, const SFloat8& b) { return _mm256_blendv_ps(b.v, a.v, mask.v); }
+};
+#endif
+
+#endif
@@ -2,16 +2,15 @@
 
 void CTimer::Start()
 {
-	QueryPerformanceFrequency(&m_frequency);
-	QueryPerformanceCounter(&m_startTime);
+	m_startTime = Clock::now();
 }
 
 void CTimer::Stop()
 {
-	QueryPerformanceCounter(&m_stopTime);
+	m_stopTime = Clock::now();
 }
 
 float	CTimer::GetDuration() const
 {
-	return (float)(m_stopTime.QuadPart - m_startTime.QuadPart) / (float)m_frequency.QuadPart;
+	return std::chrono::duration<float>(m_stopTime - m_startTime).count();
 }
\ No newline at end of file
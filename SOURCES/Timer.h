@@ -1,7 +1,7 @@
 #ifndef _TIMER_H_
 #define _TIMER_H_
 
-#include <Windows.h>
+#include <chrono>
 
 class CTimer
 {
@@ -12,9 +12,10 @@ public:
 	float	GetDuration() const;
 
 private:
-	LARGE_INTEGER	m_frequency;
-	LARGE_INTEGER	m_startTime;
-	LARGE_INTEGER	m_stopTime;
+	typedef std::chrono::steady_clock	Clock;
+
+	Clock::time_point	m_startTime;
+	Clock::time_point	m_stopTime;
 };
 
-#endif
\ No newline at end of file
+#endif
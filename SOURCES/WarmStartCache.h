@@ -0,0 +1,177 @@
+#ifndef _WARM_START_CACHE_H_
+#define _WARM_START_CACHE_H_
+
+#include <vector>
+#include <cstdint>
+
+#include "Maths.h"
+
+// Accumulated contact impulses of last frame, keyed by body pair and manifold feature id.
+// Two open addressing tables are swapped each frame : one is read (last frame), the other written (this frame).
+// Slots are valid only if stamped with their table frame, so old entries are evicted without clearing anything.
+// Memory is only allocated when contact count grows.
+class CWarmStartCache
+{
+public:
+	// feature id of contacts without manifold
+	static const size_t NoFeature = 0xFFFF;
+	// feature id bit set when the reference edge belongs to body B
+	static const size_t FlipFeature = 0x8000;
+
+	// Full body handles are hashed, sorted so the key does not depend on the pair order.
+	// Swapping the bodies swaps the reference side of the manifold feature too.
+	static inline uint64_t	MakeKey(uint32_t bodyA, uint32_t bodyB, size_t featureId)
+	{
+		if (bodyA > bodyB)
+		{
+			std::swap(bodyA, bodyB);
+			if (featureId != NoFeature)
+				featureId ^= FlipFeature;
+		}
+
+		uint64_t pair = ((uint64_t)bodyA << 32) | bodyB;
+		return Mix(pair ^ Mix((uint64_t)featureId + 1));
+	}
+
+	// Call once per frame before any Store, contactCount is an estimation of contacts to store this frame
+	inline void	NewFrame(size_t contactCount)
+	{
+		std::swap(m_previous, m_current);
+		++m_frame;
+
+		// load factor under 0.5
+		size_t capacity = 16;
+		while (capacity < contactCount * 2)
+		{
+			capacity *= 2;
+		}
+
+		if (m_current.slots.size() < capacity)
+		{
+			m_current.slots.assign(capacity, SSlot());
+		}
+		m_current.frame = m_frame;
+		m_current.count = 0;
+	}
+
+	// Thread safe with other Find calls
+	inline bool	Find(uint64_t key, float& outNormalImpulse, float& outTangentImpulse) const
+	{
+		const STable& table = m_previous;
+		if (table.slots.empty() || table.frame + 1 != m_frame)
+			return false;
+
+		size_t mask = table.slots.size() - 1;
+		for (size_t index = Hash(key) & mask; table.slots[index].frame == table.frame; index = (index + 1) & mask)
+		{
+			if (table.slots[index].key == key)
+			{
+				outNormalImpulse = table.slots[index].normalImpulse;
+				outTangentImpulse = table.slots[index].tangentImpulse;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	inline void	Store(uint64_t key, float normalImpulse, float tangentImpulse)
+	{
+		STable& table = m_current;
+		if ((table.count + 1) * 2 > table.slots.size())
+		{
+			Grow();
+		}
+
+		size_t mask = table.slots.size() - 1;
+		size_t index = Hash(key) & mask;
+		while (table.slots[index].frame == table.frame && table.slots[index].key != key)
+		{
+			index = (index + 1) & mask;
+		}
+
+		SSlot& slot = table.slots[index];
+		if (slot.frame != table.frame)
+		{
+			slot.frame = table.frame;
+			slot.key = key;
+			++table.count;
+		}
+		slot.normalImpulse = normalImpulse;
+		slot.tangentImpulse = tangentImpulse;
+	}
+
+	// Entries stored this frame, functor(key, normalImpulse, tangentImpulse)
+	template<typename TFunctor>
+	inline void	ForEachEntry(TFunctor functor) const
+	{
+		for (const SSlot& slot : m_current.slots)
+		{
+			if (slot.frame == m_current.frame)
+			{
+				functor(slot.key, slot.normalImpulse, slot.tangentImpulse);
+			}
+		}
+	}
+
+	inline void	Clear()
+	{
+		// invalidates every slot of both tables
+		m_frame += 2;
+		m_current.frame = m_frame;
+		m_current.count = 0;
+	}
+
+private:
+	struct SSlot
+	{
+		uint64_t	key = 0;
+		uint32_t	frame = 0;
+		float		normalImpulse = 0.0f;
+		float		tangentImpulse = 0.0f;
+	};
+
+	struct STable
+	{
+		std::vector<SSlot>	slots;
+		uint32_t			frame = 0;
+		size_t				count = 0;
+	};
+
+	static inline uint64_t	Mix(uint64_t key)
+	{
+		// 64 bits finalizer from MurmurHash3
+		key ^= key >> 33;
+		key *= 0xff51afd7ed558ccdULL;
+		key ^= key >> 33;
+		key *= 0xc4ceb9fe1a85ec53ULL;
+		key ^= key >> 33;
+		return key;
+	}
+
+	static inline size_t	Hash(uint64_t key)
+	{
+		return (size_t)Mix(key);
+	}
+
+	inline void	Grow()
+	{
+		std::vector<SSlot> oldSlots;
+		oldSlots.swap(m_current.slots);
+		m_current.slots.assign(Max(oldSlots.size() * 2, (size_t)16), SSlot());
+		m_current.count = 0;
+
+		for (const SSlot& slot : oldSlots)
+		{
+			if (slot.frame == m_current.frame)
+			{
+				Store(slot.key, slot.normalImpulse, slot.tangentImpulse);
+			}
+		}
+	}
+
+	STable		m_previous;
+	STable		m_current;
+	uint32_t	m_frame = 1;
+};
+
+#endif
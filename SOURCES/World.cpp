@@ -1,28 +1,24 @@
 #include "World.h"
 
 #include "Polygon.h"
+#include "Profiler.h"
 
-CPolygonPtr		CWorld::AddTriangle(float base, float height)
+CWorld::~CWorld()
 {
-	CPolygonPtr poly = AddPolygon();
-	poly->points.push_back({ -base * 0.5f, -height * 0.5f });
-	poly->points.push_back({ base * 0.5f, -height * 0.5f });
-	poly->points.push_back({ 0.0f, height * 0.5f });
-	poly->Build();
+	for (CPolygonPtr poly : m_polygons)
+	{
+		delete poly;
+	}
+}
 
-	return poly;
+CPolygonPtr		CWorld::AddTriangle(float base, float height)
+{
+	return AddPolygon(m_shapeCache.GetTriangle(base, height));
 }
 
 CPolygonPtr		CWorld::AddRectangle(float width, float height)
 {
-	CPolygonPtr poly = AddPolygon();
-	poly->points.push_back({ -width * 0.5f, -height * 0.5f });
-	poly->points.push_back({ width * 0.5f, -height * 0.5f });
-	poly->points.push_back({ width * 0.5f, height * 0.5f });
-	poly->points.push_back({ -width * 0.5f, height * 0.5f });
-	poly->Build();
-
-	return poly;
+	return AddPolygon(m_shapeCache.GetRectangle(width, height));
 }
 
 CPolygonPtr		CWorld::AddSquare(float size)
@@ -32,18 +28,7 @@ CPolygonPtr		CWorld::AddSquare(float size)
 
 CPolygonPtr		CWorld::AddSymetricPolygon(float radius, size_t sides)
 {
-	CPolygonPtr poly = AddPolygon();
-	float dAngle = 360.0f / (float)sides;
-	for (size_t i = 0; i < sides; ++i)
-	{
-		float angle = i * dAngle;
-
-		Vec2 point = Vec2(cosf(DEG2RAD(angle)), sinf(DEG2RAD(angle))) * radius;
-		poly->points.push_back(point);
-	}
-	poly->Build();
-
-	return poly;
+	return AddPolygon(m_shapeCache.GetSymetricPolygon(radius, sides));
 }
 
 CPolygonPtr		CWorld::AddRandomPoly(const SRandomPolyParams& params)
@@ -51,7 +36,7 @@ CPolygonPtr		CWorld::AddRandomPoly(const SRandomPolyParams& params)
 	size_t pointsCount = (size_t)Random(params.minPoints, params.maxPoints);
 	float radius = Random(params.minRadius, params.maxRadius);
 
-	CPolygonPtr poly = AddPolygon();
+	std::vector<Vec2> points;
 	float dAngle = 360.0f / (float)pointsCount;
 	for (size_t i = 0; i < pointsCount; ++i)
 	{
@@ -59,12 +44,13 @@ CPolygonPtr		CWorld::AddRandomPoly(const SRandomPolyParams& params)
 		float dist = radius;
 
 		Vec2 point = Vec2(cosf(DEG2RAD(angle)), sinf(DEG2RAD(angle))) * dist;
-		poly->points.push_back(point);
+		points.push_back(point);
 	}
 
-	poly->Build();
-	poly->rotation.SetAngle(Random(-180.0f, 180.0f));
-	poly->aabb->ApplyRotation(poly->points, poly->rotation);
+	CPolygonPtr poly = AddPolygon(CShape::Create(points));
+	Mat2 rotation;
+	rotation.SetAngle(Random(-180.0f, 180.0f));
+	poly->SetRotation(rotation);
 	poly->SetPosition(Vec2(Random(params.minBounds.x, params.maxBounds.x),
 		Random(params.minBounds.y, params.maxBounds.y)));
 	/*poly->position.x = Random(params.minBounds.x, params.maxBounds.x);
@@ -72,14 +58,22 @@ CPolygonPtr		CWorld::AddRandomPoly(const SRandomPolyParams& params)
 
 	Mat2 rot;
 	rot.SetAngle(Random(-180.0f, 180.0f));
-	poly->speed = rot.X * Random(params.minSpeed, params.maxSpeed);
+	poly->SetSpeed(rot.X * Random(params.minSpeed, params.maxSpeed));
 
 	return poly;
 }
 
+CPolygonPtr		CWorld::AddPolygon(const CShapePtr& shape)
+{
+	CPolygonPtr poly = AddPolygon();
+	poly->SetShape(shape);
+	return poly;
+}
+
 CPolygonPtr		CWorld::AddPolygon()
 {
-	CPolygonPtr poly( new CPolygon(m_polygons.size()) );
+	SBodyHandle handle = m_bodies.Add();
+	CPolygonPtr poly = new CPolygon(m_bodies, handle, m_polygons.size());
 	m_polygons.push_back(poly);
 	return poly;
 }
@@ -88,12 +82,16 @@ void	CWorld::RemovePolygon(CPolygonPtr poly)
 {
 	size_t index = poly->m_index;
 
-	if (index + 1 < m_polygons.size())
+	size_t movedIndex = m_bodies.Remove(poly->m_handle);
+	if (movedIndex != m_bodies.GetCount())
 	{
-		CPolygonPtr movedPoly = m_polygons[m_polygons.size() - 1];
+		CPolygonPtr movedPoly = m_polygons[movedIndex];
 		m_polygons[index] = movedPoly;
 		movedPoly->m_index = index;
 	}
+	m_polygons.pop_back();
+
+	delete poly;
 }
 
 void	CWorld::RemoveBehavior(CBehaviorPtr behavior)
@@ -101,16 +99,18 @@ void	CWorld::RemoveBehavior(CBehaviorPtr behavior)
 	if (behavior->poly)
 	{
 		RemovePolygon(behavior->poly);
+		behavior->poly = nullptr;
 	}
 
 	size_t index = behavior->m_index;
 
-	if (index + 1 < m_polygons.size())
+	if (index + 1 < m_behaviors.size())
 	{
 		CBehaviorPtr movedBhv = m_behaviors[m_behaviors.size() - 1];
 		m_behaviors[index] = movedBhv;
 		movedBhv->m_index = index;
 	}
+	m_behaviors.pop_back();
 }
 
 size_t	CWorld::GetPolygonCount() const
@@ -123,23 +123,44 @@ const std::vector<CPolygonPtr>& CWorld::GetPolygons()
 	return m_polygons;
 }
 
-CPolygonPtr& CWorld::GetPolygon(size_t index)
+CPolygonPtr CWorld::GetPolygon(size_t index)
 {
 	return m_polygons[index];
 }
 
+CPolygonPtr CWorld::GetPolygon(SBodyHandle handle)
+{
+	return m_bodies.IsValid(handle) ? m_polygons[m_bodies.GetIndex(handle)] : nullptr;
+}
+
+CBodyStore& CWorld::GetBodies()
+{
+	return m_bodies;
+}
+
+CShapeCache& CWorld::GetShapeCache()
+{
+	return m_shapeCache;
+}
+
 void	CWorld::Update(float frameTime)
 {
+	PROFILE_ZONE("World::Update");
 	for(CBehaviorPtr behavior : m_behaviors)
 	{
 		behavior->Update(frameTime);
 	}
 }
 
-void	CWorld::RenderPolygons()
+void	CWorld::SaveTransforms()
+{
+	m_bodies.SaveTransforms();
+}
+
+void	CWorld::RenderBehaviors(float alpha)
 {
-	for (CPolygonPtr polygon : m_polygons)
+	for (CBehaviorPtr behavior : m_behaviors)
 	{
-		polygon->Draw();
+		behavior->Render(alpha);
 	}
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <vector>
 
 #include "Polygon.h"
+#include "Shape.h"
 #include "Behavior.h"
 
 struct SRandomPolyParams
@@ -14,16 +15,21 @@ struct SRandomPolyParams
 	float	minSpeed, maxSpeed;
 };
 
+// Owns polygons, behaviors and the shapes cache. Polygon simulation state is stored densely in the body store,
+// m_polygons[i] is the polygon of dense body index i.
 class CWorld
 {
 public:
+	~CWorld();
+
 	CPolygonPtr		AddTriangle(float base, float height);
 	CPolygonPtr		AddRectangle(float width, float height);
 	CPolygonPtr		AddSquare(float size);
 	CPolygonPtr		AddSymetricPolygon(float radius, size_t sides);
 	CPolygonPtr		AddRandomPoly(const SRandomPolyParams& params);
 
-	CPolygonPtr		AddPolygon();
+	CPolygonPtr		AddPolygon(const CShapePtr& shape);
+	// Last polygon takes the removed one dense index, poly is deleted
 	void			RemovePolygon(CPolygonPtr poly);
 
 	template<class TBehavior>
@@ -48,7 +54,11 @@ public:
 	}
 	size_t						GetPolygonCount() const;
 	const std::vector<CPolygonPtr>& GetPolygons();
-	CPolygonPtr&					GetPolygon(size_t index);
+	CPolygonPtr						GetPolygon(size_t index);
+	// nullptr if the polygon was removed
+	CPolygonPtr						GetPolygon(SBodyHandle handle);
+	CBodyStore&						GetBodies();
+	CShapeCache&					GetShapeCache();
 
 	template<typename TFunctor>
 	void	ForEachBehavior(TFunctor functor)
@@ -60,11 +70,20 @@ public:
 	}
 
 	void Update(float frameTime);
-	void RenderPolygons();
+	void SaveTransforms();
+	void RenderBehaviors(float alpha);
+
+private:
+	friend class CWorldSnapshot;
+
+	// Without shape, it must be set before any use
+	CPolygonPtr		AddPolygon();
 
 protected:
+	CBodyStore					m_bodies;
 	std::vector<CPolygonPtr>	m_polygons;
 	std::vector<CBehaviorPtr>	m_behaviors;
+	CShapeCache					m_shapeCache;
 };
 
 #endif
\ No newline at end of file
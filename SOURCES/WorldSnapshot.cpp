@@ -0,0 +1,409 @@
+#include "WorldSnapshot.h"
+
+#include <fstream>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "Behavior.h"
+#include "FluidSystem.h"
+#include "GlobalVariables.h"
+#include "WarmStartCache.h"
+#include "World.h"
+
+// Sections are the in memory arrays : any change of these types needs a new WORLD_SNAPSHOT_VERSION
+static_assert(sizeof(Vec2) == 8 && sizeof(Mat2) == 16 && sizeof(Line) == 20 && sizeof(CAABB) == 28, "snapshot layout changed");
+static_assert(sizeof(SSnapshotMaterial) == 16 && sizeof(SSnapshotShape) == 48 && sizeof(SSnapshotCache) == 16 && sizeof(SSnapshotContact) == 16,
+	"snapshot layout changed");
+static_assert(sizeof(SShapeKey) == 16, "snapshot layout changed");
+static_assert(std::is_trivially_copyable<CAABB>::value && std::is_trivially_copyable<Line>::value, "snapshot sections must be raw copyable");
+
+static const size_t gSnapshotElementSizes[] =
+{
+	sizeof(Vec2), sizeof(Mat2), sizeof(Vec2), sizeof(Mat2), sizeof(CAABB), sizeof(Vec2), sizeof(float), sizeof(float), sizeof(float),
+	8, sizeof(uint32_t), sizeof(uint32_t),
+	sizeof(SSnapshotMaterial), sizeof(SSnapshotShape), sizeof(Vec2), sizeof(Line),
+	sizeof(SSnapshotCache), sizeof(SSnapshotContact),
+	sizeof(Vec2), sizeof(Vec2), sizeof(Vec2), sizeof(Vec2), sizeof(uint8_t),
+};
+static_assert(sizeof(gSnapshotElementSizes) / sizeof(gSnapshotElementSizes[0]) == (size_t)ESnapshotSection::Count, "missing section element size");
+
+static inline uint64_t AlignSnapshotOffset(uint64_t offset)
+{
+	return (offset + WORLD_SNAPSHOT_ALIGNMENT - 1) & ~(uint64_t)(WORLD_SNAPSHOT_ALIGNMENT - 1);
+}
+
+struct SSectionSource
+{
+	const void*	data;
+	size_t		size;
+};
+
+template<typename T>
+static inline SSectionSource MakeSectionSource(const std::vector<T>& values)
+{
+	return { values.data(), values.size() * sizeof(T) };
+}
+
+bool CWorldSnapshot::Save(const std::string& path, uint32_t sceneIndex)
+{
+	CWorld* world = gVars->pWorld;
+	if (world == nullptr)
+		return false;
+
+	CBodyStore& bodies = world->GetBodies();
+	static_assert(sizeof(CBodyStore::SSlot) == 8, "snapshot layout changed");
+	if (!bodies.IsFinite() || !CFluidSystem::Get().IsFinite())
+		return false; // diverged simulation, resuming from it is meaningless
+
+	std::unordered_map<const CShape*, SShapeKey> shapeKeys;
+	world->GetShapeCache().ForEachShape([&](const SShapeKey& key, const CShapePtr& shape)
+	{
+		shapeKeys[shape.get()] = key;
+	});
+
+	// shapes in order of first use
+	std::unordered_map<const CShape*, uint32_t> shapeIndices;
+	std::vector<SSnapshotMaterial> materials;
+	std::vector<SSnapshotShape> shapes;
+	std::vector<Vec2> points;
+	std::vector<Line> lines;
+	materials.reserve(world->GetPolygonCount());
+	for (CPolygonPtr poly : world->GetPolygons())
+	{
+		const CShape& shape = *poly->GetShape();
+		auto inserted = shapeIndices.emplace(&shape, (uint32_t)shapes.size());
+		if (inserted.second)
+		{
+			auto key = shapeKeys.find(&shape);
+			shapes.push_back({ (uint32_t)points.size(), (uint32_t)shape.GetPoints().size(), shape.GetCentroid(), shape.GetSignedArea(),
+				shape.GetLocalInertiaTensor(), shape.GetBoundingRadius(), 0,
+				(key != shapeKeys.end()) ? key->second : SShapeKey{ EShapeType::Custom, 0.0f, 0.0f, 0 } });
+			points.insert(points.end(), shape.GetPoints().begin(), shape.GetPoints().end());
+			lines.insert(lines.end(), shape.GetLines().begin(), shape.GetLines().end());
+		}
+		materials.push_back({ inserted.first->second, poly->bounciness, poly->friction, poly->m_density });
+	}
+
+	std::vector<SSnapshotCache> caches;
+	std::vector<SSnapshotContact> contacts;
+	uint32_t behaviorIndex = 0;
+	world->ForEachBehavior([&](CBehaviorPtr behavior)
+	{
+		if (CWarmStartCache* cache = behavior->GetWarmStartCache())
+		{
+			SSnapshotCache record = { behaviorIndex, (uint32_t)contacts.size(), 0, 0 };
+			cache->ForEachEntry([&](uint64_t key, float normalImpulse, float tangentImpulse)
+			{
+				contacts.push_back({ key, normalImpulse, tangentImpulse });
+			});
+			record.contactCount = (uint32_t)contacts.size() - record.firstContact;
+			caches.push_back(record);
+		}
+		++behaviorIndex;
+	});
+
+	const CFluidSystem& fluid = CFluidSystem::Get();
+
+	// same order as ESnapshotSection
+	const SSectionSource sources[] =
+	{
+		MakeSectionSource(bodies.positions),
+		MakeSectionSource(bodies.rotations),
+		MakeSectionSource(bodies.previousPositions),
+		MakeSectionSource(bodies.previousRotations),
+		MakeSectionSource(bodies.bounds),
+		MakeSectionSource(bodies.speeds),
+		MakeSectionSource(bodies.angularVelocities),
+		MakeSectionSource(bodies.masses),
+		MakeSectionSource(bodies.inertias),
+		MakeSectionSource(bodies.m_slots),
+		MakeSectionSource(bodies.m_freeSlots),
+		MakeSectionSource(bodies.m_denseToSlot),
+		MakeSectionSource(materials),
+		MakeSectionSource(shapes),
+		MakeSectionSource(points),
+		MakeSectionSource(lines),
+		MakeSectionSource(caches),
+		MakeSectionSource(contacts),
+		MakeSectionSource(fluid.m_positions),
+		MakeSectionSource(fluid.m_previousPositions),
+		MakeSectionSource(fluid.m_velocities),
+		MakeSectionSource(fluid.m_accelerations),
+		MakeSectionSource(fluid.m_killed),
+	};
+	static_assert(sizeof(sources) / sizeof(sources[0]) == (size_t)ESnapshotSection::Count, "missing section source");
+
+	SSnapshotHeader header = {};
+	header.magic = WORLD_SNAPSHOT_MAGIC;
+	header.version = WORLD_SNAPSHOT_VERSION;
+	header.sceneIndex = sceneIndex;
+	header.fluidSolver = (uint32_t)fluid.m_solver;
+	header.fluidFramesSinceReorder = (uint32_t)fluid.m_framesSinceReorder;
+	header.randomState = GetRandomState();
+
+	uint64_t offset = AlignSnapshotOffset(sizeof(SSnapshotHeader));
+	for (size_t section = 0; section < (size_t)ESnapshotSection::Count; ++section)
+	{
+		header.sections[section].offset = offset;
+		header.sections[section].size = sources[section].size;
+		offset = AlignSnapshotOffset(offset + sources[section].size);
+	}
+	header.fileSize = offset;
+
+	std::ofstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+
+	static const char padding[WORLD_SNAPSHOT_ALIGNMENT] = {};
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	uint64_t written = sizeof(header);
+	for (size_t section = 0; section <= (size_t)ESnapshotSection::Count; ++section)
+	{
+		uint64_t sectionOffset = (section < (size_t)ESnapshotSection::Count) ? header.sections[section].offset : header.fileSize;
+		file.write(padding, (std::streamsize)(sectionOffset - written));
+		if (section < (size_t)ESnapshotSection::Count)
+		{
+			file.write(static_cast<const char*>(sources[section].data), (std::streamsize)sources[section].size);
+			written = sectionOffset + sources[section].size;
+		}
+	}
+	return (bool)file;
+}
+
+template<typename T>
+const T* CWorldSnapshot::GetSection(ESnapshotSection section, size_t& outCount) const
+{
+	const SSnapshotSection& range = m_header->sections[(size_t)section];
+	outCount = (size_t)(range.size / sizeof(T));
+	return reinterpret_cast<const T*>(static_cast<const uint8_t*>(m_file.GetData()) + range.offset);
+}
+
+size_t CWorldSnapshot::GetBodyCount() const
+{
+	return (size_t)(m_header->sections[(size_t)ESnapshotSection::Positions].size / sizeof(Vec2));
+}
+
+bool CWorldSnapshot::Open(const std::string& path)
+{
+	Close();
+	if (!m_file.Open(path) || m_file.GetSize() < sizeof(SSnapshotHeader))
+	{
+		Close();
+		return false;
+	}
+
+	// magic read on a big endian host doesn't match either
+	m_header = static_cast<const SSnapshotHeader*>(m_file.GetData());
+	bool valid = m_header->magic == WORLD_SNAPSHOT_MAGIC && m_header->version == WORLD_SNAPSHOT_VERSION
+		&& m_header->fileSize == m_file.GetSize() && m_header->fluidSolver < (uint32_t)EFluidSolver::Count;
+
+	for (size_t section = 0; valid && section < (size_t)ESnapshotSection::Count; ++section)
+	{
+		const SSnapshotSection& range = m_header->sections[section];
+		valid = (range.offset % WORLD_SNAPSHOT_ALIGNMENT) == 0 && range.offset <= m_header->fileSize
+			&& range.size <= m_header->fileSize - range.offset && (range.size % gSnapshotElementSizes[section]) == 0;
+	}
+
+	// array lengths
+	auto GetCount = [&](ESnapshotSection section)
+	{
+		return (size_t)(m_header->sections[(size_t)section].size / gSnapshotElementSizes[(size_t)section]);
+	};
+	if (valid)
+	{
+		size_t bodyCount = GetBodyCount();
+		for (ESnapshotSection section : { ESnapshotSection::Rotations, ESnapshotSection::PreviousPositions, ESnapshotSection::PreviousRotations,
+			ESnapshotSection::Bounds, ESnapshotSection::Speeds, ESnapshotSection::AngularVelocities, ESnapshotSection::Masses,
+			ESnapshotSection::Inertias, ESnapshotSection::DenseToSlot, ESnapshotSection::Materials })
+		{
+			valid &= GetCount(section) == bodyCount;
+		}
+		valid &= GetCount(ESnapshotSection::Lines) == GetCount(ESnapshotSection::Points);
+
+		size_t particleCount = GetCount(ESnapshotSection::ParticlePositions);
+		for (ESnapshotSection section : { ESnapshotSection::ParticlePreviousPositions, ESnapshotSection::ParticleVelocities,
+			ESnapshotSection::ParticleAccelerations, ESnapshotSection::ParticleKilled })
+		{
+			valid &= GetCount(section) == particleCount;
+		}
+	}
+
+	// ranges and handle tables
+	if (valid)
+	{
+		size_t count, shapeCount, pointCount, slotCount, contactCount;
+		const SSnapshotShape* shapes = GetSection<SSnapshotShape>(ESnapshotSection::Shapes, shapeCount);
+		GetSection<Vec2>(ESnapshotSection::Points, pointCount);
+		for (size_t i = 0; valid && i < shapeCount; ++i)
+		{
+			valid = shapes[i].firstPoint <= pointCount && shapes[i].pointCount <= pointCount - shapes[i].firstPoint && shapes[i].pointCount >= 3;
+		}
+		const SSnapshotMaterial* materials = GetSection<SSnapshotMaterial>(ESnapshotSection::Materials, count);
+		for (size_t i = 0; valid && i < count; ++i)
+		{
+			valid = materials[i].shapeIndex < shapeCount;
+		}
+
+		const CBodyStore::SSlot* slots = GetSection<CBodyStore::SSlot>(ESnapshotSection::Slots, slotCount);
+		const uint32_t* denseToSlot = GetSection<uint32_t>(ESnapshotSection::DenseToSlot, count);
+		valid &= slotCount <= BODY_MAX_COUNT;
+		for (size_t i = 0; valid && i < count; ++i)
+		{
+			valid = denseToSlot[i] < slotCount && slots[denseToSlot[i]].index == i;
+		}
+		const uint32_t* freeSlots = GetSection<uint32_t>(ESnapshotSection::FreeSlots, count);
+		for (size_t i = 0; valid && i < count; ++i)
+		{
+			valid = freeSlots[i] < slotCount;
+		}
+
+		const SSnapshotCache* caches = GetSection<SSnapshotCache>(ESnapshotSection::Caches, count);
+		GetSection<SSnapshotContact>(ESnapshotSection::Contacts, contactCount);
+		for (size_t i = 0; valid && i < count; ++i)
+		{
+			valid = caches[i].firstContact <= contactCount && caches[i].contactCount <= contactCount - caches[i].firstContact;
+		}
+	}
+
+	if (!valid)
+	{
+		Close();
+	}
+	return valid;
+}
+
+void CWorldSnapshot::Close()
+{
+	m_file.Close();
+	m_header = nullptr;
+}
+
+template<typename T>
+void CWorldSnapshot::AssignSection(std::vector<T>& values, ESnapshotSection section) const
+{
+	size_t count;
+	const T* data = GetSection<T>(section, count);
+	values.assign(data, data + count);
+}
+
+void CWorldSnapshot::Restore(CWorld& world) const
+{
+	size_t bodyCount = GetBodyCount();
+
+	// extra polygons are removed from the end so others keep their dense index
+	while (world.GetPolygonCount() > bodyCount)
+	{
+		world.RemovePolygon(world.GetPolygon(world.GetPolygonCount() - 1));
+	}
+	while (world.GetPolygonCount() < bodyCount)
+	{
+		world.AddPolygon();
+	}
+
+	size_t count;
+	CBodyStore& bodies = world.GetBodies();
+	AssignSection(bodies.positions, ESnapshotSection::Positions);
+	AssignSection(bodies.rotations, ESnapshotSection::Rotations);
+	AssignSection(bodies.previousPositions, ESnapshotSection::PreviousPositions);
+	AssignSection(bodies.previousRotations, ESnapshotSection::PreviousRotations);
+	AssignSection(bodies.bounds, ESnapshotSection::Bounds);
+	AssignSection(bodies.speeds, ESnapshotSection::Speeds);
+	AssignSection(bodies.angularVelocities, ESnapshotSection::AngularVelocities);
+	AssignSection(bodies.masses, ESnapshotSection::Masses);
+	AssignSection(bodies.inertias, ESnapshotSection::Inertias);
+	AssignSection(bodies.m_slots, ESnapshotSection::Slots);
+	AssignSection(bodies.m_freeSlots, ESnapshotSection::FreeSlots);
+	AssignSection(bodies.m_denseToSlot, ESnapshotSection::DenseToSlot);
+	bodies.m_unsaved.assign(bodies.GetCount(), 0);
+
+	size_t shapeCount;
+	const SSnapshotShape* shapes = GetSection<SSnapshotShape>(ESnapshotSection::Shapes, shapeCount);
+	const Vec2* points = GetSection<Vec2>(ESnapshotSection::Points, count);
+	const Line* lines = GetSection<Line>(ESnapshotSection::Lines, count);
+	std::vector<CShapePtr> restoredShapes;
+	restoredShapes.reserve(shapeCount);
+	for (size_t i = 0; i < shapeCount; ++i)
+	{
+		const SSnapshotShape& record = shapes[i];
+		std::shared_ptr<CShape> shape(new CShape());
+		shape->m_points.assign(points + record.firstPoint, points + record.firstPoint + record.pointCount);
+		shape->m_lines.assign(lines + record.firstPoint, lines + record.firstPoint + record.pointCount);
+		shape->m_centroid = record.centroid;
+		shape->m_signedArea = record.signedArea;
+		shape->m_localInertiaTensor = record.localInertiaTensor;
+		shape->m_boundingRadius = record.boundingRadius;
+		restoredShapes.push_back(shape);
+
+		if (record.key.type != EShapeType::Custom)
+		{
+			world.GetShapeCache().Add(record.key, shape);
+		}
+	}
+
+	const SSnapshotMaterial* materials = GetSection<SSnapshotMaterial>(ESnapshotSection::Materials, count);
+	for (size_t i = 0; i < bodyCount; ++i)
+	{
+		const SSnapshotMaterial& material = materials[i];
+		CPolygonPtr poly = world.GetPolygon(i);
+		poly->m_handle = bodies.GetHandle(i);
+		poly->m_index = i;
+		poly->m_shape = restoredShapes[material.shapeIndex];
+		poly->bounciness = material.bounciness;
+		poly->friction = material.friction;
+		poly->m_density = material.density;
+		poly->isOverlaping = false;
+	}
+
+	// caches are in behavior order, behaviors without a stored cache start empty
+	size_t cacheCount;
+	const SSnapshotCache* caches = GetSection<SSnapshotCache>(ESnapshotSection::Caches, cacheCount);
+	const SSnapshotContact* contacts = GetSection<SSnapshotContact>(ESnapshotSection::Contacts, count);
+	size_t cacheIndex = 0;
+	uint32_t behaviorIndex = 0;
+	world.ForEachBehavior([&](CBehaviorPtr behavior)
+	{
+		CWarmStartCache* cache = behavior->GetWarmStartCache();
+		while (cacheIndex < cacheCount && caches[cacheIndex].behaviorIndex < behaviorIndex)
+		{
+			++cacheIndex;
+		}
+		if (cache)
+		{
+			cache->Clear();
+			if (cacheIndex < cacheCount && caches[cacheIndex].behaviorIndex == behaviorIndex)
+			{
+				const SSnapshotCache& record = caches[cacheIndex];
+				for (size_t i = record.firstContact; i < record.firstContact + record.contactCount; ++i)
+				{
+					cache->Store(contacts[i].key, contacts[i].normalImpulse, contacts[i].tangentImpulse);
+				}
+			}
+		}
+		++behaviorIndex;
+	});
+
+	CFluidSystem& fluid = CFluidSystem::Get();
+	size_t particleCount;
+	GetSection<Vec2>(ESnapshotSection::ParticlePositions, particleCount);
+	if (particleCount > fluid.m_capacity)
+	{
+		fluid.SetCapacity(particleCount);
+	}
+	AssignSection(fluid.m_positions, ESnapshotSection::ParticlePositions);
+	AssignSection(fluid.m_previousPositions, ESnapshotSection::ParticlePreviousPositions);
+	AssignSection(fluid.m_velocities, ESnapshotSection::ParticleVelocities);
+	AssignSection(fluid.m_accelerations, ESnapshotSection::ParticleAccelerations);
+	AssignSection(fluid.m_killed, ESnapshotSection::ParticleKilled);
+	fluid.ResizeParticles(particleCount);
+
+	fluid.m_killedCount = 0;
+	for (uint8_t killed : fluid.m_killed)
+	{
+		fluid.m_killedCount += (size_t)(killed != 0);
+	}
+	fluid.m_framesSinceReorder = m_header->fluidFramesSinceReorder;
+	fluid.m_solver = (EFluidSolver)m_header->fluidSolver;
+
+	SetRandomSeed(m_header->randomState);
+}
@@ -4,19 +4,13 @@
 #pragma comment(lib, "legacy_stdio_definitions.lib")
 #include "stdafx.h"
 
+#include <cstdlib>
 #include <iostream>
 #include <string>
 
 #include "Application.h"
-#include "SceneManager.h"
-
-#include "Scenes/SceneDebugCollisions.h"
-#include "Scenes/SceneBouncingPolys.h"
-#include "Scenes/SceneSimplePhysic.h"
-#include "Scenes/SceneSpheres.h"
-#include "Scenes/SceneComplexPhysic.h"
-#include "Scenes/SceneSmallPhysic.h"
-#include "SceneFluid.h"
+#include "SceneList.h"
+#include "FluidBenchmark.h"
 
 extern "C" { FILE __iob_func[3] = { *stdin,*stdout,*stderr }; }
 /*
@@ -24,16 +18,29 @@ extern "C" { FILE __iob_func[3] = { *stdin,*stdout,*stderr }; }
 */
 int _tmain(int argc, char** argv)
 {
+	// headless fluid benchmark : CollisionEngine.exe -fluidbench [frameCount] [sph|pbf] [exact|tabulated]
+	if (argc > 1 && std::string(argv[1]) == "-fluidbench")
+	{
+		char* end = nullptr;
+		long frameCount = (argc > 2) ? std::strtol(argv[2], &end, 10) : 60;
+		bool valid = frameCount >= 0 && (end == nullptr || (end != argv[2] && *end == '\0'));
+		EFluidSolver solver = EFluidSolver::SPH;
+		EKernelEvaluation evaluation = EKernelEvaluation::Exact;
+		for (int i = 3; valid && i < argc; ++i)
+		{
+			valid = ParseFluidBenchmarkOption(argv[i], solver, evaluation);
+		}
+		if (!valid)
+		{
+			std::cerr << "Usage : CollisionEngine.exe -fluidbench [frameCount] [sph|pbf] [exact|tabulated]" << std::endl;
+			return 1;
+		}
+		return RunFluidBenchmark((size_t)frameCount, solver, evaluation);
+	}
+
 	InitApplication(1260, 768, 50.0f);
 
-	gVars->pSceneManager->AddScene(new CSceneDebugCollisions());
-	gVars->pSceneManager->AddScene(new CSceneBouncingPolys(2, Vec2(5.0f, 10.0f)));
-	gVars->pSceneManager->AddScene(new CSceneBouncingPolys(200));
-	gVars->pSceneManager->AddScene(new CSceneSpheres());
-	gVars->pSceneManager->AddScene(new CSceneSmallPhysic());
-	gVars->pSceneManager->AddScene(new CSceneSimplePhysic());
-	gVars->pSceneManager->AddScene(new CSceneComplexPhysic(25));
-	//gVars->pSceneManager->AddScene(new CSceneFluid());
+	AddAllScenes(gVars->pSceneManager);
 
 	RunApplication();
 	return 0;